@@ -0,0 +1,80 @@
+// Хостовый замер анализаторов разных конфигураций, работающих одновременно
+// над одним сигналом: стоимость цикла анализа и средний пик полос.
+// Отсчёты АЦП записаны заранее, поэтому захват не ждёт часов АЦП.
+// Такт хостового счётчика — одна наносекунда реального времени; на x86
+// double считается аппаратно, поэтому выигрыш float здесь меньше, чем на ESP32.
+
+#include <Arduino.h>
+#include "audio_analyzer.hpp"
+
+constexpr uint32_t BENCH_CYCLES = 5000;
+
+// Тон 440 Гц и 2.5 кГц с огибающей 2 Гц и шумом
+static uint16_t benchAdcSource(uint8_t) {
+    float t = HostClock::now() / 1e6f;
+    float envelope = 0.5f + 0.5f * sinf(2.0f * PI * 2.0f * t);
+    float tone = (sinf(2.0f * PI * 440.0f * t) + 0.5f * sinf(2.0f * PI * 2500.0f * t)) * envelope * 40.0f;
+    return (uint16_t)(2048 + tone + random(-8, 9));
+}
+
+// АЦП читается один раз, анализаторы берут отсчёты по кругу.
+// Каналы идут по одной записи, каждый со своей позиции (источник в центре)
+static uint16_t capturedSamples[4096];
+static uint32_t capturedIndex[2] = {};
+
+static uint16_t replaySample(void*, uint8_t channel) {
+    uint32_t& index = capturedIndex[channel];
+    uint16_t sample = capturedSamples[index];
+    index = (index + 1) % (sizeof(capturedSamples) / sizeof(capturedSamples[0]));
+    return sample;
+}
+
+struct BenchResult {
+    uint64_t cycles = 0;
+    uint64_t peakSum = 0;
+};
+
+template <typename Analyzer>
+static void runCycle(Analyzer& analyzer, BenchResult& result) {
+    uint32_t start = ESP.getCycleCount();
+    analyzer.processAudio();
+    result.cycles += ESP.getCycleCount() - start;
+    result.peakSum += analyzer.getFrame().peakLevel;
+}
+
+template <typename Analyzer>
+static void report(const char* name, const BenchResult& result) {
+    Serial.printf("[AnalysisBench] %-14s FFT %4u x %2u bands %6u ns/cycle, mean peak %u\n", name,
+                  Analyzer::FFT_SIZE, Analyzer::BAND_COUNT, (uint32_t)(result.cycles / BENCH_CYCLES),
+                  (uint32_t)(result.peakSum / BENCH_CYCLES));
+}
+
+int main() {
+    hostSetAdcSource(benchAdcSource);
+    for (uint16_t& sample : capturedSamples) {
+        sample = analogRead(MIC_PIN);
+    }
+
+    static AudioAnalyzer<SAMPLES, MATRIX_WIDTH, double> matrixDouble;
+    static AudioAnalyzer<SAMPLES, MATRIX_WIDTH, float> matrixFloat;
+    static CoarseAnalyzer coarse;
+    static FineAnalyzer fine;
+    matrixDouble.setSampleReader(replaySample);
+    matrixFloat.setSampleReader(replaySample);
+    coarse.setSampleReader(replaySample);
+    fine.setSampleReader(replaySample);
+
+    BenchResult results[4];
+    Serial.printf("[AnalysisBench] %u cycles per analyzer, interleaved\n", BENCH_CYCLES);
+    for (uint32_t i = 0; i < BENCH_CYCLES; i++) {
+        runCycle(matrixDouble, results[0]);
+        runCycle(matrixFloat, results[1]);
+        runCycle(coarse, results[2]);
+        runCycle(fine, results[3]);
+    }
+    report<decltype(matrixDouble)>("Matrix double", results[0]);
+    report<decltype(matrixFloat)>("Matrix float", results[1]);
+    report<CoarseAnalyzer>("Coarse float", results[2]);
+    report<FineAnalyzer>("Fine float", results[3]);
+    return 0;
+}
@@ -0,0 +1,287 @@
+// Сборка образа раздела клипов из файлов кадров .lmf (host/offline_render).
+// Кадры переводятся в порядок ленты и сжимаются дельтами с RLE,
+// каждый keyframeInterval-й кадр — ключевой. Готовый образ проверяется
+// тем же ClipStorage/ClipReader, что на устройстве, через mmap файла.
+//
+// clip_encoder [-o clips.bin] [-k интервал ключевых] [-i мс на кадр] [имя=]файл.lmf...
+// Запись в раздел: esptool.py write_flash <смещение clips из partitions.csv> clips.bin
+
+#include <Arduino.h>
+#include "led_matrix.hpp"
+#include "clip_storage.hpp"
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+constexpr uint16_t DEFAULT_KEYFRAME_INTERVAL = 50; // Секунда при 50 FPS
+
+struct SourceClip {
+    std::string name;
+    uint16_t frameIntervalMs = 0;
+    std::vector<CRGB> frames; // frameCount * NUM_LEDS в порядке ленты
+    uint32_t frameCount() const { return frames.size() / NUM_LEDS; }
+};
+
+static LedMatrix layout; // Только для XY(): раскладка та же, что на устройстве
+
+static uint32_t readLe32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool loadFrames(const char* path, SourceClip& clip) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "[ClipEncoder] Cannot open %s\n", path);
+        return false;
+    }
+    uint8_t header[16];
+    if (fread(header, 1, sizeof(header), file) != sizeof(header) || memcmp(header, "LMF1", 4) != 0) {
+        fprintf(stderr, "[ClipEncoder] %s is not an LMF1 frame file\n", path);
+        fclose(file);
+        return false;
+    }
+    if (header[4] != MATRIX_WIDTH || header[5] != MATRIX_HEIGHT) {
+        fprintf(stderr, "[ClipEncoder] %s is %ux%u, matrix is %ux%u\n", path, header[4], header[5],
+                MATRIX_WIDTH, MATRIX_HEIGHT);
+        fclose(file);
+        return false;
+    }
+
+    uint32_t count = readLe32(header + 8);
+    uint32_t firstMs = 0, lastMs = 0;
+    uint8_t record[4 + NUM_LEDS * 3];
+    clip.frames.resize((size_t)count * NUM_LEDS);
+    for (uint32_t f = 0; f < count; f++) {
+        if (fread(record, 1, sizeof(record), file) != sizeof(record)) {
+            fprintf(stderr, "[ClipEncoder] %s: truncated at frame %u\n", path, f);
+            fclose(file);
+            return false;
+        }
+        uint32_t timeMs = readLe32(record);
+        if (f == 0) {
+            firstMs = timeMs;
+        }
+        lastMs = timeMs;
+        // В файле кадр построчно, в клипе — в порядке ленты
+        const uint8_t* pixel = record + 4;
+        for (int y = 0; y < MATRIX_HEIGHT; y++) {
+            for (int x = 0; x < MATRIX_WIDTH; x++, pixel += 3) {
+                clip.frames[(size_t)f * NUM_LEDS + layout.XY(x, y)] = CRGB(pixel[0], pixel[1], pixel[2]);
+            }
+        }
+    }
+    fclose(file);
+    if (count == 0) {
+        fprintf(stderr, "[ClipEncoder] %s has no frames\n", path);
+        return false;
+    }
+    if (!clip.frameIntervalMs) {
+        clip.frameIntervalMs = count > 1 ? std::max<uint32_t>(1, (lastMs - firstMs + (count - 1) / 2) / (count - 1))
+                                         : UPDATE_INTERVAL;
+    }
+    return true;
+}
+
+// Поток операций одного кадра; prev == nullptr — ключевой кадр без пропусков
+static void encodeFrame(const CRGB* frame, const CRGB* prev, std::vector<uint8_t>& out) {
+    int i = 0;
+    while (i < NUM_LEDS) {
+        int limit = std::min(NUM_LEDS - i, (int)CLIP_OP_MAX_LENGTH);
+        int length = 1;
+        if (prev && frame[i] == prev[i]) {
+            while (length < limit && frame[i + length] == prev[i + length]) length++;
+            out.push_back(CLIP_OP_SKIP | (length - 1));
+        } else {
+            while (length < limit && frame[i + length] == frame[i]) length++;
+            if (length >= 2) {
+                out.push_back(CLIP_OP_RUN | (length - 1));
+                out.insert(out.end(), frame[i].raw, frame[i].raw + 3);
+            } else {
+                // Литерал до неизменного пикселя или начала серии
+                while (length < limit && !(prev && frame[i + length] == prev[i + length]) &&
+                       !(i + length + 1 < NUM_LEDS && frame[i + length] == frame[i + length + 1])) {
+                    length++;
+                }
+                out.push_back(CLIP_OP_LITERAL | (length - 1));
+                out.insert(out.end(), frame[i].raw, frame[i].raw + 3 * length);
+            }
+        }
+        i += length;
+    }
+}
+
+static void appendLe(std::vector<uint8_t>& out, const void* value, size_t size) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(value);
+    out.insert(out.end(), bytes, bytes + size);
+}
+
+static std::vector<uint8_t> encodeClip(const SourceClip& clip, uint16_t keyframeInterval) {
+    ClipHeader header = {};
+    memcpy(header.magic, CLIP_MAGIC, sizeof(header.magic));
+    header.width = MATRIX_WIDTH;
+    header.height = MATRIX_HEIGHT;
+    header.frameIntervalMs = clip.frameIntervalMs;
+    header.frameCount = clip.frameCount();
+    header.keyframeInterval = keyframeInterval;
+    header.keyframeCount = (header.frameCount + keyframeInterval - 1) / keyframeInterval;
+
+    std::vector<uint8_t> frames;
+    std::vector<uint32_t> index;
+    const size_t dataStart = sizeof(header) + header.keyframeCount * 4;
+    std::vector<uint8_t> key, delta;
+    for (uint32_t f = 0; f < header.frameCount; f++) {
+        const CRGB* frame = &clip.frames[(size_t)f * NUM_LEDS];
+        key.clear();
+        encodeFrame(frame, nullptr, key);
+        if (f % keyframeInterval == 0) {
+            index.push_back(dataStart + frames.size());
+            frames.insert(frames.end(), key.begin(), key.end());
+            continue;
+        }
+        // Ключевое кодирование — тоже допустимая дельта; берём короче
+        delta.clear();
+        encodeFrame(frame, frame - NUM_LEDS, delta);
+        const std::vector<uint8_t>& best = delta.size() < key.size() ? delta : key;
+        frames.insert(frames.end(), best.begin(), best.end());
+    }
+
+    std::vector<uint8_t> out;
+    appendLe(out, &header, sizeof(header));
+    for (uint32_t offset : index) {
+        appendLe(out, &offset, sizeof(offset));
+    }
+    out.insert(out.end(), frames.begin(), frames.end());
+    return out;
+}
+
+// Проверка образа тем же кодом, что на устройстве: раздел — mmap файла
+static bool verifyImage(const char* path, const std::vector<SourceClip>& clips) {
+    hostSetPartitionFile(CLIP_PARTITION_LABEL, path);
+    ClipStorage storage;
+    if (!storage.begin()) {
+        return false;
+    }
+    static CRGB canvas[NUM_LEDS];
+    bool ok = true;
+    for (const SourceClip& source : clips) {
+        ClipReader reader;
+        if (!storage.getDirectory().openClip(source.name.c_str(), reader)) {
+            return false;
+        }
+        // Последовательно, как при воспроизведении
+        uint32_t cycles = 0;
+        for (uint32_t f = 0; f < source.frameCount(); f++) {
+            uint32_t start = ESP.getCycleCount();
+            bool decoded = reader.decodeNext(canvas);
+            cycles += ESP.getCycleCount() - start;
+            if (!decoded || memcmp(canvas, &source.frames[(size_t)f * NUM_LEDS], sizeof(canvas)) != 0) {
+                fprintf(stderr, "[ClipEncoder] %s: frame %u mismatch\n", source.name.c_str(), f);
+                ok = false;
+                break;
+            }
+        }
+        // Произвольный доступ через индекс ключевых кадров
+        for (int i = 0; ok && i < 32; i++) {
+            uint32_t f = random(source.frameCount());
+            if (!reader.seek(f, canvas) || memcmp(canvas, &source.frames[(size_t)f * NUM_LEDS], sizeof(canvas)) != 0) {
+                fprintf(stderr, "[ClipEncoder] %s: seek to %u mismatch\n", source.name.c_str(), f);
+                ok = false;
+            }
+        }
+        if (ok) {
+            printf("[ClipEncoder]   %-15s decode %u cycles/frame\n", source.name.c_str(),
+                   cycles / source.frameCount());
+        }
+    }
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    const char* outputPath = "clips.bin";
+    uint16_t keyframeInterval = DEFAULT_KEYFRAME_INTERVAL;
+    uint16_t frameIntervalMs = 0;
+    int opt;
+    while ((opt = getopt(argc, argv, "o:k:i:h")) != -1) {
+        switch (opt) {
+            case 'o': outputPath = optarg; break;
+            case 'k': keyframeInterval = (uint16_t)std::max(1, atoi(optarg)); break;
+            case 'i': frameIntervalMs = (uint16_t)std::max(1, atoi(optarg)); break;
+            default:
+                fprintf(stderr, "usage: clip_encoder [-o clips.bin] [-k keyframe interval] [-i ms per frame] "
+                                "[name=]file.lmf...\n");
+                return 2;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "[ClipEncoder] No input files\n");
+        return 2;
+    }
+
+    std::vector<SourceClip> clips;
+    for (int i = optind; i < argc; i++) {
+        std::string arg = argv[i];
+        SourceClip clip;
+        size_t eq = arg.find('=');
+        std::string path = eq == std::string::npos ? arg : arg.substr(eq + 1);
+        if (eq != std::string::npos) {
+            clip.name = arg.substr(0, eq);
+        } else {
+            size_t slash = path.find_last_of('/');
+            clip.name = path.substr(slash == std::string::npos ? 0 : slash + 1);
+            clip.name = clip.name.substr(0, clip.name.find_last_of('.'));
+        }
+        if (clip.name.empty() || clip.name.size() >= CLIP_NAME_LENGTH) {
+            fprintf(stderr, "[ClipEncoder] Clip name '%s' must be 1..%d characters\n", clip.name.c_str(),
+                    CLIP_NAME_LENGTH - 1);
+            return 1;
+        }
+        clip.frameIntervalMs = frameIntervalMs;
+        if (!loadFrames(path.c_str(), clip)) {
+            return 1;
+        }
+        clips.push_back(std::move(clip));
+    }
+
+    // Образ: заголовок, каталог, клипы
+    std::vector<uint8_t> image;
+    ClipImageHeader imageHeader = {};
+    memcpy(imageHeader.magic, CLIP_IMAGE_MAGIC, sizeof(imageHeader.magic));
+    imageHeader.version = CLIP_FORMAT_VERSION;
+    imageHeader.clipCount = clips.size();
+    appendLe(image, &imageHeader, sizeof(imageHeader));
+    image.resize(sizeof(imageHeader) + clips.size() * sizeof(ClipDirectoryEntry));
+
+    printf("[ClipEncoder] %zu clips, keyframe every %u frames\n", clips.size(), keyframeInterval);
+    for (size_t i = 0; i < clips.size(); i++) {
+        std::vector<uint8_t> encoded = encodeClip(clips[i], keyframeInterval);
+        ClipDirectoryEntry entry = {};
+        snprintf(entry.name, sizeof(entry.name), "%s", clips[i].name.c_str());
+        entry.offset = image.size();
+        entry.size = encoded.size();
+        memcpy(&image[sizeof(imageHeader) + i * sizeof(entry)], &entry, sizeof(entry));
+        image.insert(image.end(), encoded.begin(), encoded.end());
+
+        size_t raw = (size_t)clips[i].frameCount() * NUM_LEDS * 3;
+        printf("[ClipEncoder]   %-15s %6u frames @ %u ms, %7zu -> %7zu bytes (%.1fx)\n", clips[i].name.c_str(),
+               clips[i].frameCount(), clips[i].frameIntervalMs, raw, encoded.size(), (float)raw / encoded.size());
+    }
+
+    if (image.size() > CLIP_PARTITION_SIZE) {
+        fprintf(stderr, "[ClipEncoder] Image is %zu bytes, partition holds %u\n", image.size(), CLIP_PARTITION_SIZE);
+        return 1;
+    }
+    FILE* file = fopen(outputPath, "wb");
+    if (!file || fwrite(image.data(), 1, image.size(), file) != image.size() || fclose(file) != 0) {
+        fprintf(stderr, "[ClipEncoder] Cannot write %s\n", outputPath);
+        return 1;
+    }
+    printf("[ClipEncoder] Wrote %s: %zu bytes (%.0f%% of partition)\n", outputPath, image.size(),
+           100.0f * image.size() / CLIP_PARTITION_SIZE);
+
+    if (!verifyImage(outputPath, clips)) {
+        fprintf(stderr, "[ClipEncoder] Verification FAILED\n");
+        return 1;
+    }
+    printf("[ClipEncoder] Verified\n");
+    return 0;
+}
@@ -0,0 +1,71 @@
+// Хостовый замер CIC-децимации: стоимость блока из SAMPLES выходных отсчётов
+// и выигрыш в шуме для постоянного сигнала с шумом АЦП.
+// Такт хостового счётчика — одна наносекунда реального времени.
+
+#include <Arduino.h>
+#include "cic_decimator.hpp"
+
+constexpr uint32_t BENCH_BLOCKS = 2000;
+constexpr int32_t ADC_NOISE = 16; // Размах шума АЦП, ±МЗР
+
+static uint16_t noisySample() {
+    // Сумма двух равномерных — треугольное распределение, похожее на шум АЦП
+    return 2048 + random(-ADC_NOISE / 2, ADC_NOISE / 2 + 1) + random(-ADC_NOISE / 2, ADC_NOISE / 2 + 1);
+}
+
+static float rms(const float* values, int count) {
+    float mean = 0;
+    for (int i = 0; i < count; i++) mean += values[i];
+    mean /= count;
+    float sum = 0;
+    for (int i = 0; i < count; i++) sum += (values[i] - mean) * (values[i] - mean);
+    return sqrtf(sum / count);
+}
+
+int main() {
+    static uint16_t input[SAMPLES * CicDecimator::MAX_RATIO];
+    static float raw[SAMPLES];
+    static float decimated[SAMPLES];
+
+    for (int i = 0; i < SAMPLES; i++) {
+        raw[i] = noisySample();
+    }
+    float rawNoise = rms(raw, SAMPLES);
+    Serial.printf("[DecimationBench] %u blocks of %d samples, raw noise %.2f LSB rms\n",
+                  BENCH_BLOCKS, SAMPLES, rawNoise);
+
+    for (uint8_t ratio = CicDecimator::MIN_RATIO; ratio <= CicDecimator::MAX_RATIO; ratio *= 2) {
+        CicDecimator decimator;
+        decimator.setRatio(ratio);
+        int inputCount = SAMPLES * ratio;
+        for (int i = 0; i < inputCount; i++) {
+            input[i] = noisySample();
+        }
+
+        // Прогрев, чтобы замер не включал заполнение гребёнок
+        int32_t sample;
+        for (int i = 0; i < inputCount; i++) {
+            decimator.push(input[i], sample);
+        }
+
+        uint64_t cycles = 0;
+        for (uint32_t block = 0; block < BENCH_BLOCKS; block++) {
+            int produced = 0;
+            uint32_t start = ESP.getCycleCount();
+            for (int i = 0; i < inputCount; i++) {
+                if (decimator.push(input[i], sample)) {
+                    decimated[produced++] = sample;
+                }
+            }
+            cycles += ESP.getCycleCount() - start;
+        }
+
+        for (int i = 0; i < SAMPLES; i++) {
+            decimated[i] /= 1 << CicDecimator::FRACTION_BITS;
+        }
+        float noise = rms(decimated, SAMPLES);
+        Serial.printf("[DecimationBench] x%-2u %6u cycles/block  noise %.2f LSB rms  +%.1f bits\n", ratio,
+                      (uint32_t)(cycles / BENCH_BLOCKS), noise, log2f(rawNoise / noise));
+    }
+    return 0;
+}
@@ -0,0 +1,254 @@
+// Хостовая проверка приёма кадров по UART через псевдотерминал.
+// Порт FrameIngest отображается на ведомую сторону pty; дочерний процесс
+// пишет в ведущую поток кадров Adalight, TPM2 и TPM2-RLE вперемешку
+// с командными пакетами, мусором и намеренно испорченными кадрами.
+// Проверяется содержимое показанных кадров и счётчики.
+//
+// ingest_bench [-n кадров]        — встроенный отправитель
+// ingest_bench -d /dev/pts/N [-t с] — слушать внешний отправитель (например, socat)
+
+#include <Arduino.h>
+#include "led_matrix.hpp"
+#include "frame_ingest.hpp"
+#include <chrono>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+constexpr uint32_t DEFAULT_BENCH_FRAMES = 3000;
+constexpr uint32_t CORRUPT_EVERY = 50;  // Каждый такой кадр портится
+constexpr uint32_t NOISE_EVERY = 11;    // Перед таким кадром — мусор
+constexpr uint32_t NOISE_BYTES = 5;
+constexpr uint32_t COMMAND_EVERY = 7;   // Перед таким кадром — командный пакет TPM2
+constexpr uint32_t SHORT_EVERY = 10;    // Кадр Adalight с неполным числом пикселей
+constexpr int SHORT_LEDS = NUM_LEDS * 2 / 3;
+
+static LedMatrix ledMatrix;
+static FrameIngest frameIngest(ledMatrix, INGEST_UART_PORT);
+
+enum class Protocol { Adalight, Tpm2, Tpm2Rle };
+
+static Protocol protocolFor(uint32_t frame) {
+    return (Protocol)(frame % 3);
+}
+
+// Пиксель 0 несёт номер кадра, остальные — узор; у RLE-кадров узор из серий
+static CRGB expectedPixel(uint32_t frame, int i) {
+    if (i == 0) {
+        return CRGB(frame & 0xFF, frame >> 8, 0xAA);
+    }
+    if (protocolFor(frame) == Protocol::Tpm2Rle) {
+        return CRGB(frame * 7 + i / 10 * 20, 255 - i / 10 * 20, frame);
+    }
+    if (protocolFor(frame) == Protocol::Adalight && frame % SHORT_EVERY == 0 && i >= SHORT_LEDS) {
+        return CRGB::Black; // Недостающие пиксели гасятся
+    }
+    return CRGB(frame + i, frame ^ i, i * 2);
+}
+
+// ======================
+//    Отправитель
+// ======================
+static void appendPixel(std::vector<uint8_t>& out, const CRGB& c) {
+    out.push_back(c.r);
+    out.push_back(c.g);
+    out.push_back(c.b);
+}
+
+static void buildFrame(uint32_t frame, bool corrupt, std::vector<uint8_t>& out) {
+    if (frame % NOISE_EVERY == 0) {
+        for (uint32_t i = 0; i < NOISE_BYTES; i++) {
+            out.push_back(0x10 + i);
+        }
+    }
+    if (frame % COMMAND_EVERY == 0) {
+        const uint8_t command[] = {0xC9, 0xC0, 0x00, 0x02, 0x0A, 0x01, 0x36};
+        out.insert(out.end(), command, command + sizeof(command));
+    }
+
+    std::vector<uint8_t> payload;
+    switch (protocolFor(frame)) {
+        case Protocol::Adalight: {
+            int leds = frame % SHORT_EVERY == 0 ? SHORT_LEDS : NUM_LEDS;
+            uint8_t hi = (leds - 1) >> 8, lo = (leds - 1) & 0xFF;
+            const uint8_t header[] = {'A', 'd', 'a', hi, lo, (uint8_t)(hi ^ lo ^ 0x55 ^ (corrupt ? 1 : 0))};
+            out.insert(out.end(), header, header + sizeof(header));
+            for (int i = 0; i < leds; i++) {
+                appendPixel(out, expectedPixel(frame, i));
+            }
+            return;
+        }
+        case Protocol::Tpm2:
+            for (int i = 0; i < NUM_LEDS; i++) {
+                appendPixel(payload, expectedPixel(frame, i));
+            }
+            break;
+        case Protocol::Tpm2Rle:
+            for (int i = 0; i < NUM_LEDS;) {
+                CRGB c = expectedPixel(frame, i);
+                int count = 1;
+                while (i + count < NUM_LEDS && count < 256 && expectedPixel(frame, i + count) == c) count++;
+                payload.push_back(count - 1);
+                appendPixel(payload, c);
+                i += count;
+            }
+            break;
+    }
+    uint8_t type = protocolFor(frame) == Protocol::Tpm2Rle ? 0xDB : 0xDA;
+    const uint8_t header[] = {0xC9, type, (uint8_t)(payload.size() >> 8), (uint8_t)payload.size()};
+    out.insert(out.end(), header, header + sizeof(header));
+    out.insert(out.end(), payload.begin(), payload.end());
+    out.push_back(corrupt ? 0x00 : 0x36);
+}
+
+static void writeAll(int fd, const std::vector<uint8_t>& data) {
+    size_t done = 0;
+    while (done < data.size()) {
+        ssize_t n = write(fd, data.data() + done, data.size() - done);
+        if (n > 0) {
+            done += n;
+        } else {
+            usleep(100);
+        }
+    }
+}
+
+// Поток кадров и один оборванный кадр с паузой дольше INGEST_FRAME_TIMEOUT
+static void runSender(int master, uint32_t frameCount) {
+    std::vector<uint8_t> data;
+    for (uint32_t f = 0; f < frameCount; f++) {
+        data.clear();
+        buildFrame(f, f % CORRUPT_EVERY == CORRUPT_EVERY - 1, data);
+        if (f == frameCount / 2) {
+            writeAll(master, std::vector<uint8_t>(data.begin(), data.begin() + data.size() / 2));
+            usleep((INGEST_FRAME_TIMEOUT + 100) * 1000);
+            continue;
+        }
+        writeAll(master, data);
+    }
+}
+
+// ======================
+//    Приёмник
+// ======================
+static bool checkShownFrame(uint32_t& mismatches) {
+    const CRGB* shown = FastLED.leds();
+    uint32_t frame = shown[0].r | (shown[0].g << 8);
+    for (int i = 0; i < NUM_LEDS; i++) {
+        if (shown[i] != expectedPixel(frame, i)) {
+            mismatches++;
+            return false;
+        }
+    }
+    return true;
+}
+
+static int listenExternal(const char* device, uint32_t seconds) {
+    hostSetUartDevice(INGEST_UART_PORT, device);
+    frameIngest.startTask();
+    auto start = std::chrono::steady_clock::now();
+    auto report = start;
+    while (std::chrono::steady_clock::now() - start < std::chrono::seconds(seconds)) {
+        frameIngest.service(INGEST_FRAME_TIMEOUT);
+        if (std::chrono::steady_clock::now() - report >= std::chrono::seconds(1)) {
+            report = std::chrono::steady_clock::now();
+            IngestStats stats = frameIngest.getStats();
+            Serial.printf("[IngestBench] %u frames/s, %u B/s, dropped %u, sync %u bytes\n", stats.frames,
+                          stats.bytes, stats.dropped, stats.syncBytes);
+            frameIngest.resetStats();
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    uint32_t frameCount = DEFAULT_BENCH_FRAMES;
+    const char* device = nullptr;
+    uint32_t seconds = 10;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:d:t:")) != -1) {
+        switch (opt) {
+            case 'n': frameCount = std::max(CORRUPT_EVERY, (uint32_t)atoi(optarg)); break;
+            case 'd': device = optarg; break;
+            case 't': seconds = atoi(optarg); break;
+            default:
+                fprintf(stderr, "usage: ingest_bench [-n frames] | -d /dev/pts/N [-t seconds]\n");
+                return 2;
+        }
+    }
+
+    // Выходной каскад без изменений цвета: показанный кадр равен принятому
+    ledMatrix.begin();
+    ledMatrix.setBrightness(255);
+    ledMatrix.setGamma(1.0f);
+    ledMatrix.setColorCorrection(CRGB(CRGB::White));
+    ledMatrix.setDithering(false);
+
+    if (device) {
+        return listenExternal(device, seconds);
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+        perror("[IngestBench] pty");
+        return 1;
+    }
+    hostSetUartDevice(INGEST_UART_PORT, ptsname(master));
+    frameIngest.startTask(); // Порт открывается в сыром режиме до начала передачи
+
+    fflush(stdout);
+    pid_t sender = fork();
+    if (sender == 0) {
+        runSender(master, frameCount);
+        // Ведомая сторона дочитает буфер; держим pty открытым, пока родитель не завершит нас
+        pause();
+        _exit(0);
+    }
+
+    // Приветствие Adalight уходит в ведущую сторону; читаем его, чтобы не мешало
+    char hello[8] = {};
+    ssize_t helloLength = read(master, hello, sizeof(hello) - 1);
+
+    uint32_t expectedCorrupt = frameCount / CORRUPT_EVERY;
+    uint32_t expectedFrames = frameCount - expectedCorrupt - 1; // Минус оборванный
+    uint32_t expectedNoise = ((frameCount - 1) / NOISE_EVERY + 1) * NOISE_BYTES;
+
+    uint32_t mismatches = 0;
+    uint32_t lastFrames = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto lastProgress = start;
+    while (true) {
+        frameIngest.service(INGEST_FRAME_TIMEOUT);
+        IngestStats stats = frameIngest.getStats();
+        if (stats.frames != lastFrames) {
+            lastFrames = stats.frames;
+            lastProgress = std::chrono::steady_clock::now();
+            checkShownFrame(mismatches);
+        }
+        if (stats.frames + stats.dropped >= expectedFrames + expectedCorrupt + 1 ||
+            std::chrono::steady_clock::now() - lastProgress > std::chrono::seconds(2)) {
+            break;
+        }
+    }
+    double wallS = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    kill(sender, SIGTERM);
+    waitpid(sender, nullptr, 0);
+    close(master);
+
+    IngestStats stats = frameIngest.getStats();
+    Serial.printf("[IngestBench] hello %s\n", helloLength == 4 && memcmp(hello, "Ada\n", 4) == 0 ? "ok" : "MISSING");
+    Serial.printf("[IngestBench] %u frames sent, %u shown (expected %u), %u dropped (expected %u)\n", frameCount,
+                  stats.frames, expectedFrames, stats.dropped, expectedCorrupt + 1);
+    // Данные кадра с испорченным заголовком Adalight тоже уходят в пропущенные
+    Serial.printf("[IngestBench] sync skipped %u bytes (at least %u), %u content mismatches\n", stats.syncBytes,
+                  expectedNoise, mismatches);
+    Serial.printf("[IngestBench] %.0f frames/s, %.2f MB/s over the pty (includes the %d ms stall)\n",
+                  stats.frames / wallS, stats.bytes / wallS / 1e6, INGEST_FRAME_TIMEOUT + 100);
+
+    bool ok = stats.frames == expectedFrames && stats.dropped == expectedCorrupt + 1 &&
+              stats.syncBytes >= expectedNoise && mismatches == 0 && helloLength == 4;
+    Serial.printf("[IngestBench] %s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,27 @@
+// Хостовый бенчмарк задержки звук -> светодиоды на симулированных часах.
+// Повторяет цикл задачи анимации: кадр, затем пауза периода отрисовки.
+// Задача анализа на хосте не создаётся, анализ идёт по расписанию внутри update().
+
+#include <Arduino.h>
+#include "led_matrix.hpp"
+#include "sound_animator.hpp"
+#include "latency_benchmark.hpp"
+
+static LedMatrix ledMatrix;
+static SoundAnimator soundAnimator(ledMatrix);
+static LatencyBenchmark latencyBenchmark(soundAnimator);
+
+int main() {
+    ledMatrix.begin();
+    ledMatrix.setBrightness(BRIGHTNESS);
+    soundAnimator.init();
+    soundAnimator.initializeAudioAnalyzer();
+
+    latencyBenchmark.begin();
+    while (!latencyBenchmark.isDone()) {
+        latencyBenchmark.poll();
+        soundAnimator.update();
+        vTaskDelay(pdMS_TO_TICKS(1000 / soundAnimator.getRenderRate()));
+    }
+    return 0;
+}
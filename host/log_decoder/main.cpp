@@ -0,0 +1,126 @@
+// Декодер двоичного лога прошивки, собранной с LOG_BINARY=1.
+// Записи отложенного лога (lib/Diagnostics/log_format.hpp) превращаются
+// в текст по таблице событий из того же дерева; остальные байты потока
+// (отчёты через Serial, вывод загрузчика) проходят как есть.
+// Поток читается по мере поступления, поэтому декодер можно держать
+// на порту: cat /dev/ttyUSB0 | log_decoder -t
+//
+// log_decoder [-t] [-l уровень 0..3] [файл...]   без файлов — stdin
+
+#include <Arduino.h>
+#include "log_format.hpp"
+#include <vector>
+#include <unistd.h>
+
+struct DecoderOptions {
+    bool timestamps = false; // Время и ядро перед текстом записи
+    uint8_t level = (uint8_t)LogLevel::Debug;
+};
+
+struct DecoderStats {
+    uint32_t records = 0;
+    uint32_t filtered = 0;
+    uint32_t passedBytes = 0;
+};
+
+static uint32_t readLe32(const uint8_t* p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+// Разобрать запись с начала буфера. 0 — не запись, -1 — запись ещё не пришла целиком
+static int decodeRecord(const uint8_t* data, size_t size, bool final, const DecoderOptions& options,
+                        DecoderStats& stats) {
+    if (data[0] != LOG_SYNC) {
+        return 0;
+    }
+    if (size < LOG_HEADER_WORDS * 4) {
+        return final ? 0 : -1;
+    }
+    LogRecordHeader header;
+    if (!unpackLogHeader(readLe32(data), readLe32(data + 4), header)) {
+        return 0;
+    }
+    size_t length = (LOG_HEADER_WORDS + header.argWords) * 4;
+    if (size < length) {
+        return final ? 0 : -1;
+    }
+
+    uint32_t args[LOG_MAX_ARG_WORDS];
+    for (uint8_t i = 0; i < header.argWords; i++) {
+        args[i] = readLe32(data + (LOG_HEADER_WORDS + i) * 4);
+    }
+    char line[LOG_MAX_LINE];
+    if (formatLogRecord(header.event, args, header.argWords, line, sizeof(line)) < 0) {
+        return 0; // Байт синхронизации внутри текста или обрыв записи
+    }
+
+    stats.records++;
+    LogLevel level = LOG_EVENT_LEVELS[header.event];
+    if ((uint8_t)level > options.level) {
+        stats.filtered++;
+    } else if (options.timestamps) {
+        printf("%10u.%06u %u %s %s\n", header.timestamp / 1000000, header.timestamp % 1000000, header.core,
+               getLogLevelName(level), line);
+    } else {
+        printf("%s\n", line);
+    }
+    return (int)length;
+}
+
+static void decodeStream(FILE* file, const DecoderOptions& options, DecoderStats& stats) {
+    std::vector<uint8_t> pending;
+    uint8_t chunk[4096];
+    bool final = false;
+    while (!final) {
+        size_t count = fread(chunk, 1, sizeof(chunk), file);
+        final = count == 0;
+        pending.insert(pending.end(), chunk, chunk + count);
+
+        size_t position = 0;
+        while (position < pending.size()) {
+            int length = decodeRecord(&pending[position], pending.size() - position, final, options, stats);
+            if (length < 0) {
+                break; // Дождаться остатка записи
+            }
+            if (length > 0) {
+                position += length;
+            } else {
+                putchar(pending[position++]);
+                stats.passedBytes++;
+            }
+        }
+        pending.erase(pending.begin(), pending.begin() + position);
+        fflush(stdout);
+    }
+}
+
+int main(int argc, char** argv) {
+    DecoderOptions options;
+    int opt;
+    while ((opt = getopt(argc, argv, "tl:h")) != -1) {
+        switch (opt) {
+            case 't': options.timestamps = true; break;
+            case 'l': options.level = (uint8_t)constrain(atoi(optarg), 0, (int)LogLevel::Debug); break;
+            default:
+                fprintf(stderr, "usage: log_decoder [-t] [-l level 0..3] [file...]\n");
+                return 2;
+        }
+    }
+
+    DecoderStats stats;
+    if (optind >= argc) {
+        decodeStream(stdin, options, stats);
+    }
+    for (int i = optind; i < argc; i++) {
+        FILE* file = fopen(argv[i], "rb");
+        if (!file) {
+            fprintf(stderr, "[LogDecoder] Cannot open %s\n", argv[i]);
+            return 1;
+        }
+        decodeStream(file, options, stats);
+        fclose(file);
+    }
+    fprintf(stderr, "[LogDecoder] %u records (%u filtered), %u bytes of other output\n", stats.records,
+            stats.filtered, stats.passedBytes);
+    return 0;
+}
@@ -0,0 +1,612 @@
+// Офлайн-рендер: WAV -> кадры матрицы на симулированных часах.
+// Те же AudioAnalyzer и SoundAnimator, что на устройстве; АЦП читает WAV
+// по текущему симулированному времени, цикл кадров повторяет задачу анимации.
+// Файлы рендерятся параллельно в отдельных процессах: состояние хостовой
+// замены (часы, источник АЦП, FastLED, NVS) глобальное, у каждого файла своё.
+//
+// offline_render [-a анимация] [-c RRGGBB] [-f lmf|ppm] [-o каталог] [-g усиление]
+//                [-l образ:клип] [-j процессов] [-p] [-v] файл.wav...
+//
+// Формат .lmf (little-endian):
+//   заголовок 16 байт: "LMF1", width u8, height u8, 2 байта резерв,
+//                      frameCount u32, durationMs u32
+//   кадр: timeMs u32, затем width * height * 3 байта RGB построчно, y = 0 — верх
+
+#include <Arduino.h>
+#include "led_matrix.hpp"
+#include "sound_animator.hpp"
+#include "clip_storage.hpp"
+#include <cctype>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+enum class OutputFormat { Lmf, Ppm };
+
+struct RenderOptions {
+    AnimationType animation = AnimationType::ColorAmplitude;
+    bool colorSet = false;
+    CRGB color = CRGB::Black;
+    const Palette* palette = nullptr; // Встроенная палитра вместо цвета
+    OutputFormat format = OutputFormat::Lmf;
+    std::string outputDir = ".";
+    float gain = 1.0f;       // 1 — полная шкала WAV на полную шкалу АЦП
+    std::string clipImage;   // Образ клипов (host/clip_encoder) для слоя поверх анимации
+    std::string clipName;
+    int jobs = 0;            // 0 — по числу ядер
+    int renderRate = 0;      // Частоты отрисовки и анализа, 0 — настройки аниматора
+    int analysisRate = 0;
+    int blend = -1;          // SpectrumBlend, -1 — настройка аниматора
+    bool preview = false;    // Цвета анимации без выходного каскада
+    bool verbose = false;    // Не глушить лог библиотек
+};
+
+// Итог рендера одного файла; процесс-исполнитель пишет его в канал
+struct RenderResult {
+    uint32_t frames;
+    uint32_t audioMs;
+    uint32_t wallUs;
+    bool ok;
+};
+
+// ======================
+//    WAV
+// ======================
+struct WavAudio {
+    uint32_t sampleRate = 0;
+    uint8_t channels = 0;              // 1 или 2 (лишние каналы отбрасываются)
+    std::vector<int16_t> samples;      // Чередование по каналам
+
+    uint32_t frameCount() const { return channels ? samples.size() / channels : 0; }
+};
+
+static uint32_t readLe(const uint8_t* p, int bytes) {
+    uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+// PCM 8/16/24/32 бит и float32, в том числе WAVE_FORMAT_EXTENSIBLE
+static bool loadWav(const char* path, WavAudio& wav) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "[OfflineRender] Cannot open %s\n", path);
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(file);
+
+    if (data.size() < 12 || memcmp(&data[0], "RIFF", 4) != 0 || memcmp(&data[8], "WAVE", 4) != 0) {
+        fprintf(stderr, "[OfflineRender] %s is not a RIFF/WAVE file\n", path);
+        return false;
+    }
+
+    uint16_t format = 0, channels = 0, bits = 0;
+    const uint8_t* pcm = nullptr;
+    size_t pcmSize = 0;
+    for (size_t pos = 12; pos + 8 <= data.size();) {
+        uint32_t size = readLe(&data[pos + 4], 4);
+        const uint8_t* body = &data[pos + 8];
+        size_t available = std::min<size_t>(size, data.size() - pos - 8);
+        if (memcmp(&data[pos], "fmt ", 4) == 0 && available >= 16) {
+            format = readLe(body, 2);
+            channels = readLe(body + 2, 2);
+            wav.sampleRate = readLe(body + 4, 4);
+            bits = readLe(body + 14, 2);
+            if (format == 0xFFFE && available >= 26) {
+                format = readLe(body + 24, 2); // Подформат из GUID
+            }
+        } else if (memcmp(&data[pos], "data", 4) == 0) {
+            pcm = body;
+            pcmSize = available;
+        }
+        pos += 8 + size + (size & 1);
+    }
+
+    bool supported = (format == 1 && (bits == 8 || bits == 16 || bits == 24 || bits == 32)) ||
+                     (format == 3 && bits == 32);
+    if (!pcm || !supported || channels == 0 || wav.sampleRate == 0) {
+        fprintf(stderr, "[OfflineRender] %s: unsupported WAV (format %u, %u bit, %u ch)\n",
+                path, format, bits, channels);
+        return false;
+    }
+
+    int bytes = bits / 8;
+    uint32_t frames = pcmSize / (bytes * channels);
+    wav.channels = std::min<uint16_t>(channels, 2);
+    wav.samples.resize((size_t)frames * wav.channels);
+    for (uint32_t i = 0; i < frames; i++) {
+        for (uint8_t ch = 0; ch < wav.channels; ch++) {
+            const uint8_t* p = pcm + ((size_t)i * channels + ch) * bytes;
+            int32_t value;
+            if (format == 3) {
+                uint32_t raw = readLe(p, 4);
+                float f;
+                memcpy(&f, &raw, sizeof(f));
+                value = (int32_t)(constrain(f, -1.0f, 1.0f) * 32767.0f);
+            } else if (bits == 8) {
+                value = ((int32_t)p[0] - 128) << 8;
+            } else {
+                // Старшие 16 бит знакового отсчёта
+                value = (int32_t)(readLe(p, bytes) << (32 - bits)) >> 16;
+            }
+            wav.samples[(size_t)i * wav.channels + ch] = (int16_t)value;
+        }
+    }
+    return true;
+}
+
+// ======================
+//    Источник АЦП
+// ======================
+static const WavAudio* currentWav = nullptr;
+static uint64_t audioStartUs = 0;
+static float adcGain = 1.0f;
+
+// Отсчёт WAV, ближайший слева к текущему времени; после конца — тишина.
+// MIC2_PIN читает правый канал стереофайла.
+static uint16_t wavAdcSource(uint8_t pin) {
+    uint64_t index = (HostClock::now() - audioStartUs) * currentWav->sampleRate / 1000000;
+    if (index >= currentWav->frameCount()) {
+        return 2048;
+    }
+    uint8_t channel = pin == MIC2_PIN && currentWav->channels > 1 ? 1 : 0;
+    float value = 2048.0f + currentWav->samples[index * currentWav->channels + channel] * (adcGain / 16.0f);
+    return (uint16_t)constrain(value, 0.0f, 4095.0f);
+}
+
+// ======================
+//    Вывод кадров
+// ======================
+class FrameWriter {
+public:
+    FrameWriter(const RenderOptions& options, const std::string& name) : options(options), name(name) {}
+
+    bool open() {
+        if (options.format == OutputFormat::Ppm) {
+            directory = options.outputDir + "/" + name;
+            mkdir(directory.c_str(), 0755);
+            return true;
+        }
+        std::string path = options.outputDir + "/" + name + ".lmf";
+        file = fopen(path.c_str(), "wb");
+        if (!file) {
+            fprintf(stderr, "[OfflineRender] Cannot create %s\n", path.c_str());
+            return false;
+        }
+        writeHeader(0, 0); // Счётчики дописываются в close()
+        return true;
+    }
+
+    bool write(const CRGB* leds, LedMatrix& matrix, uint32_t timeMs) {
+        uint8_t pixels[NUM_LEDS * 3];
+        uint8_t* out = pixels;
+        for (int y = 0; y < MATRIX_HEIGHT; y++) {
+            for (int x = 0; x < MATRIX_WIDTH; x++) {
+                const CRGB& c = leds[matrix.XY(x, y)];
+                *out++ = c.r;
+                *out++ = c.g;
+                *out++ = c.b;
+            }
+        }
+
+        bool ok;
+        if (options.format == OutputFormat::Ppm) {
+            char path[512];
+            snprintf(path, sizeof(path), "%s/frame_%06u.ppm", directory.c_str(), frames);
+            FILE* ppm = fopen(path, "wb");
+            ok = ppm && fprintf(ppm, "P6\n%d %d\n255\n", MATRIX_WIDTH, MATRIX_HEIGHT) > 0 &&
+                 fwrite(pixels, 1, sizeof(pixels), ppm) == sizeof(pixels);
+            if (ppm) {
+                fclose(ppm);
+            }
+        } else {
+            uint8_t time[4];
+            putLe(time, timeMs);
+            ok = fwrite(time, 1, 4, file) == 4 && fwrite(pixels, 1, sizeof(pixels), file) == sizeof(pixels);
+        }
+        frames++;
+        return ok;
+    }
+
+    bool close(uint32_t durationMs) {
+        if (!file) {
+            return true;
+        }
+        fseek(file, 0, SEEK_SET);
+        writeHeader(frames, durationMs);
+        bool ok = fclose(file) == 0;
+        file = nullptr;
+        return ok;
+    }
+
+private:
+    const RenderOptions& options;
+    std::string name;
+    std::string directory;
+    FILE* file = nullptr;
+    uint32_t frames = 0;
+
+    static void putLe(uint8_t* p, uint32_t value) {
+        for (int i = 0; i < 4; i++) {
+            p[i] = (uint8_t)(value >> (8 * i));
+        }
+    }
+
+    void writeHeader(uint32_t frameCount, uint32_t durationMs) {
+        uint8_t header[16] = {'L', 'M', 'F', '1', MATRIX_WIDTH, MATRIX_HEIGHT, 0, 0};
+        putLe(header + 8, frameCount);
+        putLe(header + 12, durationMs);
+        fwrite(header, 1, sizeof(header), file);
+    }
+};
+
+// ======================
+//    Рендер одного файла
+// ======================
+static std::string baseName(const char* path) {
+    std::string name = path;
+    size_t slash = name.find_last_of('/');
+    if (slash != std::string::npos) {
+        name = name.substr(slash + 1);
+    }
+    size_t dot = name.find_last_of('.');
+    return dot == std::string::npos ? name : name.substr(0, dot);
+}
+
+static RenderResult renderFile(const char* path, const RenderOptions& options) {
+    RenderResult result = {0, 0, 0, false};
+    auto wallStart = std::chrono::steady_clock::now();
+
+    WavAudio wav;
+    if (!loadWav(path, wav)) {
+        return result;
+    }
+    uint64_t durationUs = (uint64_t)wav.frameCount() * 1000000 / wav.sampleRate;
+    result.audioMs = (uint32_t)(durationUs / 1000);
+
+    static LedMatrix ledMatrix;
+    static SoundAnimator soundAnimator(ledMatrix);
+    ledMatrix.begin();
+    if (options.preview) {
+        ledMatrix.setBrightness(255);
+        ledMatrix.setGamma(1.0f);
+        ledMatrix.setColorCorrection(CRGB(CRGB::White));
+        ledMatrix.setDithering(false);
+    } else {
+        ledMatrix.setBrightness(BRIGHTNESS);
+    }
+    soundAnimator.init();
+    soundAnimator.initializeAudioAnalyzer();
+    if (options.renderRate) {
+        soundAnimator.setFrameRates(options.renderRate, options.analysisRate);
+    }
+    if (options.blend >= 0) {
+        soundAnimator.setSpectrumBlend((SpectrumBlend)options.blend);
+    }
+    CRGB color = options.colorSet ? options.color
+               : options.animation == AnimationType::ColorAmplitude ? CRGB(CRGB::Black) : CRGB(CRGB::Blue);
+    if (!options.colorSet && options.animation == AnimationType::Spectrogram) {
+        soundAnimator.setAnimation(options.animation, palettes::HEAT);
+    } else if (options.palette) {
+        soundAnimator.setAnimation(options.animation, *options.palette);
+    } else {
+        soundAnimator.setAnimation(options.animation, color);
+    }
+
+    // Клип поверх анимации: образ отображается как раздел flash
+    static ClipStorage clipStorage;
+    if (!options.clipImage.empty()) {
+        hostSetPartitionFile(CLIP_PARTITION_LABEL, options.clipImage.c_str());
+        if (!clipStorage.begin() ||
+            !soundAnimator.playClip(clipStorage.getDirectory(), options.clipName.c_str(), ClipBlend::Over, true)) {
+            fprintf(stderr, "[OfflineRender] Cannot play clip '%s' from %s\n", options.clipName.c_str(),
+                    options.clipImage.c_str());
+            return result;
+        }
+    }
+
+    FrameWriter writer(options, baseName(path));
+    if (!writer.open()) {
+        return result;
+    }
+
+    currentWav = &wav;
+    adcGain = options.gain;
+    hostSetAdcSource(wavAdcSource);
+    audioStartUs = HostClock::now();
+
+    // Цикл задачи анимации. Простой в тишине на устройстве гасит матрицу
+    // и ждёт звука в runIdle(); здесь он заменён чёрными кадрами.
+    // Задача анализа на устройстве работает на другом ядре, и захват идёт
+    // параллельно кадрам. Здесь она крутится на своей линии времени: перед
+    // кадром выполняются шаги, которые к его началу успели бы закончиться,
+    // а часы кадра они не сдвигают.
+    MatrixAnalyzer& analyzer = soundAnimator.getAudioAnalyzer();
+    ClipLayer& clipLayer = ledMatrix.getClipLayer();
+    soundAnimator.setInlineAnalysis(false);
+    uint64_t analysisUs = audioStartUs;   // Начало следующего шага анализа
+    uint64_t lastStepUs[2] = {0, 0};      // Длительность прошлого шага: анализ, проба
+    auto runAnalysis = [&](uint64_t frameUs) {
+        while (true) {
+            // Тело задачи анализа: в тишине пробы с паузой, иначе анализ по расписанию
+            bool probe = analyzer.isSilent() && !clipLayer.isActive();
+            if (analysisUs + lastStepUs[probe] > frameUs) {
+                break;
+            }
+            HostClock::set(analysisUs);
+            if (probe) {
+                delay(IDLE_PROBE_INTERVAL);
+                analyzer.processAudio();
+            } else {
+                soundAnimator.runAnalysisIfDue();
+            }
+            uint64_t endUs = HostClock::now();
+            lastStepUs[probe] = endUs - analysisUs;
+            // sleepUntil() после перегрузки не догоняет пропущенное
+            uint64_t periodUs = soundAnimator.getAnalysisPeriodUs();
+            analysisUs = probe || endUs - analysisUs >= periodUs ? endUs : analysisUs + periodUs;
+        }
+        HostClock::set(frameUs);
+    };
+
+    static const CRGB black[NUM_LEDS];
+    const TickType_t period = pdMS_TO_TICKS(1000 / soundAnimator.getRenderRate());
+    TickType_t lastWake = xTaskGetTickCount();
+    bool ok = true;
+    while (ok && HostClock::now() - audioStartUs < durationUs) {
+        runAnalysis(HostClock::now());
+        uint32_t timeMs = (uint32_t)((HostClock::now() - audioStartUs) / 1000);
+        // Клип играет и в тишине, как на устройстве
+        if (analyzer.isSilent() && !clipLayer.isActive()) {
+            ok = writer.write(black, ledMatrix, timeMs);
+        } else {
+            soundAnimator.update();
+            ok = writer.write(FastLED.leds(), ledMatrix, timeMs);
+        }
+        result.frames++;
+
+        if (xTaskGetTickCount() - lastWake >= period) {
+            lastWake = xTaskGetTickCount();
+            vTaskDelay(1);
+        } else {
+            vTaskDelayUntil(&lastWake, period);
+        }
+    }
+    hostSetAdcSource(nullptr);
+
+    result.ok = writer.close(result.audioMs) && ok;
+    if (!ok) {
+        fprintf(stderr, "[OfflineRender] %s: write failed\n", path);
+    }
+    result.wallUs = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - wallStart).count();
+    return result;
+}
+
+// ======================
+//    Параллельный запуск
+// ======================
+struct Worker {
+    pid_t pid;
+    int pipe;
+    const char* path;
+};
+
+static Worker startWorker(const char* path, const RenderOptions& options) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+        return {-1, -1, path};
+    }
+    fflush(stdout);
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        if (!options.verbose && !freopen("/dev/null", "w", stdout)) {
+            _exit(1);
+        }
+        RenderResult result = renderFile(path, options);
+        ssize_t written = ::write(fds[1], &result, sizeof(result));
+        _exit(written == sizeof(result) && result.ok ? 0 : 1);
+    }
+    close(fds[1]);
+    if (pid < 0) {
+        close(fds[0]);
+        return {-1, -1, path};
+    }
+    return {pid, fds[0], path};
+}
+
+// Итог исполнителя короче буфера канала, поэтому он пишется без блокировки
+// и читается после завершения процесса
+static bool finishWorker(const Worker& worker, RenderResult& result) {
+    ssize_t n = read(worker.pipe, &result, sizeof(result));
+    close(worker.pipe);
+    return n == sizeof(result) && result.ok;
+}
+
+static bool parseAnimation(const char* text, AnimationType& animation) {
+    const AnimationType all[] = {
+        AnimationType::ColorAmplitude,
+        AnimationType::PulsingRectangle,
+        AnimationType::StarrySky,
+        AnimationType::Wave,
+        AnimationType::Spectrogram,
+    };
+    // Имя без пробелов и регистра ("starrysky") или номер
+    std::string given;
+    for (const char* c = text; *c; c++) {
+        given += (char)tolower(*c);
+    }
+    bool numeric = isdigit((unsigned char)text[0]);
+    for (AnimationType type : all) {
+        std::string name;
+        for (const char* c = SoundAnimator::getAnimationName(type); *c; c++) {
+            if (*c != ' ') {
+                name += (char)tolower(*c);
+            }
+        }
+        if (numeric ? atoi(text) == (int)type : given == name) {
+            animation = type;
+            return true;
+        }
+    }
+    return false;
+}
+
+static void printUsage() {
+    fprintf(stderr,
+            "usage: offline_render [-a animation] [-c RRGGBB|palette] [-f lmf|ppm] [-o dir] [-g gain]\n"
+            "                      [-r render:analysis] [-b hold|interpolate|extrapolate]\n"
+            "                      [-l image:clip] [-j jobs] [-p] [-v] file.wav...\n"
+            "  -a  coloramplitude | pulsingrectangle | starrysky | wave | spectrogram (or 0..4)\n"
+            "  -c  animation color (000000 = rainbow) or palette: rainbow | fire | ocean | forest | heat\n"
+            "  -f  lmf: one binary frame file per WAV; ppm: a directory of frames\n"
+            "  -g  WAV full scale to ADC full scale multiplier (default 1)\n"
+            "  -r  render and analysis rates, Hz (default %d:%d)\n"
+            "  -b  frames between analysis frames: hold, interpolate or extrapolate\n"
+            "  -l  loop a clip from a clip image over the animation (image.bin:name)\n"
+            "  -j  parallel files (default: CPU count)\n"
+            "  -p  preview colors: skip gamma, brightness and color correction\n"
+            "  -v  keep library logs\n",
+            RENDER_RATE, ANALYSIS_RATE);
+}
+
+int main(int argc, char** argv) {
+    RenderOptions options;
+    int opt;
+    while ((opt = getopt(argc, argv, "a:c:f:o:g:r:b:l:j:pvh")) != -1) {
+        switch (opt) {
+            case 'a':
+                if (!parseAnimation(optarg, options.animation)) {
+                    fprintf(stderr, "[OfflineRender] Unknown animation '%s'\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'c':
+                options.palette = palettes::find(optarg);
+                options.color = CRGB((uint32_t)strtoul(optarg, nullptr, 16));
+                options.colorSet = true;
+                break;
+            case 'r':
+                if (sscanf(optarg, "%d:%d", &options.renderRate, &options.analysisRate) != 2) {
+                    fprintf(stderr, "[OfflineRender] Rates must be render:analysis\n");
+                    return 2;
+                }
+                break;
+            case 'b': {
+                const char* modes[] = {"hold", "interpolate", "extrapolate"};
+                options.blend = -1;
+                for (int i = 0; i < 3; i++) {
+                    if (strcmp(optarg, modes[i]) == 0) {
+                        options.blend = i;
+                    }
+                }
+                if (options.blend < 0) {
+                    fprintf(stderr, "[OfflineRender] Unknown blend '%s'\n", optarg);
+                    return 2;
+                }
+                break;
+            }
+            case 'f':
+                if (strcmp(optarg, "lmf") == 0) {
+                    options.format = OutputFormat::Lmf;
+                } else if (strcmp(optarg, "ppm") == 0) {
+                    options.format = OutputFormat::Ppm;
+                } else {
+                    fprintf(stderr, "[OfflineRender] Unknown format '%s'\n", optarg);
+                    return 2;
+                }
+                break;
+            case 'o': options.outputDir = optarg; break;
+            case 'g': options.gain = strtof(optarg, nullptr); break;
+            case 'l': {
+                const char* colon = strrchr(optarg, ':');
+                if (!colon || colon == optarg || !colon[1]) {
+                    fprintf(stderr, "[OfflineRender] Expected -l image.bin:clip\n");
+                    return 2;
+                }
+                options.clipImage.assign(optarg, colon - optarg);
+                options.clipName = colon + 1;
+                break;
+            }
+            case 'j': options.jobs = atoi(optarg); break;
+            case 'p': options.preview = true; break;
+            case 'v': options.verbose = true; break;
+            default:
+                printUsage();
+                return 2;
+        }
+    }
+    if (optind >= argc) {
+        printUsage();
+        return 2;
+    }
+    if (options.jobs <= 0) {
+        options.jobs = std::max<long>(1, sysconf(_SC_NPROCESSORS_ONLN));
+    }
+    mkdir(options.outputDir.c_str(), 0755);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    std::vector<Worker> running;
+    uint64_t totalFrames = 0, totalAudioMs = 0;
+    int failed = 0;
+
+    // Ждём любого завершившегося исполнителя
+    auto collect = [&]() {
+        int status = 0;
+        pid_t pid = wait(&status);
+        auto it = std::find_if(running.begin(), running.end(), [pid](const Worker& w) { return w.pid == pid; });
+        if (it == running.end()) {
+            it = running.begin();
+            waitpid(it->pid, &status, 0);
+        }
+        Worker worker = *it;
+        running.erase(it);
+        RenderResult result;
+        if (!finishWorker(worker, result)) {
+            printf("[OfflineRender] %s: FAILED\n", worker.path);
+            failed++;
+            return;
+        }
+        totalFrames += result.frames;
+        totalAudioMs += result.audioMs;
+        float wallS = result.wallUs / 1e6f;
+        printf("[OfflineRender] %s: %u frames, %.1f s audio in %.2f s, %.0f FPS, x%.1f realtime\n",
+               worker.path, result.frames, result.audioMs / 1000.0f, wallS,
+               result.frames / wallS, result.audioMs / 1000.0f / wallS);
+    };
+
+    for (int i = optind; i < argc; i++) {
+        if ((int)running.size() >= options.jobs) {
+            collect();
+        }
+        Worker worker = startWorker(argv[i], options);
+        if (worker.pid < 0) {
+            printf("[OfflineRender] %s: cannot start worker\n", argv[i]);
+            failed++;
+            continue;
+        }
+        running.push_back(worker);
+    }
+    while (!running.empty()) {
+        collect();
+    }
+
+    float wallS = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - wallStart).count() / 1e6f;
+    printf("[OfflineRender] Total: %d files, %llu frames in %.2f s, %.0f FPS, x%.1f realtime (%d jobs)\n",
+           argc - optind - failed, (unsigned long long)totalFrames, wallS, totalFrames / wallS,
+           totalAudioMs / 1000.0f / wallS, options.jobs);
+    return failed ? 1 : 0;
+}
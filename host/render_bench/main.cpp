@@ -0,0 +1,50 @@
+// Хостовый замер стоимости отрисовки кадра для каждой анимации.
+// Анализ идёт по синтетическому сигналу, замеряется только отрисовка.
+// Такт хостового счётчика — одна наносекунда реального времени.
+
+#include <Arduino.h>
+#include "led_matrix.hpp"
+#include "sound_animator.hpp"
+
+constexpr uint32_t BENCH_FRAMES = 20000;
+
+static LedMatrix ledMatrix;
+static SoundAnimator soundAnimator(ledMatrix);
+
+// Тон 440 Гц с огибающей 2 Гц и шумом: громкость гуляет по всему диапазону
+static uint16_t benchAdcSource(uint8_t) {
+    float t = HostClock::now() / 1e6f;
+    float envelope = 0.5f + 0.5f * sinf(2.0f * PI * 2.0f * t);
+    float tone = sinf(2.0f * PI * 440.0f * t) * envelope * 1500.0f;
+    return (uint16_t)(2048 + tone + random(-100, 101));
+}
+
+int main() {
+    hostSetAdcSource(benchAdcSource);
+    ledMatrix.begin();
+    ledMatrix.setBrightness(BRIGHTNESS);
+    soundAnimator.init();
+    soundAnimator.initializeAudioAnalyzer();
+
+    const AnimationType animations[] = {
+        AnimationType::ColorAmplitude,
+        AnimationType::PulsingRectangle,
+        AnimationType::StarrySky,
+        AnimationType::Wave,
+        AnimationType::Spectrogram,
+    };
+
+    Serial.printf("[RenderBench] %u frames per animation\n", BENCH_FRAMES);
+    for (AnimationType animation : animations) {
+        soundAnimator.setAnimation(animation, animation == AnimationType::ColorAmplitude ? CRGB::Black : CRGB::Blue);
+        soundAnimator.update(); // Переключение анимации не входит в замер
+        soundAnimator.resetRenderStats();
+        for (uint32_t i = 0; i < BENCH_FRAMES; i++) {
+            soundAnimator.update();
+            vTaskDelay(pdMS_TO_TICKS(1000 / soundAnimator.getRenderRate())); // Анализ идёт по часам
+        }
+        Serial.printf("[RenderBench] %-18s %u cycles/frame\n", SoundAnimator::getAnimationName(animation),
+                      soundAnimator.getRenderCycles());
+    }
+    return 0;
+}
@@ -0,0 +1,77 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// Минимальная замена Arduino-ядра ESP32 для хостовых инструментов
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include "host_clock.hpp"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_system.h"
+
+typedef uint8_t byte;
+
+#define PI 3.1415926535897932384626433832795
+#define INPUT 0x01
+#define OUTPUT 0x03
+#define ADC_11db 3
+#define PROGMEM
+#define IRAM_ATTR
+#define pgm_read_byte(addr) (*(const uint8_t*)(addr))
+#define pgm_read_word(addr) (*(const uint16_t*)(addr))
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+long map(long x, long in_min, long in_max, long out_min, long out_max);
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+uint16_t analogRead(uint8_t pin);
+void analogReadResolution(uint8_t bits);
+void analogSetAttenuation(int attenuation);
+
+// Источник отсчётов АЦП для хоста (по умолчанию — середина шкалы)
+typedef uint16_t (*HostAdcSource)(uint8_t pin);
+void hostSetAdcSource(HostAdcSource source);
+
+size_t getArduinoLoopTaskStackSize();
+
+// Счётчик тактов CPU. Работа CPU на хосте не симулируется, поэтому
+// счётчик идёт по реальному времени: один такт — одна наносекунда.
+class EspClass {
+public:
+    uint32_t getCycleCount();
+    uint32_t getCpuFreqMHz() { return 1000; }
+};
+
+extern EspClass ESP;
+
+class HardwareSerial {
+public:
+    void begin(unsigned long baud, uint32_t config = 0, int8_t rxPin = -1, int8_t txPin = -1);
+    size_t print(const char* s);
+    size_t println(const char* s = "");
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* data, size_t size);
+    int available();
+    int read();
+    void flush();
+};
+
+extern HardwareSerial Serial;
+
+#endif // HOST_ARDUINO_H
@@ -0,0 +1,114 @@
+#ifndef HOST_FASTLED_H
+#define HOST_FASTLED_H
+
+// Подмножество FastLED, которое используют библиотеки проекта
+
+#include "Arduino.h"
+
+struct CHSV {
+    uint8_t h, s, v;
+    CHSV() : h(0), s(0), v(0) {}
+    CHSV(uint8_t hue, uint8_t sat, uint8_t val) : h(hue), s(sat), v(val) {}
+};
+
+struct CRGB;
+void hsv2rgb_rainbow(const CHSV& hsv, CRGB& rgb);
+
+uint8_t scale8(uint8_t value, uint8_t scale);
+
+struct CRGB {
+    union {
+        struct {
+            uint8_t r, g, b;
+        };
+        uint8_t raw[3];
+    };
+
+    enum HTMLColorCode : uint32_t {
+        Black = 0x000000,
+        Blue = 0x0000FF,
+        Cyan = 0x00FFFF,
+        Green = 0x008000,
+        Magenta = 0xFF00FF,
+        Orange = 0xFFA500,
+        Purple = 0x800080,
+        Red = 0xFF0000,
+        White = 0xFFFFFF,
+        Yellow = 0xFFFF00
+    };
+
+    CRGB() : r(0), g(0), b(0) {}
+    CRGB(uint8_t ir, uint8_t ig, uint8_t ib) : r(ir), g(ig), b(ib) {}
+    CRGB(uint32_t colorcode) : r((colorcode >> 16) & 0xFF), g((colorcode >> 8) & 0xFF), b(colorcode & 0xFF) {}
+    CRGB(HTMLColorCode colorcode) : CRGB((uint32_t)colorcode) {}
+    CRGB(const CHSV& hsv) { hsv2rgb_rainbow(hsv, *this); }
+
+    uint8_t& operator[](uint8_t x) { return raw[x]; }
+    const uint8_t& operator[](uint8_t x) const { return raw[x]; }
+
+    CRGB& nscale8(uint8_t scale) {
+        r = ((uint16_t)r * (1 + scale)) >> 8;
+        g = ((uint16_t)g * (1 + scale)) >> 8;
+        b = ((uint16_t)b * (1 + scale)) >> 8;
+        return *this;
+    }
+};
+
+inline bool operator==(const CRGB& lhs, const CRGB& rhs) {
+    return lhs.r == rhs.r && lhs.g == rhs.g && lhs.b == rhs.b;
+}
+
+inline bool operator!=(const CRGB& lhs, const CRGB& rhs) {
+    return !(lhs == rhs);
+}
+
+void fill_solid(CRGB* leds, int numToFill, const CRGB& color);
+
+enum EOrder { RGB = 0012, GRB = 0102 };
+enum LEDColorCorrection : uint32_t { TypicalLEDStrip = 0xFFB0F0, UncorrectedColor = 0xFFFFFF };
+
+#define DISABLE_DITHER 0x00
+#define BINARY_DITHER 0x01
+
+struct WS2812B {};
+
+class CLEDController {
+public:
+    CRGB* leds = nullptr;
+    int count = 0;
+
+    void setLeds(CRGB* data, int numLeds) {
+        leds = data;
+        count = numLeds;
+    }
+};
+
+// Контроллер ленты: show() двигает часы на время передачи кадра WS2812
+class CFastLED {
+public:
+    template <typename CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+    CLEDController& addLeds(CRGB* data, int numLeds) {
+        controller.leds = data;
+        controller.count = numLeds;
+        return controller;
+    }
+
+    void setBrightness(uint8_t scale) { brightness = scale; }
+    uint8_t getBrightness() const { return brightness; }
+    void setCorrection(uint32_t correction) { (void)correction; }
+    void setDither(uint8_t ditherMode) { (void)ditherMode; }
+    void show();
+
+    CRGB* leds() { return controller.leds; }
+    int size() const { return controller.count; }
+    uint32_t getFrameCount() const { return frameCount; }
+
+private:
+    CLEDController controller;
+    uint8_t brightness = 255;
+    uint32_t frameCount = 0;
+};
+
+extern CFastLED FastLED;
+
+#endif // HOST_FASTLED_H
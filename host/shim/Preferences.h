@@ -0,0 +1,28 @@
+#ifndef HOST_PREFERENCES_H
+#define HOST_PREFERENCES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// NVS на хосте: значения живут в памяти процесса
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false, const char* partitionLabel = nullptr);
+    void end();
+    bool clear();
+    bool isKey(const char* key);
+
+    size_t putFloat(const char* key, float value);
+    float getFloat(const char* key, float defaultValue = 0);
+    size_t putInt(const char* key, int32_t value);
+    int32_t getInt(const char* key, int32_t defaultValue = 0);
+    size_t putUChar(const char* key, uint8_t value);
+    uint8_t getUChar(const char* key, uint8_t defaultValue = 0);
+
+private:
+    std::string space;
+    bool started = false;
+};
+
+#endif // HOST_PREFERENCES_H
@@ -0,0 +1,44 @@
+#ifndef HOST_DRIVER_UART_H
+#define HOST_DRIVER_UART_H
+
+#include <cstddef>
+#include <cstdint>
+#include "esp_system.h"
+#include "freertos/FreeRTOS.h"
+
+// Драйвер UART на хосте: порт сопоставляется терминалу (pty или
+// последовательный порт). Ожидание данных идёт в реальном времени
+// и сдвигает симулированные часы на столько же.
+
+typedef int uart_port_t;
+typedef struct HostQueue* QueueHandle_t; // Очередь событий драйвера на хосте не поддерживается
+
+typedef enum { UART_DATA_8_BITS = 3 } uart_word_length_t;
+typedef enum { UART_PARITY_DISABLE = 0 } uart_parity_t;
+typedef enum { UART_STOP_BITS_1 = 1 } uart_stop_bits_t;
+typedef enum { UART_HW_FLOWCTRL_DISABLE = 0 } uart_hw_flowcontrol_t;
+
+typedef struct {
+    int baud_rate;
+    uart_word_length_t data_bits;
+    uart_parity_t parity;
+    uart_stop_bits_t stop_bits;
+    uart_hw_flowcontrol_t flow_ctrl;
+    uint8_t rx_flow_ctrl_thresh;
+} uart_config_t;
+
+#define UART_PIN_NO_CHANGE (-1)
+
+esp_err_t uart_driver_install(uart_port_t port, int rxBufferSize, int txBufferSize, int queueSize,
+                              QueueHandle_t* queue, int intrAllocFlags);
+esp_err_t uart_driver_delete(uart_port_t port);
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t* config);
+esp_err_t uart_set_pin(uart_port_t port, int txPin, int rxPin, int rtsPin, int ctsPin);
+int uart_read_bytes(uart_port_t port, void* buffer, uint32_t length, TickType_t ticksToWait);
+int uart_write_bytes(uart_port_t port, const void* data, size_t size);
+esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t* size);
+
+// Терминал, который играет роль порта (до uart_driver_install)
+void hostSetUartDevice(uart_port_t port, const char* path);
+
+#endif // HOST_DRIVER_UART_H
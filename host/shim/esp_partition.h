@@ -0,0 +1,38 @@
+#ifndef HOST_ESP_PARTITION_H
+#define HOST_ESP_PARTITION_H
+
+#include <cstddef>
+#include <cstdint>
+#include "esp_system.h"
+#include "esp_spi_flash.h"
+
+// Разделы flash на хосте: раздел с меткой сопоставляется файлу,
+// esp_partition_mmap() отображает файл через mmap только для чтения
+
+typedef enum {
+    ESP_PARTITION_TYPE_APP = 0x00,
+    ESP_PARTITION_TYPE_DATA = 0x01,
+} esp_partition_type_t;
+
+typedef enum {
+    ESP_PARTITION_SUBTYPE_ANY = 0xff,
+} esp_partition_subtype_t;
+
+typedef struct {
+    esp_partition_type_t type;
+    esp_partition_subtype_t subtype;
+    uint32_t address;
+    uint32_t size;
+    char label[17];
+} esp_partition_t;
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label);
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             spi_flash_mmap_memory_t memory, const void** outPtr,
+                             spi_flash_mmap_handle_t* outHandle);
+
+// Файл, который играет роль раздела label (nullptr — убрать раздел)
+void hostSetPartitionFile(const char* label, const char* path);
+
+#endif // HOST_ESP_PARTITION_H
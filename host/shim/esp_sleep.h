@@ -0,0 +1,10 @@
+#ifndef HOST_ESP_SLEEP_H
+#define HOST_ESP_SLEEP_H
+
+#include "esp_system.h"
+
+// Light sleep на хосте просто сдвигает симулированные часы
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t timeUs);
+esp_err_t esp_light_sleep_start();
+
+#endif // HOST_ESP_SLEEP_H
@@ -0,0 +1,26 @@
+#ifndef HOST_CLOCK_HPP
+#define HOST_CLOCK_HPP
+
+#include <cstdint>
+#include "config.hpp"
+
+// Симулированные часы хостовой сборки.
+// Время двигают только операции, которые занимают время на устройстве:
+// выборка АЦП, передача кадра в ленту, задержки и сон. Работа CPU не
+// моделируется, поэтому хостовые замеры показывают задержку конвейера.
+class HostClock {
+public:
+    static uint64_t now();              // Текущее время, мкс
+    static void advance(uint64_t us);   // Сдвинуть время вперёд
+    // Перевести часы, в том числе назад: так другая задача работает
+    // на своей линии времени, не сдвигая часы вызывающего
+    static void set(uint64_t us);
+};
+
+// Стоимость операций в модели, мкс
+// Одно чтение АЦП — период отсчёта с учётом передискретизации и числа каналов
+constexpr uint32_t HOST_ADC_READ_NS = 1000000000UL / (SAMPLING_FREQUENCY * ADC_OVERSAMPLING * (STEREO_INPUT ? 2 : 1));
+constexpr uint32_t HOST_LED_BIT_TIME_NS = 1250;           // WS2812: 1.25 мкс на бит
+constexpr uint32_t HOST_LED_RESET_US = 50;                // Пауза сброса после кадра
+
+#endif // HOST_CLOCK_HPP
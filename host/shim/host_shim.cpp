@@ -0,0 +1,598 @@
+// Реализация хостовой замены Arduino / FastLED / NVS / flash / FreeRTOS
+
+#include "Arduino.h"
+#include "FastLED.h"
+#include "Preferences.h"
+#include "esp_heap_caps.h"
+#include "esp_partition.h"
+#include "driver/uart.h"
+#include "esp_sleep.h"
+#include "nvs_flash.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include <cstdarg>
+#include <chrono>
+#include <map>
+#include <string>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ======================
+//    Часы
+// ======================
+static uint64_t hostTimeUs = 0;
+
+uint64_t HostClock::now() {
+    return hostTimeUs;
+}
+
+void HostClock::advance(uint64_t us) {
+    hostTimeUs += us;
+}
+
+void HostClock::set(uint64_t us) {
+    hostTimeUs = us;
+}
+
+unsigned long millis() {
+    return (unsigned long)(hostTimeUs / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)hostTimeUs;
+}
+
+void delay(uint32_t ms) {
+    HostClock::advance((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(uint32_t us) {
+    HostClock::advance(us);
+}
+
+// ======================
+//    Arduino
+// ======================
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    const long dividend = out_max - out_min;
+    const long divisor = in_max - in_min;
+    if (divisor == 0) {
+        return -1;
+    }
+    return (x - in_min) * dividend / divisor + out_min;
+}
+
+static uint32_t randomState = 1;
+
+void randomSeed(unsigned long seed) {
+    randomState = seed ? (uint32_t)seed : 1;
+}
+
+long random(long howbig) {
+    if (howbig <= 0) {
+        return 0;
+    }
+    // xorshift32 — детерминированный и одинаковый на всех хостах
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return randomState % howbig;
+}
+
+long random(long howsmall, long howbig) {
+    if (howsmall >= howbig) {
+        return howsmall;
+    }
+    return random(howbig - howsmall) + howsmall;
+}
+
+static uint16_t defaultAdcSource(uint8_t) {
+    return 2048;
+}
+
+static HostAdcSource adcSource = defaultAdcSource;
+
+void hostSetAdcSource(HostAdcSource source) {
+    adcSource = source ? source : defaultAdcSource;
+}
+
+uint16_t analogRead(uint8_t pin) {
+    static uint32_t remainderNs = 0;
+    remainderNs += HOST_ADC_READ_NS;
+    HostClock::advance(remainderNs / 1000);
+    remainderNs %= 1000;
+    return adcSource(pin);
+}
+
+void pinMode(uint8_t, uint8_t) {}
+void analogReadResolution(uint8_t) {}
+void analogSetAttenuation(int) {}
+
+size_t getArduinoLoopTaskStackSize() {
+    return 8192;
+}
+
+EspClass ESP;
+
+uint32_t EspClass::getCycleCount() {
+    auto elapsed = std::chrono::steady_clock::now().time_since_epoch();
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+}
+
+HardwareSerial Serial;
+
+void HardwareSerial::begin(unsigned long, uint32_t, int8_t, int8_t) {}
+
+size_t HardwareSerial::print(const char* s) {
+    return fputs(s, stdout) < 0 ? 0 : strlen(s);
+}
+
+size_t HardwareSerial::println(const char* s) {
+    size_t n = print(s);
+    fputc('\n', stdout);
+    return n + 1;
+}
+
+size_t HardwareSerial::printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int n = vprintf(format, args);
+    va_end(args);
+    return n < 0 ? 0 : (size_t)n;
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    return fputc(c, stdout) == EOF ? 0 : 1;
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t size) {
+    return fwrite(data, 1, size, stdout);
+}
+
+int HardwareSerial::available() {
+    return 0;
+}
+
+int HardwareSerial::read() {
+    return -1;
+}
+
+void HardwareSerial::flush() {
+    fflush(stdout);
+}
+
+// ======================
+//    ESP-IDF
+// ======================
+uint32_t esp_get_free_heap_size() { return 0; }
+uint32_t esp_get_minimum_free_heap_size() { return 0; }
+size_t heap_caps_get_free_size(uint32_t) { return 0; }
+size_t heap_caps_get_minimum_free_size(uint32_t) { return 0; }
+size_t heap_caps_get_largest_free_block(uint32_t) { return 0; }
+esp_err_t nvs_flash_init() { return ESP_OK; }
+esp_err_t nvs_flash_erase() { return ESP_OK; }
+
+static uint64_t sleepWakeupUs = 0;
+
+esp_err_t esp_sleep_enable_timer_wakeup(uint64_t timeUs) {
+    sleepWakeupUs = timeUs;
+    return ESP_OK;
+}
+
+esp_err_t esp_light_sleep_start() {
+    HostClock::advance(sleepWakeupUs);
+    return ESP_OK;
+}
+
+// Разделы: метка -> файл; раздел занимает весь файл
+struct HostPartition {
+    esp_partition_t partition;
+    std::string path;
+};
+
+static std::map<std::string, HostPartition>& partitionTable() {
+    static std::map<std::string, HostPartition> table;
+    return table;
+}
+
+struct HostMapping {
+    void* address;
+    size_t size;
+};
+
+static std::map<spi_flash_mmap_handle_t, HostMapping>& mappings() {
+    static std::map<spi_flash_mmap_handle_t, HostMapping> table;
+    return table;
+}
+
+void hostSetPartitionFile(const char* label, const char* path) {
+    if (!path) {
+        partitionTable().erase(label);
+        return;
+    }
+    HostPartition entry = {};
+    entry.partition.type = ESP_PARTITION_TYPE_DATA;
+    entry.partition.subtype = ESP_PARTITION_SUBTYPE_ANY;
+    snprintf(entry.partition.label, sizeof(entry.partition.label), "%s", label);
+    entry.path = path;
+    partitionTable()[label] = entry;
+}
+
+const esp_partition_t* esp_partition_find_first(esp_partition_type_t type, esp_partition_subtype_t subtype,
+                                                const char* label) {
+    auto it = partitionTable().find(label ? label : "");
+    if (it == partitionTable().end() || it->second.partition.type != type) {
+        return nullptr;
+    }
+    (void)subtype;
+    // Размер раздела — текущий размер файла
+    struct stat st;
+    if (stat(it->second.path.c_str(), &st) != 0) {
+        return nullptr;
+    }
+    it->second.partition.size = (uint32_t)st.st_size;
+    return &it->second.partition;
+}
+
+esp_err_t esp_partition_mmap(const esp_partition_t* partition, size_t offset, size_t size,
+                             spi_flash_mmap_memory_t, const void** outPtr, spi_flash_mmap_handle_t* outHandle) {
+    auto it = partitionTable().find(partition->label);
+    if (it == partitionTable().end() || offset + size > partition->size || size == 0) {
+        return ESP_FAIL;
+    }
+    int fd = open(it->second.path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return ESP_FAIL;
+    }
+    // Смещение mmap должно быть кратно странице
+    size_t pageOffset = offset % (size_t)sysconf(_SC_PAGESIZE);
+    void* address = mmap(nullptr, size + pageOffset, PROT_READ, MAP_PRIVATE, fd, offset - pageOffset);
+    close(fd);
+    if (address == MAP_FAILED) {
+        return ESP_FAIL;
+    }
+    static spi_flash_mmap_handle_t nextHandle = 1;
+    spi_flash_mmap_handle_t handle = nextHandle++;
+    mappings()[handle] = {address, size + pageOffset};
+    *outPtr = static_cast<uint8_t*>(address) + pageOffset;
+    *outHandle = handle;
+    return ESP_OK;
+}
+
+void spi_flash_munmap(spi_flash_mmap_handle_t handle) {
+    auto it = mappings().find(handle);
+    if (it != mappings().end()) {
+        munmap(it->second.address, it->second.size);
+        mappings().erase(it);
+    }
+}
+
+// UART: порт -> терминал. Чтение ждёт через poll() и двигает
+// симулированные часы на реально прошедшее время ожидания.
+struct HostUart {
+    std::string path;
+    int fd = -1;
+};
+
+static std::map<uart_port_t, HostUart>& uartTable() {
+    static std::map<uart_port_t, HostUart> table;
+    return table;
+}
+
+static int uartDescriptor(uart_port_t port) {
+    auto it = uartTable().find(port);
+    return it == uartTable().end() ? -1 : it->second.fd;
+}
+
+void hostSetUartDevice(uart_port_t port, const char* path) {
+    uartTable()[port].path = path;
+}
+
+esp_err_t uart_driver_install(uart_port_t port, int, int, int, QueueHandle_t* queue, int) {
+    auto it = uartTable().find(port);
+    if (it == uartTable().end() || it->second.fd >= 0) {
+        return ESP_FAIL;
+    }
+    int fd = open(it->second.path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd < 0) {
+        return ESP_FAIL;
+    }
+    // Сырой режим: без эха и построчной буферизации
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+    it->second.fd = fd;
+    if (queue) {
+        *queue = nullptr;
+    }
+    return ESP_OK;
+}
+
+esp_err_t uart_driver_delete(uart_port_t port) {
+    auto it = uartTable().find(port);
+    if (it == uartTable().end() || it->second.fd < 0) {
+        return ESP_FAIL;
+    }
+    close(it->second.fd);
+    it->second.fd = -1;
+    return ESP_OK;
+}
+
+esp_err_t uart_param_config(uart_port_t port, const uart_config_t*) {
+    return uartTable().count(port) ? ESP_OK : ESP_FAIL;
+}
+
+esp_err_t uart_set_pin(uart_port_t port, int, int, int, int) {
+    return uartTable().count(port) ? ESP_OK : ESP_FAIL;
+}
+
+int uart_read_bytes(uart_port_t port, void* buffer, uint32_t length, TickType_t ticksToWait) {
+    int fd = uartDescriptor(port);
+    if (fd < 0) {
+        return -1;
+    }
+    auto start = std::chrono::steady_clock::now();
+    auto deadline = start + std::chrono::milliseconds((uint64_t)ticksToWait * portTICK_PERIOD_MS);
+    uint32_t received = 0;
+    while (received < length) {
+        ssize_t n = read(fd, static_cast<uint8_t*>(buffer) + received, length - received);
+        if (n > 0) {
+            received += n;
+            continue;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            break;
+        }
+        struct pollfd pfd = {fd, POLLIN, 0};
+        int waitMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+        if (poll(&pfd, 1, std::max(waitMs, 1)) <= 0 || !(pfd.revents & POLLIN)) {
+            break;
+        }
+    }
+    auto waited = std::chrono::steady_clock::now() - start;
+    HostClock::advance(std::chrono::duration_cast<std::chrono::microseconds>(waited).count());
+    return (int)received;
+}
+
+int uart_write_bytes(uart_port_t port, const void* data, size_t size) {
+    int fd = uartDescriptor(port);
+    return fd < 0 ? -1 : (int)write(fd, data, size);
+}
+
+esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t* size) {
+    int fd = uartDescriptor(port);
+    int available = 0;
+    if (fd < 0 || ioctl(fd, FIONREAD, &available) != 0) {
+        return ESP_FAIL;
+    }
+    *size = (size_t)available;
+    return ESP_OK;
+}
+
+// ======================
+//    FreeRTOS
+// ======================
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t, const char* name, uint32_t, void*, UBaseType_t,
+                                   TaskHandle_t* handle, BaseType_t) {
+    fprintf(stderr, "[Host] Task '%s' is not started on host\n", name);
+    if (handle) {
+        *handle = nullptr;
+    }
+    return pdFAIL;
+}
+
+void vTaskDelete(TaskHandle_t) {}
+
+void vTaskDelay(TickType_t ticks) {
+    HostClock::advance((uint64_t)ticks * portTICK_PERIOD_MS * 1000);
+}
+
+void vTaskDelayUntil(TickType_t* previousWakeTime, TickType_t timeIncrement) {
+    TickType_t wakeTime = *previousWakeTime + timeIncrement;
+    TickType_t now = xTaskGetTickCount();
+    if ((int32_t)(wakeTime - now) > 0) {
+        vTaskDelay(wakeTime - now);
+    }
+    *previousWakeTime = wakeTime;
+}
+
+TickType_t xTaskGetTickCount() {
+    return (TickType_t)(hostTimeUs / (portTICK_PERIOD_MS * 1000));
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle() { return nullptr; }
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t) { return 0; }
+BaseType_t xPortGetCoreID() { return 1; }
+const char* pcTaskGetName(TaskHandle_t) { return "main"; }
+
+BaseType_t xTaskNotifyGive(TaskHandle_t) { return pdPASS; }
+uint32_t ulTaskNotifyTake(BaseType_t, TickType_t) { return 0; }
+BaseType_t xTaskNotify(TaskHandle_t, uint32_t, eNotifyAction) { return pdPASS; }
+BaseType_t xTaskNotifyWait(uint32_t, uint32_t, uint32_t*, TickType_t) { return pdFALSE; }
+
+struct HostEventGroup {
+    EventBits_t bits = 0;
+};
+
+EventGroupHandle_t xEventGroupCreate() {
+    return new HostEventGroup();
+}
+
+void vEventGroupDelete(EventGroupHandle_t group) {
+    delete group;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits) {
+    return group->bits |= bits;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits) {
+    EventBits_t previous = group->bits;
+    group->bits &= ~bits;
+    return previous;
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits, BaseType_t clearOnExit,
+                                BaseType_t waitForAll, TickType_t) {
+    EventBits_t current = group->bits;
+    bool satisfied = waitForAll ? (current & bits) == bits : (current & bits) != 0;
+    if (satisfied && clearOnExit) {
+        group->bits &= ~bits;
+    }
+    return current;
+}
+
+struct HostSemaphore {
+    bool available = false;
+};
+
+SemaphoreHandle_t xSemaphoreCreateBinary() {
+    return new HostSemaphore();
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t) {
+    if (!semaphore->available) {
+        return pdFALSE;
+    }
+    semaphore->available = false;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+    if (semaphore->available) {
+        return pdFALSE;
+    }
+    semaphore->available = true;
+    return pdTRUE;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+    delete semaphore;
+}
+
+// ======================
+//    NVS (Preferences)
+// ======================
+struct PrefValue {
+    enum Type { Float, Int, UChar } type;
+    union {
+        float f;
+        int32_t i;
+        uint8_t u8;
+    };
+};
+
+static std::map<std::string, PrefValue>& prefStore() {
+    static std::map<std::string, PrefValue> store;
+    return store;
+}
+
+bool Preferences::begin(const char* name, bool, const char*) {
+    space = name;
+    started = true;
+    return true;
+}
+
+void Preferences::end() {
+    started = false;
+}
+
+bool Preferences::clear() {
+    auto& store = prefStore();
+    const std::string prefix = space + "/";
+    for (auto it = store.begin(); it != store.end();) {
+        it = it->first.compare(0, prefix.size(), prefix) == 0 ? store.erase(it) : std::next(it);
+    }
+    return true;
+}
+
+bool Preferences::isKey(const char* key) {
+    return prefStore().count(space + "/" + key) != 0;
+}
+
+size_t Preferences::putFloat(const char* key, float value) {
+    PrefValue v;
+    v.type = PrefValue::Float;
+    v.f = value;
+    prefStore()[space + "/" + key] = v;
+    return sizeof(value);
+}
+
+float Preferences::getFloat(const char* key, float defaultValue) {
+    auto it = prefStore().find(space + "/" + key);
+    return it != prefStore().end() && it->second.type == PrefValue::Float ? it->second.f : defaultValue;
+}
+
+size_t Preferences::putInt(const char* key, int32_t value) {
+    PrefValue v;
+    v.type = PrefValue::Int;
+    v.i = value;
+    prefStore()[space + "/" + key] = v;
+    return sizeof(value);
+}
+
+int32_t Preferences::getInt(const char* key, int32_t defaultValue) {
+    auto it = prefStore().find(space + "/" + key);
+    return it != prefStore().end() && it->second.type == PrefValue::Int ? it->second.i : defaultValue;
+}
+
+size_t Preferences::putUChar(const char* key, uint8_t value) {
+    PrefValue v;
+    v.type = PrefValue::UChar;
+    v.u8 = value;
+    prefStore()[space + "/" + key] = v;
+    return sizeof(value);
+}
+
+uint8_t Preferences::getUChar(const char* key, uint8_t defaultValue) {
+    auto it = prefStore().find(space + "/" + key);
+    return it != prefStore().end() && it->second.type == PrefValue::UChar ? it->second.u8 : defaultValue;
+}
+
+// ======================
+//    FastLED
+// ======================
+CFastLED FastLED;
+
+void CFastLED::show() {
+    // Передача кадра: 24 бита на светодиод плюс пауза сброса
+    HostClock::advance((uint64_t)controller.count * 24 * HOST_LED_BIT_TIME_NS / 1000 + HOST_LED_RESET_US);
+    frameCount++;
+}
+
+void fill_solid(CRGB* leds, int numToFill, const CRGB& color) {
+    for (int i = 0; i < numToFill; i++) {
+        leds[i] = color;
+    }
+}
+
+uint8_t scale8(uint8_t value, uint8_t scale) {
+    return ((uint16_t)value * (1 + scale)) >> 8;
+}
+
+// Приближение радужного HSV FastLED: шесть секторов по 256/6 оттенков
+void hsv2rgb_rainbow(const CHSV& hsv, CRGB& rgb) {
+    uint16_t h = (uint16_t)hsv.h * 6;
+    uint8_t sector = h >> 8;
+    uint8_t frac = h & 0xFF;
+    uint8_t v = hsv.v;
+    uint8_t p = scale8(v, 255 - hsv.s);
+    uint8_t q = scale8(v, 255 - scale8(hsv.s, frac));
+    uint8_t t = scale8(v, 255 - scale8(hsv.s, 255 - frac));
+    switch (sector) {
+        case 0:  rgb = CRGB(v, t, p); break;
+        case 1:  rgb = CRGB(q, v, p); break;
+        case 2:  rgb = CRGB(p, v, t); break;
+        case 3:  rgb = CRGB(p, q, v); break;
+        case 4:  rgb = CRGB(t, p, v); break;
+        default: rgb = CRGB(v, p, q); break;
+    }
+}
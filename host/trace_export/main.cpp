@@ -0,0 +1,285 @@
+// Перевод дампа трассы (TraceRecorder, сборка с TRACE_RECORDER=1) в JSON
+// формата Trace Event для chrome://tracing и ui.perfetto.dev.
+// Вход — запись Serial целиком: строки без "[Trace] " пропускаются.
+// Процесс трассы — ядро, поток — задача FreeRTOS. Такты каждого ядра
+// переводятся в микросекунды по ближайшей предыдущей записи Sync этого ядра,
+// поэтому времена двух ядер сопоставимы.
+//
+// trace_export [-n номер дампа] [-o trace.json] [файл]   без файла — stdin,
+//                                                       по умолчанию последний дамп
+
+#include <Arduino.h>
+#include "trace_format.hpp"
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include <unistd.h>
+
+struct TraceDump {
+    unsigned reason = 0;
+    unsigned cpuMHz = 0;
+    std::map<uint32_t, std::string> taskNames;
+    std::vector<std::vector<TraceRecord>> cores;
+};
+
+static const char* TRIGGER_NAMES[] = {"Command", "DeadlineMiss"};
+
+static bool parseRecord(const char* hex, TraceRecord& record) {
+    char field[9];
+    auto take = [&](int offset, int length) {
+        memcpy(field, hex + offset, length);
+        field[length] = '\0';
+        return (uint32_t)strtoul(field, nullptr, 16);
+    };
+    for (int i = 0; i < TRACE_RECORD_HEX; i++) {
+        if (!isxdigit((unsigned char)hex[i])) {
+            return false;
+        }
+    }
+    record.cycles = take(0, 8);
+    record.task = take(8, 8);
+    record.event = take(16, 2);
+    record.phase = take(18, 2);
+    record.arg = take(20, 4);
+    return record.event < (uint8_t)TraceEvent::Count && record.phase <= (uint8_t)TracePhase::Instant;
+}
+
+// Все дампы входа; оборванный (нет "end") отбрасывается
+static std::vector<TraceDump> readDumps(FILE* file) {
+    std::vector<TraceDump> dumps;
+    TraceDump current;
+    bool inDump = false;
+    char buffer[1024];
+    while (fgets(buffer, sizeof(buffer), file)) {
+        const char* line = strstr(buffer, "[Trace] ");
+        if (!line) {
+            continue;
+        }
+        line += 8;
+        unsigned a, b, c, d;
+        char name[64];
+        if (sscanf(line, "start %u %u %u %u", &a, &b, &c, &d) == 4) {
+            current = TraceDump();
+            current.reason = a;
+            current.cpuMHz = b ? b : 1;
+            inDump = true;
+        } else if (!inDump) {
+            continue;
+        } else if (sscanf(line, "task %x %63s", &a, name) == 2) {
+            current.taskNames[a] = name;
+        } else if (sscanf(line, "core %u %u", &a, &b) == 2) {
+            current.cores.resize(a + 1);
+        } else if (strncmp(line, "end", 3) == 0) {
+            dumps.push_back(current);
+            inDump = false;
+        } else if (!current.cores.empty()) {
+            for (const char* p = line; strlen(p) >= TRACE_RECORD_HEX; p += TRACE_RECORD_HEX) {
+                TraceRecord record;
+                if (!parseRecord(p, record)) {
+                    break;
+                }
+                current.cores.back().push_back(record);
+            }
+        }
+    }
+    return dumps;
+}
+
+struct Writer {
+    FILE* out;
+    bool first = true;
+
+    void event(const char* fields) {
+        fprintf(out, "%s\n    {%s}", first ? "" : ",", fields);
+        first = false;
+    }
+};
+
+// Время записей ядра в мкс от первой Sync дампа; пусто — у ядра нет Sync
+static std::vector<double> toMicros(const std::vector<TraceRecord>& records, uint32_t baseMicros, unsigned cpuMHz) {
+    std::vector<double> times;
+    const TraceRecord* sync = nullptr;
+    for (const TraceRecord& record : records) {
+        if (record.event == (uint8_t)TraceEvent::Sync) {
+            sync = &record; // Записи раньше первой Sync считаются от неё назад
+            break;
+        }
+    }
+    if (!sync) {
+        return times;
+    }
+    for (const TraceRecord& record : records) {
+        if (record.event == (uint8_t)TraceEvent::Sync) {
+            sync = &record;
+        }
+        times.push_back((double)(int32_t)(sync->task - baseMicros) +
+                        (double)(int32_t)(record.cycles - sync->cycles) / cpuMHz);
+    }
+    return times;
+}
+
+static void exportDump(const TraceDump& dump, FILE* out) {
+    uint32_t baseMicros = 0;
+    for (const auto& records : dump.cores) {
+        for (const TraceRecord& record : records) {
+            if (record.event == (uint8_t)TraceEvent::Sync) {
+                baseMicros = record.task;
+                break;
+            }
+        }
+    }
+    // Трасса начинается с нуля: самая ранняя запись любого ядра
+    std::vector<std::vector<double>> times;
+    double start = 0;
+    bool haveStart = false;
+    for (size_t core = 0; core < dump.cores.size(); core++) {
+        times.push_back(toMicros(dump.cores[core], baseMicros, dump.cpuMHz));
+        for (double ts : times.back()) {
+            start = haveStart ? std::min(start, ts) : ts;
+            haveStart = true;
+        }
+    }
+
+    std::map<uint32_t, int> threadIds;
+    for (const auto& task : dump.taskNames) {
+        int id = threadIds.size() + 1;
+        threadIds[task.first] = id;
+    }
+
+    Writer writer{out};
+    char fields[256];
+    fprintf(out, "{\n  \"displayTimeUnit\": \"ms\",\n  \"otherData\": {\"trigger\": \"%s\", \"cpuMHz\": %u},\n"
+                 "  \"traceEvents\": [",
+            dump.reason < 2 ? TRIGGER_NAMES[dump.reason] : "Unknown", dump.cpuMHz);
+
+    uint32_t unmatched = 0;
+    for (size_t core = 0; core < dump.cores.size(); core++) {
+        const auto& records = dump.cores[core];
+        snprintf(fields, sizeof(fields), "\"name\": \"process_name\", \"ph\": \"M\", \"pid\": %u, "
+                                         "\"args\": {\"name\": \"Core %u\"}", (unsigned)core, (unsigned)core);
+        writer.event(fields);
+        std::map<uint32_t, bool> namedThreads;
+
+        if (times[core].empty()) {
+            if (!records.empty()) {
+                fprintf(stderr, "[TraceExport] Core %u has no Sync record, skipped\n", (unsigned)core);
+            }
+            continue;
+        }
+
+        std::map<uint32_t, std::vector<uint8_t>> open; // Открытые отрезки по задачам
+        for (size_t i = 0; i < records.size(); i++) {
+            const TraceRecord& record = records[i];
+            if (record.event == (uint8_t)TraceEvent::Sync) {
+                continue;
+            }
+            double ts = times[core][i] - start;
+            if (!threadIds.count(record.task)) {
+                int id = threadIds.size() + 1;
+                threadIds[record.task] = id;
+            }
+            int tid = threadIds[record.task];
+            if (!namedThreads[record.task]) {
+                namedThreads[record.task] = true;
+                auto name = dump.taskNames.find(record.task);
+                snprintf(fields, sizeof(fields), "\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %u, \"tid\": %d, "
+                                                 "\"args\": {\"name\": \"%s\"}", (unsigned)core, tid,
+                         name != dump.taskNames.end() ? name->second.c_str() : "unknown");
+                writer.event(fields);
+            }
+
+            const char* eventName = TRACE_EVENT_NAMES[record.event];
+            const char* category = TRACE_EVENT_CATEGORIES[record.event];
+            std::vector<uint8_t>& stack = open[record.task];
+            switch ((TracePhase)record.phase) {
+                case TracePhase::Begin:
+                    stack.push_back(record.event);
+                    snprintf(fields, sizeof(fields), "\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"B\", "
+                                                     "\"ts\": %.3f, \"pid\": %u, \"tid\": %d",
+                             eventName, category, ts, (unsigned)core, tid);
+                    break;
+                case TracePhase::End:
+                    // Начало отрезка могло вытесниться из кольца
+                    if (stack.empty() || stack.back() != record.event) {
+                        unmatched++;
+                        continue;
+                    }
+                    stack.pop_back();
+                    snprintf(fields, sizeof(fields), "\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"E\", "
+                                                     "\"ts\": %.3f, \"pid\": %u, \"tid\": %d",
+                             eventName, category, ts, (unsigned)core, tid);
+                    break;
+                case TracePhase::Instant:
+                    if (record.event == (uint8_t)TraceEvent::Trigger) {
+                        snprintf(fields, sizeof(fields), "\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"i\", "
+                                                         "\"s\": \"g\", \"ts\": %.3f, \"pid\": %u, \"tid\": %d, "
+                                                         "\"args\": {\"reason\": \"%s\"}",
+                                 eventName, category, ts, (unsigned)core, tid,
+                                 record.arg < 2 ? TRIGGER_NAMES[record.arg] : "Unknown");
+                    } else {
+                        snprintf(fields, sizeof(fields), "\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"i\", "
+                                                         "\"s\": \"t\", \"ts\": %.3f, \"pid\": %u, \"tid\": %d, "
+                                                         "\"args\": {\"value\": %u}",
+                                 eventName, category, ts, (unsigned)core, tid, record.arg);
+                    }
+                    break;
+            }
+            writer.event(fields);
+        }
+        fprintf(stderr, "[TraceExport] Core %u: %u records\n", (unsigned)core, (unsigned)records.size());
+    }
+    fprintf(out, "\n  ]\n}\n");
+    if (unmatched) {
+        fprintf(stderr, "[TraceExport] %u end events without a recorded begin dropped\n", unmatched);
+    }
+}
+
+int main(int argc, char** argv) {
+    int index = -1;
+    const char* outputPath = nullptr;
+    int opt;
+    while ((opt = getopt(argc, argv, "n:o:h")) != -1) {
+        switch (opt) {
+            case 'n': index = atoi(optarg); break;
+            case 'o': outputPath = optarg; break;
+            default:
+                fprintf(stderr, "usage: trace_export [-n dump index] [-o trace.json] [capture.txt]\n");
+                return 2;
+        }
+    }
+
+    FILE* in = optind < argc ? fopen(argv[optind], "r") : stdin;
+    if (!in) {
+        fprintf(stderr, "[TraceExport] Cannot open %s\n", argv[optind]);
+        return 1;
+    }
+    std::vector<TraceDump> dumps = readDumps(in);
+    if (in != stdin) {
+        fclose(in);
+    }
+    if (dumps.empty()) {
+        fprintf(stderr, "[TraceExport] No complete trace dump found\n");
+        return 1;
+    }
+    if (index < 0) {
+        index = dumps.size() - 1;
+    }
+    if (index >= (int)dumps.size()) {
+        fprintf(stderr, "[TraceExport] Only %u dumps in input\n", (unsigned)dumps.size());
+        return 1;
+    }
+
+    FILE* out = outputPath ? fopen(outputPath, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "[TraceExport] Cannot write %s\n", outputPath);
+        return 1;
+    }
+    fprintf(stderr, "[TraceExport] Dump %d of %u, trigger %s\n", index, (unsigned)dumps.size(),
+            dumps[index].reason < 2 ? TRIGGER_NAMES[dumps[index].reason] : "Unknown");
+    exportDump(dumps[index], out);
+    if (out != stdout) {
+        fclose(out);
+    }
+    return 0;
+}
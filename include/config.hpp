@@ -4,17 +4,160 @@
 // Настройки пинов
 #define LED_PIN 18
 #define MIC_PIN 34
+#define MIC2_PIN 35 // Второй микрофон (канал B) в стереорежиме
 
 // Настройки матрицы
 #define MATRIX_WIDTH 10
 #define MATRIX_HEIGHT 9
 #define NUM_LEDS (MATRIX_WIDTH * MATRIX_HEIGHT)
 #define BRIGHTNESS 50
-#define UPDATE_INTERVAL (1000 / 50) // 50 FPS
+#define RENDER_RATE 60             // Частота отрисовки по умолчанию, Гц (меняется во время работы)
+#define ANALYSIS_RATE 30           // Частота анализа по умолчанию, Гц
+#define MAX_RENDER_RATE 120
+#define REFERENCE_FRAME_RATE 50    // Частота, под которую подобраны покадровые параметры анимаций
+#define UPDATE_INTERVAL (1000 / RENDER_RATE) // Период кадра при частоте по умолчанию, мс
+#define TEXT_MAX_COLUMNS 256 // Длина растровой ленты бегущей строки, столбцов
+#define PARTICLE_POOL_SIZE NUM_LEDS // Ёмкость пула частиц (звёзд)
+#define SPECTRUM_HISTORY_DEPTH (MATRIX_HEIGHT * 4) // Снимков спектра в истории спектрограммы
+#define SPECTRUM_HISTORY_BITS 4     // Бит на полосу в снимке: 1, 2, 4 или 8
+
+// Клипы: заранее отрисованные кадры в разделе flash (см. partitions.csv)
+#define CLIP_PARTITION_LABEL "clips"
+#define CLIP_PARTITION_SIZE 0x170000
 
 // Настройки аудиоанализатора
 #define SAMPLES 128 // Количество отсчетов для FFT 
 #define SAMPLING_FREQUENCY 8000   // Частота дискретизации
+#ifndef ANALYZER_SAMPLE_TYPE
+#define ANALYZER_SAMPLE_TYPE double // Тип отсчётов FFT анализатора анимаций: float или double
+#endif
+#define COARSE_FFT_SIZE (SAMPLES / 2) // Грубый анализатор (CoarseAnalyzer)
+#define COARSE_BAND_COUNT 4
+#define FINE_FFT_SIZE (SAMPLES * 2)   // Точный анализатор (FineAnalyzer)
+#ifndef STEREO_INPUT
+#define STEREO_INPUT 0            // 1 — два микрофона (MIC_PIN и MIC2_PIN) в одном комплексном FFT
+#endif
+#ifndef ADC_OVERSAMPLING
+#define ADC_OVERSAMPLING 8        // Чтений АЦП на отсчёт: 1 — без передискретизации, 4/8/16 — CIC-децимация
+#endif
+
+// Темп по огибающей энергии (TempoTracker в каждом анализаторе)
+#ifndef TEMPO_TRACKER
+#define TEMPO_TRACKER 1           // 0 — без оценки темпа, анимации идут со своей скоростью
+#endif
+#define TEMPO_ENVELOPE_RATE 25    // Отсчётов огибающей в секунду (не выше частоты анализа)
+#define TEMPO_ENVELOPE_SIZE 128   // Длина огибающей, степень двойки (~5 с)
+#define TEMPO_UPDATE_INTERVAL 12  // Новых отсчётов огибающей между оценками темпа (~0.5 с)
+#define TEMPO_MIN_BPM 60
+#define TEMPO_MAX_BPM 180
+
+// Режим простоя при тишине
+#define SILENCE_HOLD_TIME (10 * 1000) // Тишина дольше этого времени переводит в простой, мс
+#define IDLE_PROBE_INTERVAL 100       // Период проверки звука в простое, мс
+#define IDLE_LIGHT_SLEEP 1            // 1 — light sleep между проверками, 0 — обычная задержка
+
+// Бенчмарк задержки звук -> светодиоды (включается флагом сборки)
+#ifndef LATENCY_BENCHMARK
+#define LATENCY_BENCHMARK 0
+#endif
+#define LATENCY_TRIALS 50 // Импульсов на каждую анимацию
+
+// Трасса этапов с тактами CPU (включается флагом сборки), см. TraceRecorder и host/trace_export
+#ifndef TRACE_RECORDER
+#define TRACE_RECORDER 0
+#endif
+#define TRACE_RECORDS_PER_CORE 512   // Записей в кольце ядра (степень двойки), по 12 байт
+#define TRACE_POST_TRIGGER 128       // Записей после срабатывания, затем запись замирает до дампа
+#define TRACE_ON_DEADLINE_MISS 1     // 1 — срабатывать по кадру отрисовки дольше бюджета
+#define TRACE_SYNC_CYCLES (1u << 28) // Тактов между привязками к micros() (~1.1 с при 240 МГц)
+
+// Отложенный лог: записи в кольцо своего ядра, вывод — задача с низким приоритетом
+#ifndef LOG_LEVEL
+#define LOG_LEVEL 3               // Подробнейший уровень в сборке: 0 — ошибки, 1 — предупреждения, 2 — инфо, 3 — отладка
+#endif
+#ifndef LOG_BINARY
+#define LOG_BINARY 0              // 1 — записи уходят в Serial двоичными, текст собирает host/log_decoder
+#endif
+#define LOG_RING_WORDS 512        // Слов в кольце каждого ядра (степень двойки)
+#define LOG_DRAIN_INTERVAL 20     // Период вывода накопленных записей, мс
+
+// Приём кадров по UART от внешнего контроллера шоу (Adalight / TPM2)
+#ifndef FRAME_INGEST
+#define FRAME_INGEST 0            // 1 — матрицей управляет FrameIngest вместо SoundAnimator
+#endif
+#define INGEST_UART_PORT 2
+#define INGEST_RX_PIN 16
+#define INGEST_TX_PIN 17
+#define INGEST_BAUD 921600
+#define INGEST_RX_BUFFER 4096     // Кольцевой буфер драйвера UART, байт
+#define INGEST_CHUNK_SIZE 256     // Байтов за одно чтение из кольца
+#define INGEST_FRAME_TIMEOUT 100  // Пауза внутри кадра, после которой он отбрасывается, мс
+#define INGEST_BLANK_TIMEOUT 5000 // Без кадров дольше этого матрица гаснет, мс
+
+// Настройки задач
+#define ANIM_TASK_STACK_SIZE 4096 // Размер стека задачи анимации (байт)
+#define ANALYSIS_TASK_STACK_SIZE 4096 // Размер стека задачи анализа звука (байт)
+#define ANALYSIS_TASK_CORE 0      // Анализ рядом с передачей кадра, отрисовка на ядре 1
+#define INGEST_TASK_STACK_SIZE 3072 // Размер стека задачи приёма кадров (байт)
+#define INGEST_SERVICE_TIMEOUT 20 // Ожидание UART за проход задачи приёма, мс: дольше не ждёт и команда задаче
+#define SHOW_TASK_STACK_SIZE 2048 // Размер стека задачи передачи кадра в ленту (байт)
+#define SHOW_TASK_PRIORITY 2      // Выше задачи анимации: передача стартует сразу
+#define SHOW_TASK_CORE 0          // Анимация на ядре 1, передача на ядре 0
+#define LOG_TASK_STACK_SIZE 3072  // Размер стека задачи вывода лога (байт)
+#define LOG_TASK_PRIORITY 0       // Уровень idle: ниже анимации, анализа и передачи кадра
+#define LOG_TASK_CORE 0
+#define TASK_COMMAND_TIMEOUT 1000 // Ожидание подтверждения команды задаче матрицы, мс
+#define MEMORY_REPORT_INTERVAL (10 * 1000) // Период отчёта о памяти, мс
+#define COMMAND_POLL_INTERVAL 100 // Период проверки команд Serial и готовой трассы в loop, мс
+
+// Бюджеты памяти объектов (байт), проверяются static_assert при сборке.
+// Бюджет — сумма массивов, размер которых задают настройки выше, и запаса
+// *_SCALARS на поля фиксированного размера (настройки, счётчики, указатели,
+// хэндлы, выравнивание; рассчитан на 64-битные указатели хост-сборок).
+// Массивы бюджет отслеживает сам; если объект не влезает из-за новых полей,
+// растёт запас его компонента — с пояснением, что добавилось.
+#define LED_FRAME_BYTES (NUM_LEDS * 3)               // Кадр CRGB
+#define LED_OUTPUT_LUT_BYTES (3 * 256 * 2)           // Таблицы выхода по каналам, uint16_t
+#define LED_MATRIX_SCALARS 224                       // Два ClipReader (текущий и запрошенный), поля слоёв, гамма, дизеринг,
+                                                     // хэндлы задачи и семафора
+#ifndef LED_MATRIX_RAM_BUDGET
+#define LED_MATRIX_RAM_BUDGET (2 * LED_FRAME_BYTES /* задний и передний кадры */ + \
+                               LED_FRAME_BYTES /* холст клипа */ + LED_OUTPUT_LUT_BYTES + \
+                               TEXT_MAX_COLUMNS /* лента бегущей строки */ + LED_MATRIX_SCALARS)
+#endif
+
+#define ANALYSIS_FRAME_BYTES (MATRIX_WIDTH * 8 + 64) // Кадр анализа: 4 массива полос uint16_t и ~60 байт величин кадра
+#define ANALYZER_CHANNEL_BYTES 128                   // Состояние входного канала: PreFilter (3 биквада) и CicDecimator
+#define ANALYZER_SCALARS 224                         // Preferences, настройки, статистика, источник отсчётов, объект FFT, поля цикла
+#define TEMPO_TRACKER_BYTES (TEMPO_ENVELOPE_SIZE * 4 /* огибающая */ + \
+                             TEMPO_ENVELOPE_SIZE * 2 * 2 * 4 /* FFT двойной длины, real и imag */ + \
+                             (TEMPO_ENVELOPE_RATE * 60 / TEMPO_MIN_BPM + 1) * 4 /* веса сдвигов */ + \
+                             96 /* объект FFT, время отсчётов, темп и фаза */)
+#ifndef AUDIO_ANALYZER_RAM_BUDGET
+#define AUDIO_ANALYZER_RAM_BUDGET (SAMPLES * 2 * sizeof(ANALYZER_SAMPLE_TYPE) /* vReal, vImag */ + \
+                                   MATRIX_WIDTH * 2 * 2 /* bands, smoothedBands */ + \
+                                   2 * ANALYSIS_FRAME_BYTES /* опубликованный и собираемый кадры */ + \
+                                   (1 + STEREO_INPUT) * ANALYZER_CHANNEL_BYTES + \
+                                   STEREO_INPUT * MATRIX_WIDTH * 2 * 2 /* полосы каналов A и B */ + \
+                                   TEMPO_TRACKER * TEMPO_TRACKER_BYTES + ANALYZER_SCALARS)
+#endif
+
+#define PARTICLE_POOL_BYTES (PARTICLE_POOL_SIZE * 14 + 8)  // 14 байт на частицу (SoA и списки) и головы списков
+#define COLOR_TABLE_BYTES (256 * 3 + 64)                   // Таблица цветов и палитра (до 12 опорных точек)
+#define SPECTRUM_HISTORY_BYTES (SPECTRUM_HISTORY_DEPTH * ((MATRIX_WIDTH * SPECTRUM_HISTORY_BITS + 7) / 8) + 4)
+#define FRAME_BLENDER_BYTES (3 * ANALYSIS_FRAME_BYTES + 56) // Два кадра анализа, смешанный кадр, 16 весов и указатели
+#define CONTROLLED_TASK_BYTES 64                           // Имя, параметры, хэндлы задачи и группы событий
+#define RENDER_CLOSURE_BYTES 32                            // std::function отрисовки
+#define SOUND_ANIMATOR_SCALARS 256                         // Preferences, настройки анимаций и их копии в фиксированной точке,
+                                                           // регуляторы качества, фаза волны и привязка к темпу, счётчики
+#ifndef SOUND_ANIMATOR_RAM_BUDGET
+#define SOUND_ANIMATOR_RAM_BUDGET (AUDIO_ANALYZER_RAM_BUDGET + PARTICLE_POOL_BYTES + \
+                                   2 * COLOR_TABLE_BYTES /* текущая и подготовленная анимации */ + \
+                                   SPECTRUM_HISTORY_BYTES + FRAME_BLENDER_BYTES + \
+                                   2 * CONTROLLED_TASK_BYTES /* задачи анимации и анализа */ + \
+                                   2 * RENDER_CLOSURE_BYTES /* текущая и подготовленная отрисовка */ + \
+                                   SOUND_ANIMATOR_SCALARS)
+#endif
 
 
 #endif // CONFIG_H
\ No newline at end of file
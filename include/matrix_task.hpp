@@ -1,15 +1,41 @@
 #ifndef MATRIX_TASK_HPP
 #define MATRIX_TASK_HPP
 
+#include "controlled_task.hpp"
+
+// Задача, которая ведёт матрицу. Задачи FreeRTOS создаются один раз
+// и переходы между состояниями только отдают им команды (см. ControlledTask),
+// каждый завершается не дольше чем за кадр.
 class MatrixTask {
 public:
     virtual ~MatrixTask() = default;
 
-    // Метод для запуска задачи
+    // Метод для запуска задачи (из Stopped — с начала, из Paused — как resumeTask)
     virtual void startTask() = 0;
 
-    // Метод для остановки задачи
+    // Метод для остановки задачи; матрица гасится
     virtual void stopTask() = 0;
+
+    // Пауза: задача стоит, кадр остаётся на матрице, состояние сохраняется
+    virtual void pauseTask() = 0;
+    virtual void resumeTask() = 0;
+
+    virtual TaskState getTaskState() const = 0;
+
+    // Горячая замена: эта задача встаёт на паузу с последним кадром на матрице,
+    // следующая продолжает с того места, где её оставили, или запускается.
+    // Обе задачи не рисуют одновременно ни в один момент.
+    void handOver(MatrixTask& next) {
+        if (&next == this) {
+            return;
+        }
+        pauseTask();
+        if (next.getTaskState() == TaskState::Paused) {
+            next.resumeTask();
+        } else {
+            next.startTask();
+        }
+    }
 };
 
 #endif // MATRIX_TASK_HPP
\ No newline at end of file
@@ -1,17 +1,17 @@
 #include "audio_analyzer.hpp"
+#include "latency_probe.hpp"
+#include "trace_recorder.hpp"
+#include "deferred_log.hpp"
 #include <nvs_flash.h>
 #include <cmath>
 #include <Arduino.h>
 
-AudioAnalyzer::AudioAnalyzer()
-    : FFT(vReal, vImag, SAMPLES, SAMPLING_FREQUENCY),
-      minLogPower(FLT_MAX),
+AudioAnalyzerBase::AudioAnalyzerBase()
+    : minLogPower(FLT_MAX),
       maxLogPower(FLT_MIN),
-      sampleCount(0) { // Инициализация FFT
-    // Инициализация массивов частотных полос
-    memset(bands, 0, sizeof(bands));
-    memset(smoothedBands, 0, sizeof(smoothedBands));
-
+      sampleCount(0),
+      silent(false),
+      silenceStartTime(0) {
     // Инициализация настроек по умолчанию
     sensitivityReduction = DEFAULT_SENSITIVITY_REDUCTION;
     lowFreqGain = DEFAULT_LOW_FREQ_GAIN;
@@ -23,117 +23,158 @@ AudioAnalyzer::AudioAnalyzer()
     noiseThresholdRatio = DEFAULT_NOISE_THRESHOLD_RATIO;
     bandDecay = DEFAULT_BAND_DECAY;
     bandCeiling = DEFAULT_BAND_CEILING;
+    silenceMargin = DEFAULT_SILENCE_MARGIN;
+    lowPassCutoff = DEFAULT_LOW_PASS_CUTOFF;
+    preEmphasis = DEFAULT_PRE_EMPHASIS;
+    configurePreFilter();
+
+#if ADC_OVERSAMPLING > 1
+    for (CicDecimator& decimator : decimators) {
+        if (!decimator.setRatio(ADC_OVERSAMPLING)) {
+            LOG(AnalyzerBadOversampling, ADC_OVERSAMPLING);
+        }
+    }
+#endif
 }
 
-AudioAnalyzer::~AudioAnalyzer() {
+AudioAnalyzerBase::~AudioAnalyzerBase() {
     preferences.end();
 }
 
-void AudioAnalyzer::begin() {
-    Serial.println("[AudioAnalyzer] Initializing...");
+void AudioAnalyzerBase::begin() {
+    LOG(AnalyzerInit);
     if (!preferences.begin("audioanalyzer", false)) {
-        Serial.println("[AudioAnalyzer] Failed to open preferences.");
+        LOG(AnalyzerPrefsFailed, "");
         return;
     }
     loadSettings();
-    Serial.println("[AudioAnalyzer] Initialization complete.");
+    LOG(AnalyzerReady);
 }
 
-void AudioAnalyzer::loadSettings() {
+void AudioAnalyzerBase::loadSettings() {
 
     if (!preferences.isKey("sensReduct")) {
-        Serial.println("[AudioAnalyzer] Key 'sensReduct' not found. Using default value.");
+        LOG(AnalyzerKeyMissing, "sensReduct");
         sensitivityReduction = DEFAULT_SENSITIVITY_REDUCTION;
         preferences.putFloat("sensReduct", sensitivityReduction);
     } else {
         sensitivityReduction = preferences.getFloat("sensReduct", DEFAULT_SENSITIVITY_REDUCTION);
     }
-    Serial.printf("[AudioAnalyzer] Loaded sensitivityReduction: %.2f\n", sensitivityReduction);
+    LOG(AnalyzerLoadedFloat, "sensitivityReduction", sensitivityReduction);
 
     if (!preferences.isKey("lowGain")) {
-        Serial.println("[AudioAnalyzer] Key 'lowGain' not found. Using default value.");
+        LOG(AnalyzerKeyMissing, "lowGain");
         lowFreqGain = DEFAULT_LOW_FREQ_GAIN;
         preferences.putFloat("lowGain", lowFreqGain);
     } else {
         lowFreqGain = preferences.getFloat("lowGain", DEFAULT_LOW_FREQ_GAIN);
     }
-    Serial.printf("[AudioAnalyzer] Loaded lowFreqGain: %.2f\n", lowFreqGain);
+    LOG(AnalyzerLoadedFloat, "lowFreqGain", lowFreqGain);
 
     if (!preferences.isKey("midGain")) {
-        Serial.println("[AudioAnalyzer] Key 'midGain' not found. Using default value.");
+        LOG(AnalyzerKeyMissing, "midGain");
         midFreqGain = DEFAULT_MID_FREQ_GAIN;
         preferences.putFloat("midGain", midFreqGain);
     } else {
         midFreqGain = preferences.getFloat("midGain", DEFAULT_MID_FREQ_GAIN);
     }
-    Serial.printf("[AudioAnalyzer] Loaded midFreqGain: %.2f\n", midFreqGain);
+    LOG(AnalyzerLoadedFloat, "midFreqGain", midFreqGain);
 
     if (!preferences.isKey("highGain")) {
-        Serial.println("[AudioAnalyzer] Key 'highGain' not found. Using default value.");
+        LOG(AnalyzerKeyMissing, "highGain");
         highFreqGain = DEFAULT_HIGH_FREQ_GAIN;
         preferences.putFloat("highGain", highFreqGain);
     } else {
         highFreqGain = preferences.getFloat("highGain", DEFAULT_HIGH_FREQ_GAIN);
     }
-    Serial.printf("[AudioAnalyzer] Loaded highFreqGain: %.2f\n", highFreqGain);
+    LOG(AnalyzerLoadedFloat, "highFreqGain", highFreqGain);
 
     if (!preferences.isKey("alpha")) {
-        Serial.println("[AudioAnalyzer] Key 'alpha' not found. Using default value.");
+        LOG(AnalyzerKeyMissing, "alpha");
         alpha = DEFAULT_ALPHA;
         preferences.putFloat("alpha", alpha);
     } else {
         alpha = preferences.getFloat("alpha", DEFAULT_ALPHA);
     }
-    Serial.printf("[AudioAnalyzer] Loaded alpha: %.2f\n", alpha);
+    LOG(AnalyzerLoadedFloat, "alpha", alpha);
 
     if (!preferences.isKey("fMin")) {
-        Serial.println("[AudioAnalyzer] Key 'fMin' not found. Using default value.");
+        LOG(AnalyzerKeyMissing, "fMin");
         fMin = DEFAULT_FMIN;
         preferences.putFloat("fMin", fMin);
     } else {
         fMin = preferences.getFloat("fMin", DEFAULT_FMIN);
     }
-    Serial.printf("[AudioAnalyzer] Loaded fMin: %.2f\n", fMin);
+    LOG(AnalyzerLoadedFloat, "fMin", fMin);
 
     if (!preferences.isKey("fMax")) {
-        Serial.println("[AudioAnalyzer] Key 'fMax' not found. Using default value.");
+        LOG(AnalyzerKeyMissing, "fMax");
         fMax = DEFAULT_FMAX;
         preferences.putFloat("fMax", fMax);
     } else {
         fMax = preferences.getFloat("fMax", DEFAULT_FMAX);
     }
-    Serial.printf("[AudioAnalyzer] Loaded fMax: %.2f\n", fMax);
+    LOG(AnalyzerLoadedFloat, "fMax", fMax);
 
     if (!preferences.isKey("nThresh")) {
-        Serial.println("[AudioAnalyzer] Key 'nThresh' not found. Using default value.");
+        LOG(AnalyzerKeyMissing, "nThresh");
         noiseThresholdRatio = DEFAULT_NOISE_THRESHOLD_RATIO;
         preferences.putFloat("nThresh", noiseThresholdRatio);
     } else {
         noiseThresholdRatio = preferences.getFloat("nThresh", DEFAULT_NOISE_THRESHOLD_RATIO);
     }
-    Serial.printf("[AudioAnalyzer] Loaded noiseThresholdRatio: %.2f\n", noiseThresholdRatio);
+    LOG(AnalyzerLoadedFloat, "noiseThresholdRatio", noiseThresholdRatio);
 
     if (!preferences.isKey("bDecay")) {
-        Serial.println("[AudioAnalyzer] Key 'bDecay' not found. Using default value.");
+        LOG(AnalyzerKeyMissing, "bDecay");
         bandDecay = DEFAULT_BAND_DECAY;
         preferences.putFloat("bDecay", bandDecay);
     } else {
         bandDecay = preferences.getFloat("bDecay", DEFAULT_BAND_DECAY);
     }
-    Serial.printf("[AudioAnalyzer] Loaded bandDecay: %.2f\n", bandDecay);
+    LOG(AnalyzerLoadedFloat, "bandDecay", bandDecay);
 
     if (!preferences.isKey("bCeil")) {
-        Serial.println("[AudioAnalyzer] Key 'bCeil' not found. Using default value.");
+        LOG(AnalyzerKeyMissing, "bCeil");
         bandCeiling = DEFAULT_BAND_CEILING;
         preferences.putInt("bCeil", bandCeiling);
     } else {
         bandCeiling = preferences.getInt("bCeil", DEFAULT_BAND_CEILING);
     }
-    Serial.printf("[AudioAnalyzer] Loaded bandCeiling: %d\n", bandCeiling);
+    LOG(AnalyzerLoadedInt, "bandCeiling", bandCeiling);
+
+    if (!preferences.isKey("silMargin")) {
+        LOG(AnalyzerKeyMissing, "silMargin");
+        silenceMargin = DEFAULT_SILENCE_MARGIN;
+        preferences.putFloat("silMargin", silenceMargin);
+    } else {
+        silenceMargin = preferences.getFloat("silMargin", DEFAULT_SILENCE_MARGIN);
+    }
+    LOG(AnalyzerLoadedFloat, "silenceMargin", silenceMargin);
+
+    if (!preferences.isKey("lpfCutoff")) {
+        LOG(AnalyzerKeyMissing, "lpfCutoff");
+        lowPassCutoff = DEFAULT_LOW_PASS_CUTOFF;
+        preferences.putFloat("lpfCutoff", lowPassCutoff);
+    } else {
+        lowPassCutoff = preferences.getFloat("lpfCutoff", DEFAULT_LOW_PASS_CUTOFF);
+    }
+    LOG(AnalyzerLoadedFloat, "lowPassCutoff", lowPassCutoff);
+
+    if (!preferences.isKey("preEmph")) {
+        LOG(AnalyzerKeyMissing, "preEmph");
+        preEmphasis = DEFAULT_PRE_EMPHASIS;
+        preferences.putFloat("preEmph", preEmphasis);
+    } else {
+        preEmphasis = preferences.getFloat("preEmph", DEFAULT_PRE_EMPHASIS);
+    }
+    LOG(AnalyzerLoadedFloat, "preEmphasis", preEmphasis);
+
+    configurePreFilter();
     preferences.end();
 }
 
-void AudioAnalyzer::updateSignalStats(float currentLogPower) {
+void AudioAnalyzerBase::updateSignalStats(float currentLogPower) {
     // Обновляем минимальное значение
     minLogPower = fminf(minLogPower, currentLogPower);
 
@@ -145,30 +186,26 @@ void AudioAnalyzer::updateSignalStats(float currentLogPower) {
     sampleCount++;
 }
 
-float AudioAnalyzer::getTotalLogRmsEnergy() {
-    float rmsSum = 0.0f;
-
-    for (int i = 0; i < SAMPLES / 2; i++) {
-        rmsSum += vReal[i] * vReal[i];
+void AudioAnalyzerBase::updateSilenceState(float currentLogPower) {
+    // Тишина — энергия держится у шумового пола, который отслеживает minLogPower
+    bool quiet = currentLogPower < minLogPower + silenceMargin;
+    if (!quiet) {
+        silent = false;
+        return;
     }
+    if (!silent) {
+        silent = true;
+        silenceStartTime = millis();
+    }
+}
 
-    float rms = sqrtf(rmsSum / (SAMPLES / 2));
-
-    // Вычисляем логарифмическую энергию, добавляя 1.0 для защиты от log(0)
-    float logEnergy = 10.0f * log10f(rms + 1.0f);
-
-    // Ограничиваем значение
-    logEnergy = constrain(logEnergy, 0.0f, (float)bandCeiling);
-
-    // Обновляем статистику сигнала
-    updateSignalStats(logEnergy);
-
-    return logEnergy;
+bool AudioAnalyzerBase::isSilent() const {
+    return silent && (millis() - silenceStartTime >= SILENCE_HOLD_TIME);
 }
 
-void AudioAnalyzer::resetSettings() {
+void AudioAnalyzerBase::resetSettings() {
     if (!preferences.begin("audioanalyzer", false)) {
-        Serial.println("[AudioAnalyzer] Failed to open preferences for resetting.");
+        LOG(AnalyzerPrefsFailed, " for resetting");
         return;
     }
     preferences.clear();
@@ -176,64 +213,66 @@ void AudioAnalyzer::resetSettings() {
     begin();
 }
 
-void AudioAnalyzer::saveSetting(const char* key, float value) {
+void AudioAnalyzerBase::saveSetting(const char* key, float value) {
+    TRACE_SCOPE(SettingsWrite);
     if (!preferences.begin("audioanalyzer", false)) {
-        Serial.println("[AudioAnalyzer] Failed to open preferences for saving.");
+        LOG(AnalyzerPrefsFailed, " for saving");
         return;
     }
 
     preferences.putFloat(key, value);
-    Serial.printf("[AudioAnalyzer] Saved %s: %.2f\n", key, value);
+    LOG(AnalyzerSavedFloat, key, value);
     preferences.end();
 }
 
 
-void AudioAnalyzer::saveSetting(const char* key, int value) {
+void AudioAnalyzerBase::saveSetting(const char* key, int value) {
+    TRACE_SCOPE(SettingsWrite);
     if (!preferences.begin("audioanalyzer", false)) {
-        Serial.println("[AudioAnalyzer] Failed to open preferences for saving.");
+        LOG(AnalyzerPrefsFailed, " for saving");
         return;
     }
     preferences.putInt(key, value);
-    Serial.printf("[AudioAnalyzer] Saved %s: %d\n", key, value);
+    LOG(AnalyzerSavedInt, key, value);
     preferences.end();
 }
 
-void AudioAnalyzer::setSensitivityReduction(float value) {
+void AudioAnalyzerBase::setSensitivityReduction(float value) {
     if (value >= 0.1f && value <= 100.0f) {
         sensitivityReduction = value;
         saveSetting("sensReduct", value);
     }
 }
 
-void AudioAnalyzer::setLowFreqGain(float value) {
+void AudioAnalyzerBase::setLowFreqGain(float value) {
     if (value >= 0.0f && value <= 10.0f) {
         lowFreqGain = value;
         saveSetting("lowGain", value);
     }
 }
 
-void AudioAnalyzer::setMidFreqGain(float value) {
+void AudioAnalyzerBase::setMidFreqGain(float value) {
     if (value >= 0.0f && value <= 10.0f) {
         midFreqGain = value;
         saveSetting("midGain", value);
     }
 }
 
-void AudioAnalyzer::setHighFreqGain(float value) {
+void AudioAnalyzerBase::setHighFreqGain(float value) {
     if (value >= 0.0f && value <= 10.0f) {
         highFreqGain = value;
         saveSetting("highGain", value);
     }
 }
 
-void AudioAnalyzer::setAlpha(float value) {
+void AudioAnalyzerBase::setAlpha(float value) {
     if (value >= 0.01f && value <= 1.0f) {
         alpha = value;
         saveSetting("alpha", value);
     }
 }
 
-void AudioAnalyzer::setFMin(float value) {
+void AudioAnalyzerBase::setFMin(float value) {
     if (value >= 10.0f && value <= 1000.0f) {
         fMin = value;
         saveSetting("fMin", value);
@@ -241,7 +280,7 @@ void AudioAnalyzer::setFMin(float value) {
 
 }
 
-void AudioAnalyzer::setFMax(float value) {
+void AudioAnalyzerBase::setFMax(float value) {
     if (value >= 1000.0f && value <= 30000.0f) {
         fMax = value;
         saveSetting("fMax", value);
@@ -249,14 +288,14 @@ void AudioAnalyzer::setFMax(float value) {
 
 }
 
-void AudioAnalyzer::setNoiseThresholdRatio(float value) {
+void AudioAnalyzerBase::setNoiseThresholdRatio(float value) {
     if (value >= 0.01f && value <= 1.0f) {
         noiseThresholdRatio = value;
         saveSetting("nThresh", value);
     }
 }
 
-void AudioAnalyzer::setBandDecay(float value) {
+void AudioAnalyzerBase::setBandDecay(float value) {
     if (value >= 0.90f && value <= 1.0f) {
         bandDecay = value;
         saveSetting("bDecay", value);
@@ -264,71 +303,274 @@ void AudioAnalyzer::setBandDecay(float value) {
 
 }
 
-void AudioAnalyzer::setBandCeiling(int value) {
+void AudioAnalyzerBase::setBandCeiling(int value) {
     if (value >= 50 && value <= 1000) {
         bandCeiling = value;
         saveSetting("bCeil", value);
     }
 }
 
-void AudioAnalyzer::processAudio() {
-    double avg = 0;
-    double lastSample = analogRead(MIC_PIN);
+void AudioAnalyzerBase::setSilenceMargin(float value) {
+    if (value >= 0.5f && value <= 20.0f) {
+        silenceMargin = value;
+        saveSetting("silMargin", value);
+    }
+}
 
-    for (int i = 0; i < SAMPLES; i++) {
-        double raw = analogRead(MIC_PIN);
-        vReal[i] = alpha * raw + (1.0f - alpha) * lastSample;
-        lastSample = vReal[i];
-        avg += vReal[i];
-        vImag[i] = 0;
+// Срез ниже частоты Найквиста с запасом
+void AudioAnalyzerBase::setLowPassCutoff(float value) {
+    if (value >= 100.0f && value <= SAMPLING_FREQUENCY * 0.45f) {
+        lowPassCutoff = value;
+        configurePreFilter();
+        saveSetting("lpfCutoff", value);
     }
+}
 
-    avg /= SAMPLES;
-    for (int i = 0; i < SAMPLES; i++) {
-        vReal[i] -= avg;
+void AudioAnalyzerBase::setPreEmphasis(float value) {
+    if (value >= 0.0f && value <= 0.97f) {
+        preEmphasis = value;
+        configurePreFilter();
+        saveSetting("preEmph", value);
     }
+}
 
-    FFT.windowing(FFT_WIN_TYP_BLACKMAN_HARRIS, FFT_FORWARD);
-    FFT.compute(FFT_FORWARD);
-    FFT.complexToMagnitude();
-    calculateBands();
+// Коэффициенты пересчитываются только при изменении настроек
+void AudioAnalyzerBase::configurePreFilter() {
+    for (PreFilter& preFilter : preFilters) {
+        preFilter.configure(SAMPLING_FREQUENCY, lowPassCutoff, preEmphasis);
+    }
 }
 
-void AudioAnalyzer::calculateBands() {
+void AudioAnalyzerBase::setSampleReader(SampleReader reader, void* context) {
+    sampleReader = reader;
+    sampleReaderContext = context;
+}
 
-    if (fMin <= 0 || fMax <= 0) {
-        Serial.println("[AudioAnalyzer] Invalid frequency range.");
-        return;
+uint16_t AudioAnalyzerBase::readSample(uint8_t channel) {
+    if (sampleReader) {
+        return sampleReader(sampleReaderContext, channel);
     }
+    return analogRead(channel ? MIC2_PIN : MIC_PIN);
+}
 
+// Чтения каналов чередуются: каждый дециматор получает равномерные чтения,
+// а каналы сдвинуты на одно чтение АЦП, а не на пол-отсчёта fs.
+// Дециматоры настроены одинаково и выдают отсчёт на одном и том же чтении.
+void AudioAnalyzerBase::captureSamples(float (&samples)[INPUT_CHANNELS]) {
+#if ADC_OVERSAMPLING > 1
+    uint8_t pending = (1 << INPUT_CHANNELS) - 1;
+    while (pending) {
+        for (uint8_t channel = 0; channel < INPUT_CHANNELS; channel++) {
+            int32_t sample;
+            if (decimators[channel].push(readSample(channel), sample)) {
+                samples[channel] = sample * (1.0f / (1 << CicDecimator::FRACTION_BITS));
+                pending &= ~(1 << channel);
+            }
+        }
+    }
+#else
+    for (uint8_t channel = 0; channel < INPUT_CHANNELS; channel++) {
+        samples[channel] = readSample(channel);
+    }
+#endif
+}
 
-    const double freqPerBin = (double)SAMPLING_FREQUENCY / SAMPLES;
-    const int totalBins = SAMPLES / 2;
+template <uint16_t FftSize, uint8_t BandCount, typename SampleT>
+AudioAnalyzer<FftSize, BandCount, SampleT>::AudioAnalyzer()
+    : FFT(vReal, vImag, FftSize, SAMPLING_FREQUENCY),
+      maxAmplitude(0),
+      rmsLevel(0),
+      logEnergy(0),
+      publishedFrame(0),
+      frameSequence(0) { // Инициализация FFT
+    // Инициализация массивов частотных полос
+    memset(bands, 0, sizeof(bands));
+    memset(smoothedBands, 0, sizeof(smoothedBands));
+    memset(frames, 0, sizeof(frames));
+#if STEREO_INPUT
+    memset(channelBands, 0, sizeof(channelBands));
+    sideLogEnergy = 0;
+#endif
+}
 
-    double rmsSum = 0;
-    for (int i = 0; i < totalBins; i++) {
-        rmsSum += vReal[i] * vReal[i];
+template <uint16_t FftSize, uint8_t BandCount, typename SampleT>
+bool AudioAnalyzer<FftSize, BandCount, SampleT>::setFftSize(uint16_t size) {
+    if (size < MIN_FFT_SIZE || size > FftSize || (size & (size - 1)) != 0) {
+        LOG(AnalyzerBadFftSize, size);
+        return false;
     }
-    float rms = sqrt(rmsSum / totalBins);
-    float threshold = rms * noiseThresholdRatio;
-
+    requestedFftSize = size;
+    return true;
+}
 
-    maxAmplitude = 0;
+template <uint16_t FftSize, uint8_t BandCount, typename SampleT>
+void AudioAnalyzer<FftSize, BandCount, SampleT>::processAudio() {
+    fftSize = requestedFftSize;
+    sizeShift = 0;
+    while ((FftSize >> sizeShift) > fftSize) {
+        sizeShift++;
+    }
+
+    // Один проход: каждый отсчёт фильтруется сразу после чтения
+    TRACE_BEGIN(Capture);
+    for (int i = 0; i < fftSize; i++) {
+        float samples[INPUT_CHANNELS];
+        captureSamples(samples);
+        vReal[i] = preFilters[0].process(samples[0]);
+#if STEREO_INPUT
+        vImag[i] = preFilters[1].process(samples[1]);
+#else
+        vImag[i] = 0;
+#endif
+    }
+
+    TRACE_END(Capture);
+    LATENCY_MARK(LatencyStage::Capture);
+    TRACE_BEGIN(Analysis);
+
+    // Амплитуда тона растёт с размером FFT: приводим к шкале FftSize,
+    // чтобы полосы и пороги не зависели от текущего размера
+    SampleT scale = (SampleT)(1 << sizeShift);
+
+    FFT.windowing(vReal, fftSize, FFT_WIN_TYP_BLACKMAN_HARRIS, FFT_FORWARD);
+#if STEREO_INPUT
+    FFT.windowing(vImag, fftSize, FFT_WIN_TYP_BLACKMAN_HARRIS, FFT_FORWARD);
+    FFT.compute(vReal, vImag, fftSize, FFT_FORWARD);
+    separateChannels(scale);
+#else
+    FFT.compute(vReal, vImag, fftSize, FFT_FORWARD);
+    FFT.complexToMagnitude(vReal, vImag, fftSize);
+    if (sizeShift) {
+        for (int i = 0; i < fftSize / 2; i++) {
+            vReal[i] *= scale;
+        }
+    }
+#endif
+    calculateBands();
+#if STEREO_INPUT
+    calculateChannelBands();
+#endif
+    smoothBands();
+    publishFrame();
+    TRACE_END(Analysis);
+    LATENCY_MARK(LatencyStage::Analysis);
+}
 
+#if STEREO_INPUT
+// Разделение спектра Z = FFT(A + jB) двух вещественных каналов:
+// A[k] = (Z[k] + conj(Z[N-k])) / 2, B[k] = (Z[k] - conj(Z[N-k])) / 2j.
+// Пары (k, N-k) не пересекаются, поэтому магнитуды пишутся на место спектра.
+template <uint16_t FftSize, uint8_t BandCount, typename SampleT>
+void AudioAnalyzer<FftSize, BandCount, SampleT>::separateChannels(SampleT scale) {
+    const int n = fftSize;
+    const int half = n / 2;
+    const SampleT oneHalf = 0.5;
+
+    // Нулевой бин обоих каналов вещественный; бин Найквиста в полосы не входит,
+    // поэтому его ячейки занимают B и разность нулевого бина
+    SampleT a0 = vReal[0];
+    SampleT b0 = vImag[0];
+    vReal[0] = std::fabs(a0 + b0) * oneHalf * scale;
+    vImag[0] = std::fabs(a0) * scale;
+    vReal[half] = std::fabs(b0) * scale;
+    vImag[half] = std::fabs(a0 - b0) * oneHalf * scale;
+
+    for (int k = 1; k < half; k++) {
+        SampleT zr = vReal[k], zi = vImag[k];
+        SampleT nr = vReal[n - k], ni = vImag[n - k];
+        SampleT ar = (zr + nr) * oneHalf, ai = (zi - ni) * oneHalf;
+        SampleT br = (zi + ni) * oneHalf, bi = (nr - zr) * oneHalf;
+        vReal[k] = std::sqrt((ar + br) * (ar + br) + (ai + bi) * (ai + bi)) * oneHalf * scale;
+        vImag[k] = std::sqrt(ar * ar + ai * ai) * scale;
+        vReal[n - k] = std::sqrt(br * br + bi * bi) * scale;
+        vImag[n - k] = std::sqrt((ar - br) * (ar - br) + (ai - bi) * (ai - bi)) * oneHalf * scale;
+    }
+}
 
-    for (int b = 0; b < MATRIX_WIDTH; b++) {
-        double fromFreq = DEFAULT_FMIN * pow(DEFAULT_FMAX / DEFAULT_FMIN, (double)b / MATRIX_WIDTH);
-        double toFreq = DEFAULT_FMIN * pow(DEFAULT_FMAX / DEFAULT_FMIN, (double)(b + 1) / MATRIX_WIDTH);
+// Полосы каждого канала и энергия разности; середина считается в calculateBands()
+template <uint16_t FftSize, uint8_t BandCount, typename SampleT>
+void AudioAnalyzer<FftSize, BandCount, SampleT>::calculateChannelBands() {
+    const int totalBins = fftSize / 2;
+
+    SampleT sumA = 0, sumB = 0, sumSide = 0;
+    for (int k = 0; k < totalBins; k++) {
+        SampleT a = vImag[k], b = vReal[mirrorBin(k)], side = vImag[mirrorBin(k)];
+        sumA += a * a;
+        sumB += b * b;
+        sumSide += side * side;
+    }
+    float rmsSide = std::sqrt(sumSide / totalBins);
+    sideLogEnergy = constrain(10.0f * log10f(rmsSide + 1.0f), 0.0f, (float)bandCeiling);
+
+    float sums[BandCount];
+    sumBands([this](int k) { return vImag[k]; }, std::sqrt(sumA / totalBins) * noiseThresholdRatio, sums);
+    decayBands(channelBands[0], sums);
+    sumBands([this](int k) { return vReal[mirrorBin(k)]; }, std::sqrt(sumB / totalBins) * noiseThresholdRatio, sums);
+    decayBands(channelBands[1], sums);
+}
+#endif
+
+// Собираем кадр в неопубликованном слоте и переключаем индекс
+template <uint16_t FftSize, uint8_t BandCount, typename SampleT>
+void AudioAnalyzer<FftSize, BandCount, SampleT>::publishFrame() {
+    uint8_t next = publishedFrame ^ 1;
+    Frame& frame = frames[next];
+
+    frame.sequence = ++frameSequence;
+    memcpy(frame.bands, bands, sizeof(bands));
+    memcpy(frame.smoothedBands, smoothedBands, sizeof(smoothedBands));
+    frame.rms = rmsLevel;
+    frame.logEnergy = logEnergy;
+    frame.peak = maxAmplitude;
+    frame.minLogPower = minLogPower;
+    frame.maxLogPower = maxLogPower;
+    frame.silent = isSilent();
+    frame.logEnergyQ16 = q16FromFloat(logEnergy);
+    frame.minLogPowerQ16 = q16FromFloat(minLogPower);
+    frame.maxLogPowerQ16 = q16FromFloat(maxLogPower);
+    frame.peakLevel = (uint16_t)maxAmplitude;
+#if STEREO_INPUT
+    memcpy(frame.channelBands, channelBands, sizeof(channelBands));
+    frame.sideLogEnergy = sideLogEnergy;
+#else
+    memcpy(frame.channelBands[0], bands, sizeof(bands));
+    memcpy(frame.channelBands[1], bands, sizeof(bands));
+    frame.sideLogEnergy = 0;
+#endif
+    frame.sideLogEnergyQ16 = q16FromFloat(frame.sideLogEnergy);
+#if TEMPO_TRACKER
+    frame.bpm = tempoTracker.getBpm();
+    frame.beatPeriodUs = tempoTracker.getBeatPeriodUs();
+    frame.beatUs = tempoTracker.getBeatUs();
+#else
+    frame.bpm = 0;
+    frame.beatPeriodUs = 0;
+    frame.beatUs = 0;
+#endif
+
+    publishedFrame = next;
+}
 
-        int fromBin = (int)(fromFreq / freqPerBin);
-        int toBin = (int)(toFreq / freqPerBin);
+template <uint16_t FftSize, uint8_t BandCount, typename SampleT>
+void AudioAnalyzer<FftSize, BandCount, SampleT>::copyFrame(Frame& out) const {
+    // Если за время копирования опубликован новый кадр, копируем ещё раз
+    uint8_t index;
+    do {
+        index = publishedFrame;
+        out = frames[index];
+    } while (index != publishedFrame || out.sequence != frames[index].sequence);
+}
 
-        fromBin = constrain(fromBin, 0, totalBins - 1);
-        toBin = constrain(toBin, fromBin + 1, totalBins);
+template <uint16_t FftSize, uint8_t BandCount, typename SampleT>
+template <typename Magnitude>
+void AudioAnalyzer<FftSize, BandCount, SampleT>::sumBands(Magnitude magnitude, float threshold, float* sums) const {
+    const LookupTable<BinRange, BandCount>& bins = BIN_TABLES[sizeShift];
 
-        double sum = 0;
-        for (int i = fromBin; i < toBin; i++) {
-            float amplitude = vReal[i]; // Используем vReal[i] вместо FFT.read(i)
+    // Номер полосы — константа: выбор усиления сворачивается при компиляции
+    forEachBand<BandCount>([&](auto b) {
+        SampleT sum = 0;
+        for (int i = bins[b].from; i < bins[b].to; i++) {
+            float amplitude = magnitude(i);
             if (amplitude > threshold) {
                 sum += amplitude;
             }
@@ -336,36 +578,84 @@ void AudioAnalyzer::calculateBands() {
 
         sum /= sensitivityReduction;
 
-        if (b < MATRIX_WIDTH / 3) sum *= lowFreqGain;
-        else if (b < 2 * MATRIX_WIDTH / 3) sum *= midFreqGain;
+        if (b < BandCount / 3) sum *= lowFreqGain;
+        else if (b < 2 * BandCount / 3) sum *= midFreqGain;
         else sum *= highFreqGain;
 
-        bands[b] *= bandDecay;
-        if (sum > bands[b]) bands[b] = sum;
+        sums[b] = sum;
+    });
+}
 
-        if (bands[b] > maxAmplitude) maxAmplitude = bands[b];
+// Полосы с затуханием: новый пик сразу, спад — с множителем bandDecay
+template <uint16_t FftSize, uint8_t BandCount, typename SampleT>
+void AudioAnalyzer<FftSize, BandCount, SampleT>::decayBands(uint16_t* target, const float* sums) {
+    forEachBand<BandCount>([&](auto b) {
+        target[b] *= bandDecay;
+        if (sums[b] > target[b]) target[b] = sums[b];
+    });
+}
+
+template <uint16_t FftSize, uint8_t BandCount, typename SampleT>
+void AudioAnalyzer<FftSize, BandCount, SampleT>::calculateBands() {
+
+    if (fMin <= 0 || fMax <= 0) {
+        LOG(AnalyzerBadRange);
+        return;
+    }
+
+
+    const int totalBins = fftSize / 2;
+
+    SampleT rmsSum = 0;
+    for (int i = 0; i < totalBins; i++) {
+        rmsSum += vReal[i] * vReal[i];
     }
+    float rms = std::sqrt(rmsSum / totalBins);
+    float threshold = rms * noiseThresholdRatio;
+    rmsLevel = rms;
+
+    // Логарифмическая энергия, добавляя 1.0 для защиты от log(0)
+    logEnergy = 10.0f * log10f(rms + 1.0f);
+    logEnergy = constrain(logEnergy, 0.0f, (float)bandCeiling);
+
+    // Обновляем статистику сигнала и детектор тишины
+    updateSignalStats(logEnergy);
+    updateSilenceState(logEnergy);
+#if TEMPO_TRACKER
+    tempoTracker.update(logEnergy, micros());
+#endif
+
+
+    float sums[BandCount];
+    sumBands([this](int i) { return vReal[i]; }, threshold, sums);
+    decayBands(bands, sums);
+
+    maxAmplitude = 0;
+    forEachBand<BandCount>([&](auto b) {
+        if (bands[b] > maxAmplitude) maxAmplitude = bands[b];
+    });
 
     maxAmplitude = std::min(maxAmplitude, (float)bandCeiling);
 }
 
-void AudioAnalyzer::smoothBands() {
-    for (int i = 0; i < MATRIX_WIDTH; i++) {
+template <uint16_t FftSize, uint8_t BandCount, typename SampleT>
+void AudioAnalyzer<FftSize, BandCount, SampleT>::smoothBands() {
+    forEachBand<BandCount>([&](auto i) {
         smoothedBands[i] = (1.0f - alpha) * smoothedBands[i] + alpha * bands[i];
-    }
+    });
 
 }
 
-void AudioAnalyzer::normalizeBands(uint16_t* heights, int matrixHeight) {
-    for (int i = 0; i < MATRIX_WIDTH; i++) {
-        heights[i] = (maxAmplitude > 0)
-            ? map(smoothedBands[i], 0, maxAmplitude, 0, matrixHeight)
-            : 0;
-        heights[i] = constrain(heights[i], 0, matrixHeight);
-    }
+template <uint16_t FftSize, uint8_t BandCount, typename SampleT>
+void AudioAnalyzer<FftSize, BandCount, SampleT>::getNormalizedHeights(uint16_t* heights, int matrixHeight) {
+    normalizeHeights(getFrame(), heights, matrixHeight);
 }
 
-void AudioAnalyzer::getNormalizedHeights(uint16_t* heights, int matrixHeight) {
-    smoothBands();
-    normalizeBands(heights, matrixHeight);
-}
+// Конфигурации анализатора. Новая конфигурация добавляется сюда же.
+template class AudioAnalyzer<SAMPLES, MATRIX_WIDTH, double>;
+template class AudioAnalyzer<SAMPLES, MATRIX_WIDTH, float>;
+template class AudioAnalyzer<COARSE_FFT_SIZE, COARSE_BAND_COUNT, float>; // CoarseAnalyzer
+template class AudioAnalyzer<FINE_FFT_SIZE, MATRIX_WIDTH, float>;        // FineAnalyzer
+
+static_assert(sizeof(MatrixAnalyzer) <= AUDIO_ANALYZER_RAM_BUDGET,
+              "MatrixAnalyzer exceeds AUDIO_ANALYZER_RAM_BUDGET");
@@ -2,28 +2,171 @@
 #include <Preferences.h>
 #include <arduinoFFT.h> // Ensure the arduinoFFT library is installed
 #include <cfloat>
+#include <type_traits>
+#include <utility>
 #include "config.hpp" // Подключаем файл конфигурации
+#include "render_math.hpp"
+#include "pre_filter.hpp"
+#include "cic_decimator.hpp"
+#include "tempo_tracker.hpp"
 
+// Источник отсчётов вместо MIC_PIN/MIC2_PIN (синтетический сигнал, бенчмарки).
+// channel: 0 — A (MIC_PIN), 1 — B (MIC2_PIN); каналы читаются поочерёдно,
+// поэтому источник с общим временем видит тот же сдвиг каналов, что и АЦП.
+typedef uint16_t (*SampleReader)(void* context, uint8_t channel);
+
+// Входные каналы: A — MIC_PIN, B — MIC2_PIN
+constexpr uint8_t INPUT_CHANNELS = STEREO_INPUT ? 2 : 1;
+
+// Результат одного цикла анализа из BandCount полос. Заполняется один раз
+// в processAudio() и после публикации не меняется; все потребители читают только его.
+template <uint8_t BandCount>
+struct SpectrumFrame {
+    uint32_t sequence;                     // Номер цикла анализа
+    uint16_t bands[BandCount];             // Полосы с затуханием
+    uint16_t smoothedBands[BandCount];     // Сглаженные полосы
+    float rms;                             // RMS спектра
+    float logEnergy;                       // Логарифмическая энергия, дБ (в стерео — середины (A+B)/2)
+    float peak;                            // Максимум полос (ограничен bandCeiling)
+    float minLogPower;                     // Шумовой пол
+    float maxLogPower;                     // Максимум с затуханием
+    bool silent;                           // Тишина держится дольше SILENCE_HOLD_TIME
+
+    // Стерео: полосы каждого канала и энергия разности (A-B)/2.
+    // В моно оба канала повторяют bands, а энергия разности нулевая.
+    uint16_t channelBands[2][BandCount];
+    float sideLogEnergy;
+
+    // Те же величины для целочисленной отрисовки
+    q16_t logEnergyQ16;
+    q16_t minLogPowerQ16;
+    q16_t maxLogPowerQ16;
+    uint16_t peakLevel;                    // peak без дробной части
+    q16_t sideLogEnergyQ16;
+
+    // Темп (TempoTracker): фаза доли в момент t — (t - beatUs) % beatPeriodUs
+    float bpm;                             // 0 — темп не захвачен
+    uint32_t beatPeriodUs;                 // 0 — темп не захвачен
+    uint32_t beatUs;                       // micros() одной из прошедших долей
+};
+
+// Кадр с полосой на колонку матрицы — его рисуют анимации
+typedef SpectrumFrame<MATRIX_WIDTH> AnalysisFrame;
+
+// Высоты столбцов из сглаженных полос кадра
+template <uint8_t BandCount>
+void normalizeHeights(const SpectrumFrame<BandCount>& frame, uint16_t* heights, int matrixHeight) {
+    for (int i = 0; i < BandCount; i++) {
+        uint32_t height = frame.peakLevel
+            ? (uint32_t)frame.smoothedBands[i] * matrixHeight / frame.peakLevel
+            : 0;
+        heights[i] = height < (uint32_t)matrixHeight ? height : matrixHeight;
+    }
+}
 
 // --- Дефолтные значения настроек ---
 constexpr float DEFAULT_SENSITIVITY_REDUCTION = 5.0f;
 constexpr float DEFAULT_LOW_FREQ_GAIN = 1.0f;
 constexpr float DEFAULT_MID_FREQ_GAIN = 1.0f;
 constexpr float DEFAULT_HIGH_FREQ_GAIN = 1.0f;
-constexpr float DEFAULT_ALPHA = 0.5f;
+constexpr float DEFAULT_ALPHA = 0.5f; // Сглаживание полос на экране
 constexpr float DEFAULT_FMIN = 50.0f;
 constexpr float DEFAULT_FMAX = 10000.0f;
 constexpr float DEFAULT_NOISE_THRESHOLD_RATIO = 0.25f;
 constexpr float DEFAULT_BAND_DECAY = 0.8f; // Увеличьте значение для более медленного затухания
 constexpr int   DEFAULT_BAND_CEILING = 1000;
+constexpr float DEFAULT_SILENCE_MARGIN = 3.0f; // Превышение над шумовым полом (дБ), ниже которого считаем тишиной
+constexpr float DEFAULT_LOW_PASS_CUTOFF = 3000.0f; // Срез входного НЧ-фильтра, Гц
+constexpr float DEFAULT_PRE_EMPHASIS = 0.0f;       // Коэффициент предыскажения (0 — выключено)
 
 
-class AudioAnalyzer {
-private:
+namespace audio_analyzer_detail {
+
+// exp(x) при компиляции: x делится пополам до |x| <= 0.5, ряд Тейлора, затем квадраты
+constexpr double exponent(double x) {
+    int halvings = 0;
+    while (x > 0.5 || x < -0.5) {
+        x /= 2;
+        halvings++;
+    }
+    double term = 1.0;
+    double sum = 1.0;
+    for (int n = 1; n < 20; n++) {
+        term *= x / n;
+        sum += term;
+    }
+    while (halvings-- > 0) {
+        sum *= sum;
+    }
+    return sum;
+}
+
+// ln(x) при компиляции: итерации Галлея по exponent()
+constexpr double logarithm(double x) {
+    double y = 0.0;
+    for (int i = 0; i < 64; i++) {
+        double e = exponent(y);
+        y += 2.0 * (x - e) / (x + e);
+    }
+    return y;
+}
+
+template <size_t... Index, typename Body>
+inline void unrolled(Body& body, std::index_sequence<Index...>) {
+    (body(std::integral_constant<size_t, Index>()), ...);
+}
+
+} // namespace audio_analyzer_detail
+
+// Бины полосы [from, to)
+struct BinRange {
+    uint16_t from;
+    uint16_t to;
+};
+
+// Границы полос при размере FFT FftSize >> shift:
+// DEFAULT_FMIN * (DEFAULT_FMAX / DEFAULT_FMIN)^(b / BandCount); в каждой
+// полосе хотя бы один бин, все бины ниже частоты Найквиста
+template <uint16_t FftSize, uint8_t BandCount>
+constexpr LookupTable<BinRange, BandCount> makeBinTable(uint8_t shift) {
+    LookupTable<BinRange, BandCount> table{};
+    const double span = audio_analyzer_detail::logarithm((double)DEFAULT_FMAX / DEFAULT_FMIN);
+    const double freqPerBin = (double)SAMPLING_FREQUENCY / (FftSize >> shift);
+    const int totalBins = (FftSize >> shift) / 2;
+    for (int b = 0; b < BandCount; b++) {
+        double fromFreq = DEFAULT_FMIN * audio_analyzer_detail::exponent(span * b / BandCount);
+        double toFreq = DEFAULT_FMIN * audio_analyzer_detail::exponent(span * (b + 1) / BandCount);
+        int fromBin = (int)(fromFreq / freqPerBin);
+        int toBin = (int)(toFreq / freqPerBin);
+        fromBin = fromBin < totalBins - 1 ? fromBin : totalBins - 1;
+        toBin = toBin > fromBin + 1 ? toBin : fromBin + 1;
+        toBin = toBin < totalBins ? toBin : totalBins;
+        table.values[b] = {(uint16_t)fromBin, (uint16_t)toBin};
+    }
+    return table;
+}
+
+// Цикл по полосам. При небольшом числе полос разворачивается при компиляции:
+// тело получает номер полосы константой, и ветви по нему сворачиваются.
+constexpr size_t BAND_UNROLL_LIMIT = 16;
+
+template <size_t Count, typename Body>
+inline void forEachBand(Body body) {
+    if constexpr (Count <= BAND_UNROLL_LIMIT) {
+        audio_analyzer_detail::unrolled(body, std::make_index_sequence<Count>());
+    } else {
+        for (size_t b = 0; b < Count; b++) {
+            body(b);
+        }
+    }
+}
+
+// Всё, что не зависит от размера FFT и числа полос: настройки в NVS,
+// захват и фильтрация отсчётов, статистика сигнала и детектор тишины.
+// Несколько анализаторов делят одни настройки из NVS.
+class AudioAnalyzerBase {
+protected:
     Preferences preferences;
-    ArduinoFFT<double> FFT; // Объект FFT
-    double vReal[SAMPLES]; // Реальная часть FFT
-    double vImag[SAMPLES]; // Мнимая часть FFT
 
     float sensitivityReduction;
     float lowFreqGain, midFreqGain, highFreqGain;
@@ -32,32 +175,47 @@ private:
     float noiseThresholdRatio;
     float bandDecay;
     int bandCeiling;
-    uint16_t bands[MATRIX_WIDTH];
-    uint16_t smoothedBands[MATRIX_WIDTH];
-    float maxAmplitude;
-    float logPowerSmoothed;
+    float silenceMargin;
+    float lowPassCutoff;
+    float preEmphasis;
 
     // Переменные для статистики сигнала
     float minLogPower;
     float maxLogPower;
     int sampleCount;
 
-    void calculateBands();
-    void smoothBands();
-    void normalizeBands(uint16_t* heights, int matrixHeight);
+    // Детектор тишины относительно шумового пола minLogPower
+    bool silent;
+    unsigned long silenceStartTime;
 
-    void updateSignalStats(float currentLogPower);
+    // Потоковая фильтрация отсчётов; состояние переходит из блока в блок
+    PreFilter preFilters[INPUT_CHANNELS];
+    void configurePreFilter();
 
+    // Источник отсчётов (nullptr — читаем MIC_PIN)
+    SampleReader sampleReader = nullptr;
+    void* sampleReaderContext = nullptr;
+    uint16_t readSample(uint8_t channel);
 
-public:
-    AudioAnalyzer();
-    ~AudioAnalyzer();
+#if ADC_OVERSAMPLING > 1
+    CicDecimator decimators[INPUT_CHANNELS]; // Передискретизация: ADC_OVERSAMPLING чтений на отсчёт
+#endif
+    // Один отсчёт fs каждого канала в единицах АЦП (с дробной частью)
+    void captureSamples(float (&samples)[INPUT_CHANNELS]);
 
-    void begin();
-    void processAudio();
+    void updateSignalStats(float currentLogPower);
+    void updateSilenceState(float currentLogPower);
 
-    void getNormalizedHeights(uint16_t* heights, int matrixHeight);
+#if TEMPO_TRACKER
+    TempoTracker tempoTracker; // Огибающая logEnergy; шаг оценки за цикл анализа
+#endif
 
+    AudioAnalyzerBase();
+    ~AudioAnalyzerBase();
+
+public:
+    void begin();
+    void setSampleReader(SampleReader reader, void* context = nullptr);
 
     // Методы для настройки параметров
     void setSensitivityReduction(float value);
@@ -70,14 +228,115 @@ public:
     void setNoiseThresholdRatio(float value);
     void setBandDecay(float value);
     void setBandCeiling(int value);
+    void setSilenceMargin(float value);
+    void setLowPassCutoff(float value);
+    void setPreEmphasis(float value);
 
     void loadSettings();
     void resetSettings();
     void saveSetting(const char* key, float value);
     void saveSetting(const char* key, int value);
 
-    // Методы для получения статистики
-    float getMinLogPower() const { return minLogPower; }
-    float getMaxLogPower() const { return maxLogPower; }
-    float getTotalLogRmsEnergy();
+    // Тишина держится дольше SILENCE_HOLD_TIME
+    bool isSilent() const;
+};
+
+// Анализатор с размерами, известными при компиляции: FftSize отсчётов
+// на цикл, BandCount логарифмических полос, отсчёты FFT типа SampleT
+// (float считается аппаратно на ESP32, double — программно).
+// Границы полос в бинах для каждого допустимого размера FFT считаются
+// при компиляции, циклы по небольшому числу полос развёрнуты.
+// Анализаторы разных конфигураций могут работать одновременно, например
+// грубый быстрый и точный медленный. Конфигурации инстанцируются явно
+// в audio_analyzer.cpp.
+template <uint16_t FftSize, uint8_t BandCount, typename SampleT = double>
+class AudioAnalyzer : public AudioAnalyzerBase {
+public:
+    static constexpr uint16_t FFT_SIZE = FftSize;
+    static constexpr uint16_t MIN_FFT_SIZE = FftSize / 4;
+    static constexpr uint8_t BAND_COUNT = BandCount;
+    static constexpr uint8_t SIZE_STEPS = 3; // FftSize, FftSize / 2, FftSize / 4
+
+    static_assert(FftSize >= 32 && (FftSize & (FftSize - 1)) == 0, "FftSize: power of two, at least 32");
+    static_assert(BandCount >= 3, "BandCount: at least one band per low/mid/high gain");
+    static_assert(std::is_floating_point<SampleT>::value, "SampleT: float or double");
+
+    typedef SpectrumFrame<BandCount> Frame;
+
+    AudioAnalyzer();
+
+    void processAudio();
+
+    // Размер FFT — степень двойки от FftSize / 4 до FftSize. Меньший размер
+    // сокращает захват и преобразование ценой разрешения по частоте.
+    // Можно вызывать из другой задачи: размер меняется со следующего цикла.
+    bool setFftSize(uint16_t size);
+    uint16_t getFftSize() const { return fftSize; }
+
+    // Последний опубликованный кадр анализа (для потребителей в задаче анализа)
+    const Frame& getFrame() const { return frames[publishedFrame]; }
+    // Согласованная копия кадра для потребителей в других задачах
+    void copyFrame(Frame& out) const;
+
+    // Высоты столбцов из сглаженных полос последнего кадра
+    void getNormalizedHeights(uint16_t* heights, int matrixHeight);
+
+    // Методы для получения статистики (последний опубликованный кадр)
+    float getMinLogPower() const { return getFrame().minLogPower; }
+    float getMaxLogPower() const { return getFrame().maxLogPower; }
+    float getTotalLogRmsEnergy() const { return getFrame().logEnergy; }
+    float getBpm() const { return getFrame().bpm; } // 0 — темп не захвачен
+
+private:
+    // Границы полос в бинах для размеров FftSize, FftSize / 2 и FftSize / 4
+    static constexpr LookupTable<BinRange, BandCount> BIN_TABLES[SIZE_STEPS] = {
+        makeBinTable<FftSize, BandCount>(0),
+        makeBinTable<FftSize, BandCount>(1),
+        makeBinTable<FftSize, BandCount>(2),
+    };
+
+    ArduinoFFT<SampleT> FFT; // Объект FFT
+    SampleT vReal[FftSize]; // Реальная часть FFT
+    SampleT vImag[FftSize]; // Мнимая часть FFT
+    uint16_t fftSize = FftSize; // Текущий размер FFT (не больше FftSize)
+    uint8_t sizeShift = 0;      // log2(FftSize / fftSize)
+    volatile uint16_t requestedFftSize = FftSize; // Применяется в начале следующего цикла анализа
+
+    uint16_t bands[BandCount];
+    uint16_t smoothedBands[BandCount];
+    float maxAmplitude;
+    float rmsLevel; // RMS спектра последнего цикла анализа
+    float logEnergy; // Логарифмическая энергия последнего цикла анализа
+
+    // Два кадра: пока один опубликован, следующий собирается в другом
+    Frame frames[2];
+    volatile uint8_t publishedFrame;
+    uint32_t frameSequence;
+
+#if STEREO_INPUT
+    // Оба канала проходят один комплексный FFT: A — вещественная часть,
+    // B — мнимая. После разделения по сопряжённой симметрии магнитуды лежат
+    // на месте спектра: vReal[k] — середина, vImag[k] — A,
+    // vReal[mirror(k)] — B, vImag[mirror(k)] — разность.
+    uint16_t channelBands[2][BandCount];
+    float sideLogEnergy;
+    void separateChannels(SampleT scale);
+    void calculateChannelBands();
+    int mirrorBin(int k) const { return k ? fftSize - k : fftSize / 2; }
+#endif
+
+    void calculateBands();
+    // Суммы полос по спектру магнитуд; magnitude(i) — магнитуда бина i
+    template <typename Magnitude>
+    void sumBands(Magnitude magnitude, float threshold, float* sums) const;
+    void decayBands(uint16_t* target, const float* sums);
+    void smoothBands();
+    void publishFrame();
 };
+
+// Анализатор анимаций: полоса на колонку матрицы
+typedef AudioAnalyzer<SAMPLES, MATRIX_WIDTH, ANALYZER_SAMPLE_TYPE> MatrixAnalyzer;
+// Грубый быстрый: короткий захват и несколько широких полос (громкость, доли)
+typedef AudioAnalyzer<COARSE_FFT_SIZE, COARSE_BAND_COUNT, float> CoarseAnalyzer;
+// Точный медленный: длинный захват, узкие бины в тех же полосах
+typedef AudioAnalyzer<FINE_FFT_SIZE, MATRIX_WIDTH, float> FineAnalyzer;
@@ -0,0 +1,26 @@
+#include "cic_decimator.hpp"
+
+bool CicDecimator::setRatio(uint8_t value) {
+    if (value < MIN_RATIO || value > MAX_RATIO || (value & (value - 1)) != 0) {
+        return false;
+    }
+    uint8_t log2Ratio = 0;
+    while ((1u << log2Ratio) < value) {
+        log2Ratio++;
+    }
+    ratio = value;
+    // Усиление CIC равно ratio^STAGES; оставляем FRACTION_BITS дробных бит
+    shift = STAGES * log2Ratio - FRACTION_BITS;
+    reset();
+    return true;
+}
+
+void CicDecimator::reset() {
+    phase = 0;
+    warmup = WARMUP_OUTPUTS;
+    for (uint8_t i = 0; i < STAGES; i++) {
+        integrators[i] = 0;
+        combs[i] = 0;
+    }
+    history[0] = history[1] = 0;
+}
@@ -0,0 +1,70 @@
+#ifndef CIC_DECIMATOR_HPP
+#define CIC_DECIMATOR_HPP
+
+#include <stdint.h>
+
+// Целочисленный CIC-дециматор (3 звена, задержка 1) с компенсирующим КИХ.
+// Принимает сырые отсчёты АЦП с частотой ratio * fs и отдаёт отсчёты fs
+// в формате Q4: усреднение шума даёт дополнительные значащие биты, а нули
+// CIC на кратных fs подавляют наложение спектров перед FFT.
+class CicDecimator {
+public:
+    static constexpr uint8_t STAGES = 3;
+    static constexpr uint8_t FRACTION_BITS = 4; // Дробные биты выхода
+    static constexpr uint8_t MIN_RATIO = 4;
+    static constexpr uint8_t MAX_RATIO = 16;
+
+    // Коэффициент децимации — степень двойки от MIN_RATIO до MAX_RATIO
+    bool setRatio(uint8_t value);
+    uint8_t getRatio() const { return ratio; }
+    void reset();
+
+    // Возвращает true, когда готов выходной отсчёт
+    inline bool push(uint16_t sample, int32_t& output) {
+        // Интеграторы в модульной арифметике: переполнение сокращается в гребёнках
+        integrators[0] += sample;
+        integrators[1] += integrators[0];
+        integrators[2] += integrators[1];
+        if (++phase < ratio) {
+            return false;
+        }
+        phase = 0;
+
+        uint32_t value = integrators[2];
+        for (uint8_t i = 0; i < STAGES; i++) {
+            uint32_t delayed = combs[i];
+            combs[i] = value;
+            value -= delayed;
+        }
+        int32_t compensated = compensate((int32_t)(value >> shift));
+        if (warmup) {
+            // Пока гребёнки и КИХ заполняются, выход неполный
+            warmup--;
+            return false;
+        }
+        output = compensated;
+        return true;
+    }
+
+private:
+    static constexpr uint8_t WARMUP_OUTPUTS = STAGES + 2; // Гребёнки + линия задержки КИХ
+
+    uint8_t ratio = MIN_RATIO;
+    uint8_t shift = STAGES * 2 - FRACTION_BITS; // STAGES * log2(ratio) - FRACTION_BITS
+    uint8_t phase = 0;
+    uint8_t warmup = WARMUP_OUTPUTS;
+    uint32_t integrators[STAGES] = {};
+    uint32_t combs[STAGES] = {};
+    int32_t history[2] = {};
+
+    // КИХ [-a, 1 + 2a, -a], a = 3/16: поднимает спад CIC в полосе до fs/4
+    // (±0.3 дБ до 2 кГц при fs = 8 кГц). Коэффициенты Q14, сумма — ровно 1.
+    inline int32_t compensate(int32_t input) {
+        int32_t output = (-3072 * input + 22528 * history[0] - 3072 * history[1]) >> 14;
+        history[1] = history[0];
+        history[0] = input;
+        return output;
+    }
+};
+
+#endif // CIC_DECIMATOR_HPP
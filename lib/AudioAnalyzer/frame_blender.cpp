@@ -0,0 +1,82 @@
+#include "frame_blender.hpp"
+#include <Arduino.h>
+#include <string.h>
+#include <algorithm>
+
+FrameBlender::FrameBlender() {
+    configure(1, 1, SpectrumBlend::Hold);
+    reset();
+}
+
+void FrameBlender::configure(uint16_t renderRate, uint16_t analysisRate, SpectrumBlend mode) {
+    // Кадров отрисовки на один кадр анализа, с округлением вверх
+    uint32_t ratio = analysisRate ? (renderRate + analysisRate - 1) / analysisRate : 1;
+    steps = constrain(ratio, 1u, (uint32_t)MAX_STEPS);
+    for (uint8_t k = 0; k < steps; k++) {
+        switch (mode) {
+            case SpectrumBlend::Hold:
+                weights[k] = 256;
+                break;
+            case SpectrumBlend::Interpolate:
+                // Последний шаг перед следующим анализом доходит ровно до последнего кадра
+                weights[k] = (k + 1) * 256 / steps;
+                break;
+            case SpectrumBlend::Extrapolate:
+                weights[k] = 256 + k * 256 / steps;
+                break;
+        }
+    }
+    step = std::min<uint8_t>(step, steps - 1);
+}
+
+void FrameBlender::reset() {
+    memset(frames, 0, sizeof(frames));
+    memset(&blended, 0, sizeof(blended));
+    step = 0;
+}
+
+const AnalysisFrame& FrameBlender::advance(bool fresh) {
+    if (fresh) {
+        bool first = latest->sequence == 0;
+        std::swap(previous, latest);
+        if (first) {
+            *previous = *latest; // Не тянуть первый кадр от нулей
+        }
+        step = 0;
+    } else if (step + 1 < steps) {
+        step++;
+    }
+    // Если анализ запаздывает, последний вес держится до нового кадра
+    blend(weights[step]);
+    return blended;
+}
+
+static inline uint16_t blendLevel(uint16_t from, uint16_t to, int32_t weight) {
+    int32_t value = from + (((int32_t)to - from) * weight >> 8);
+    return constrain(value, 0, 0xFFFF);
+}
+
+static inline q16_t blendQ16(q16_t from, q16_t to, int32_t weight) {
+    return from + (q16_t)(((int64_t)to - from) * weight >> 8);
+}
+
+void FrameBlender::blend(int16_t weight) {
+    // Величины с плавающей точкой, тишина, темп и номер — из последнего кадра
+    blended = *latest;
+    if (weight == 256) {
+        return;
+    }
+    const AnalysisFrame& a = *previous;
+    const AnalysisFrame& b = *latest;
+    for (int i = 0; i < MATRIX_WIDTH; i++) {
+        blended.bands[i] = blendLevel(a.bands[i], b.bands[i], weight);
+        blended.smoothedBands[i] = blendLevel(a.smoothedBands[i], b.smoothedBands[i], weight);
+        blended.channelBands[0][i] = blendLevel(a.channelBands[0][i], b.channelBands[0][i], weight);
+        blended.channelBands[1][i] = blendLevel(a.channelBands[1][i], b.channelBands[1][i], weight);
+    }
+    blended.peakLevel = blendLevel(a.peakLevel, b.peakLevel, weight);
+    blended.logEnergyQ16 = blendQ16(a.logEnergyQ16, b.logEnergyQ16, weight);
+    blended.minLogPowerQ16 = blendQ16(a.minLogPowerQ16, b.minLogPowerQ16, weight);
+    blended.maxLogPowerQ16 = blendQ16(a.maxLogPowerQ16, b.maxLogPowerQ16, weight);
+    blended.sideLogEnergyQ16 = std::max(0, blendQ16(a.sideLogEnergyQ16, b.sideLogEnergyQ16, weight));
+}
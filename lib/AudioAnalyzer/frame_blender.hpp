@@ -0,0 +1,98 @@
+#ifndef FRAME_BLENDER_HPP
+#define FRAME_BLENDER_HPP
+
+#include "audio_analyzer.hpp"
+#include <algorithm>
+
+// Как рисовать кадры отрисовки между двумя циклами анализа
+enum class SpectrumBlend : uint8_t {
+    Hold,        // Последний кадр анализа без изменений
+    Interpolate, // От предпоследнего кадра к последнему: плавно, с задержкой на период анализа
+    Extrapolate  // От последнего дальше по тому же наклону: без задержки, но с выбросами на атаках
+};
+
+// Кадр для отрисовки, когда анализ идёт реже отрисовки.
+// Хранит копии двух последних кадров анализа и смешивает их с весом по номеру
+// кадра отрисовки после прихода последнего. Веса считаются в configure()
+// при смене частот; в кадре — только выборка веса и целочисленное смешивание.
+class FrameBlender {
+public:
+    static constexpr uint8_t MAX_STEPS = 16; // Кадров отрисовки на кадр анализа
+
+    FrameBlender();
+
+    void configure(uint16_t renderRate, uint16_t analysisRate, SpectrumBlend mode);
+    void reset();
+
+    // Забрать новый кадр анализа, если он опубликован, и собрать кадр отрисовки.
+    // Анализ может идти в другой задаче: кадр копируется через copyFrame().
+    // Полосы анализатора другой ширины раскладываются по колонкам матрицы.
+    template <typename Analyzer>
+    const AnalysisFrame& update(const Analyzer& analyzer) {
+        bool fresh = analyzer.getFrame().sequence != latest->sequence;
+        if (fresh) {
+            // Старший из двух кадров заменяется новым и становится последним
+            if constexpr (Analyzer::BAND_COUNT == MATRIX_WIDTH) {
+                analyzer.copyFrame(*previous);
+            } else {
+                typename Analyzer::Frame frame;
+                analyzer.copyFrame(frame);
+                toColumns(frame, *previous);
+            }
+        }
+        return advance(fresh);
+    }
+
+    const AnalysisFrame& getFrame() const { return blended; }  // Смешанный кадр
+    const AnalysisFrame& getLatest() const { return *latest; } // Последний кадр анализа как есть
+    uint8_t getSteps() const { return steps; }
+
+private:
+    AnalysisFrame frames[2];
+    AnalysisFrame* previous = &frames[0];
+    AnalysisFrame* latest = &frames[1];
+    AnalysisFrame blended;
+
+    int16_t weights[MAX_STEPS]; // Вес последнего кадра на каждом шаге, 256 = 1.0
+    uint8_t steps = 1;
+    uint8_t step = 0;
+
+    const AnalysisFrame& advance(bool fresh);
+    void blend(int16_t weight);
+};
+
+// Кадр из BandCount полос в кадр с полосой на колонку: колонка берёт
+// максимум своих полос, а при полосах шире колонки повторяет полосу
+template <uint8_t BandCount>
+void toColumns(const SpectrumFrame<BandCount>& source, AnalysisFrame& target) {
+    target.sequence = source.sequence;
+    target.rms = source.rms;
+    target.logEnergy = source.logEnergy;
+    target.peak = source.peak;
+    target.minLogPower = source.minLogPower;
+    target.maxLogPower = source.maxLogPower;
+    target.silent = source.silent;
+    target.sideLogEnergy = source.sideLogEnergy;
+    target.logEnergyQ16 = source.logEnergyQ16;
+    target.minLogPowerQ16 = source.minLogPowerQ16;
+    target.maxLogPowerQ16 = source.maxLogPowerQ16;
+    target.peakLevel = source.peakLevel;
+    target.sideLogEnergyQ16 = source.sideLogEnergyQ16;
+    target.bpm = source.bpm;
+    target.beatPeriodUs = source.beatPeriodUs;
+    target.beatUs = source.beatUs;
+    for (int x = 0; x < MATRIX_WIDTH; x++) {
+        int from = x * BandCount / MATRIX_WIDTH;
+        int to = std::max((x + 1) * BandCount / MATRIX_WIDTH, from + 1);
+        target.bands[x] = target.smoothedBands[x] = 0;
+        target.channelBands[0][x] = target.channelBands[1][x] = 0;
+        for (int b = from; b < to; b++) {
+            target.bands[x] = std::max(target.bands[x], source.bands[b]);
+            target.smoothedBands[x] = std::max(target.smoothedBands[x], source.smoothedBands[b]);
+            target.channelBands[0][x] = std::max(target.channelBands[0][x], source.channelBands[0][b]);
+            target.channelBands[1][x] = std::max(target.channelBands[1][x], source.channelBands[1][b]);
+        }
+    }
+}
+
+#endif // FRAME_BLENDER_HPP
@@ -0,0 +1,50 @@
+#include "pre_filter.hpp"
+#include <cmath>
+
+constexpr float DC_BLOCKER_CUTOFF = 20.0f; // Гц
+constexpr float BUTTERWORTH_Q = 0.7071f;
+
+void Biquad::setCoefficients(float nb0, float nb1, float nb2, float na0, float na1, float na2) {
+    b0 = nb0 / na0;
+    b1 = nb1 / na0;
+    b2 = nb2 / na0;
+    a1 = na1 / na0;
+    a2 = na2 / na0;
+}
+
+void Biquad::setHighPass(float sampleRate, float cutoff, float q) {
+    float w0 = 2.0f * (float)M_PI * cutoff / sampleRate;
+    float cosW0 = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * q);
+    setCoefficients((1.0f + cosW0) / 2.0f, -(1.0f + cosW0), (1.0f + cosW0) / 2.0f,
+                    1.0f + alpha, -2.0f * cosW0, 1.0f - alpha);
+}
+
+void Biquad::setLowPass(float sampleRate, float cutoff, float q) {
+    float w0 = 2.0f * (float)M_PI * cutoff / sampleRate;
+    float cosW0 = cosf(w0);
+    float alpha = sinf(w0) / (2.0f * q);
+    setCoefficients((1.0f - cosW0) / 2.0f, 1.0f - cosW0, (1.0f - cosW0) / 2.0f,
+                    1.0f + alpha, -2.0f * cosW0, 1.0f - alpha);
+}
+
+void Biquad::setPreEmphasis(float coefficient) {
+    setCoefficients(1.0f, -coefficient, 0.0f, 1.0f, 0.0f, 0.0f);
+}
+
+float Biquad::prime(float input) {
+    // Для постоянного входа x выход y = x * H(1), состояние — из уравнений фильтра
+    float output = input * (b0 + b1 + b2) / (1.0f + a1 + a2);
+    s2 = b2 * input - a2 * output;
+    s1 = b1 * input - a1 * output + s2;
+    return output;
+}
+
+void PreFilter::configure(float sampleRate, float lowPassCutoff, float preEmphasis) {
+    dcBlocker.setHighPass(sampleRate, DC_BLOCKER_CUTOFF, BUTTERWORTH_Q);
+    lowPass.setLowPass(sampleRate, lowPassCutoff, BUTTERWORTH_Q);
+    emphasisEnabled = preEmphasis > 0.0f;
+    if (emphasisEnabled) {
+        emphasis.setPreEmphasis(preEmphasis);
+    }
+}
@@ -0,0 +1,60 @@
+#ifndef PRE_FILTER_HPP
+#define PRE_FILTER_HPP
+
+// Биквад в транспонированной прямой форме II.
+// Два элемента состояния переходят из блока в блок, поэтому фильтр
+// работает потоком по мере поступления отсчётов.
+class Biquad {
+public:
+    // Коэффициенты по формулам RBJ (Audio EQ Cookbook), a0 нормирован к 1
+    void setHighPass(float sampleRate, float cutoff, float q);
+    void setLowPass(float sampleRate, float cutoff, float q);
+    // Предыскажение первого порядка y = x - k * x[n-1]
+    void setPreEmphasis(float coefficient);
+
+    // Установившееся состояние для постоянного входа; возвращает выход
+    float prime(float input);
+    void reset() { s1 = s2 = 0.0f; }
+
+    inline float process(float input) {
+        float output = b0 * input + s1;
+        s1 = b1 * input - a1 * output + s2;
+        s2 = b2 * input - a2 * output;
+        return output;
+    }
+
+private:
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f;
+    float a1 = 0.0f, a2 = 0.0f;
+    float s1 = 0.0f, s2 = 0.0f;
+
+    void setCoefficients(float nb0, float nb1, float nb2, float na0, float na1, float na2);
+};
+
+// Входная цепочка анализатора: DC-блокер, НЧ-фильтр, необязательное предыскажение.
+// Коэффициенты считаются в configure() при изменении настроек, а не в цикле отсчётов.
+class PreFilter {
+public:
+    void configure(float sampleRate, float lowPassCutoff, float preEmphasis);
+    void reset() { primed = false; }
+
+    inline float process(float input) {
+        if (!primed) {
+            // Первый отсчёт задаёт установившееся состояние: без этого
+            // постоянная составляющая АЦП дала бы длинный переходный процесс
+            emphasis.prime(lowPass.prime(dcBlocker.prime(input)));
+            primed = true;
+        }
+        float output = lowPass.process(dcBlocker.process(input));
+        return emphasisEnabled ? emphasis.process(output) : output;
+    }
+
+private:
+    Biquad dcBlocker;
+    Biquad lowPass;
+    Biquad emphasis;
+    bool emphasisEnabled = false;
+    bool primed = false;
+};
+
+#endif // PRE_FILTER_HPP
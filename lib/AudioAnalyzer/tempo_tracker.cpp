@@ -0,0 +1,200 @@
+#include "tempo_tracker.hpp"
+#include "deferred_log.hpp"
+#include <Arduino.h>
+#include <cfloat>
+#include <cmath>
+
+TempoTracker::TempoTracker() : FFT(vReal, vImag, FFT_SIZE, TEMPO_ENVELOPE_RATE) {
+    // Логнормальный вес шириной в октаву: сдвиг в два раза больше или меньше
+    // пика выигрывает у него только при заметно большей корреляции
+    for (int lag = MIN_LAG; lag <= MAX_LAG; lag++) {
+        float octaves = log2f(TEMPO_ENVELOPE_RATE * 60.0f / lag / PREFERRED_BPM);
+        lagWeights[lag - MIN_LAG] = expf(-0.5f * octaves * octaves);
+    }
+    reset();
+}
+
+void TempoTracker::reset() {
+    memset(envelope, 0, sizeof(envelope));
+    head = 0;
+    newSlots = 0;
+    pendingOnset = 0;
+    started = false;
+    stage = Stage::Collect;
+    candidateUs = 0;
+    confidence = 0;
+    locked = false;
+}
+
+void TempoTracker::update(float logEnergy, uint32_t nowUs) {
+    if (!started) {
+        started = true;
+        previousEnergy = logEnergy;
+        nextSlotUs = nowUs + SLOT_US;
+        return;
+    }
+    // После долгого перерыва (задача стояла) огибающая начинается заново
+    if ((int32_t)(nowUs - nextSlotUs) >= (int32_t)(ENVELOPE_SIZE * SLOT_US)) {
+        if (locked) {
+            LOG(TempoLost);
+        }
+        reset();
+        started = true;
+        previousEnergy = logEnergy;
+        nextSlotUs = nowUs + SLOT_US;
+        return;
+    }
+
+    // Прошедшие отсчёты закрываются до прироста этого цикла: в пустые
+    // отсчёты (анализ реже огибающей) попадает ноль
+    while ((int32_t)(nowUs - nextSlotUs) >= 0) {
+        envelope[head & (ENVELOPE_SIZE - 1)] = pendingOnset;
+        head++;
+        newSlots++;
+        pendingOnset = 0;
+        nextSlotUs += SLOT_US;
+    }
+    float onset = logEnergy - previousEnergy;
+    previousEnergy = logEnergy;
+    if (onset > pendingOnset) {
+        pendingOnset = onset;
+    }
+
+    step();
+}
+
+void TempoTracker::step() {
+    switch (stage) {
+        case Stage::Collect:
+            if (newSlots >= TEMPO_UPDATE_INTERVAL && head >= MIN_ENVELOPE) {
+                newSlots = 0;
+                stage = Stage::Prepare;
+            }
+            break;
+        case Stage::Prepare:
+            prepare();
+            stage = Stage::Forward;
+            break;
+        case Stage::Forward:
+            FFT.compute(FFT_FORWARD);
+            stage = Stage::Power;
+            break;
+        case Stage::Power:
+            for (int i = 0; i < FFT_SIZE; i++) {
+                vReal[i] = vReal[i] * vReal[i] + vImag[i] * vImag[i];
+                vImag[i] = 0;
+            }
+            stage = Stage::Inverse;
+            break;
+        case Stage::Inverse:
+            FFT.compute(FFT_REVERSE);
+            stage = Stage::Tempo;
+            break;
+        case Stage::Tempo:
+            estimateTempo();
+            stage = locked ? Stage::Phase : Stage::Collect;
+            break;
+        case Stage::Phase:
+            estimatePhase();
+            stage = Stage::Collect;
+            break;
+    }
+}
+
+// Снимок от старого отсчёта к новому; вторая половина — нули
+void TempoTracker::prepare() {
+    snapshotSize = head < ENVELOPE_SIZE ? head : ENVELOPE_SIZE;
+    uint32_t first = head - snapshotSize;
+    float mean = 0;
+    for (uint16_t i = 0; i < snapshotSize; i++) {
+        mean += envelope[(first + i) & (ENVELOPE_SIZE - 1)];
+    }
+    mean /= snapshotSize;
+    // Сглаживание [1 2 1] / 4: при дробном периоде доли в отсчётах щелчки
+    // ложатся через разное число отсчётов, и без него пик автокорреляции
+    // делится между соседними сдвигами и проигрывает удвоенному периоду
+    float previous = 0;
+    for (uint16_t i = 0; i < FFT_SIZE; i++) {
+        float current = i < snapshotSize ? envelope[(first + i) & (ENVELOPE_SIZE - 1)] - mean : 0;
+        float next = i + 1 < snapshotSize ? envelope[(first + i + 1) & (ENVELOPE_SIZE - 1)] - mean : 0;
+        vReal[i] = i < snapshotSize ? 0.25f * (previous + 2 * current + next) : 0;
+        vImag[i] = 0;
+        previous = current;
+    }
+}
+
+// Новый период принимается, если его подтвердила и следующая оценка;
+// близкий к текущему только подтягивает его
+void TempoTracker::estimateTempo() {
+    float zero = correlation(0);
+    if (zero <= 0) {
+        confidence = 0;
+    } else {
+        int best = MIN_LAG;
+        float bestScore = -FLT_MAX;
+        for (int lag = MIN_LAG; lag <= MAX_LAG; lag++) {
+            float score = correlation(lag) * lagWeights[lag - MIN_LAG];
+            if (score > bestScore) {
+                bestScore = score;
+                best = lag;
+            }
+        }
+        confidence = correlation(best) / zero;
+
+        // Дробный сдвиг по параболе через три соседние точки
+        float before = correlation(best - 1), peak = correlation(best), after = correlation(best + 1);
+        float curvature = before - 2 * peak + after;
+        float offset = curvature < 0 ? constrain(0.5f * (before - after) / curvature, -0.5f, 0.5f) : 0.0f;
+        float period = (best + offset) * SLOT_US;
+
+        if (confidence >= MIN_CONFIDENCE) {
+            if (locked && fabsf(period - periodUs) < periodUs * PERIOD_TOLERANCE) {
+                periodUs += (period - periodUs) * 0.25f;
+                candidateUs = 0;
+            } else if (candidateUs > 0 && fabsf(period - candidateUs) < candidateUs * PERIOD_TOLERANCE) {
+                periodUs = (period + candidateUs) * 0.5f;
+                candidateUs = 0;
+                locked = true;
+                LOG(TempoLocked, getBpm(), confidence);
+            } else {
+                candidateUs = period;
+            }
+            return;
+        }
+    }
+    candidateUs = 0;
+    if (locked) {
+        locked = false;
+        LOG(TempoLost);
+    }
+}
+
+// Гребёнка с шагом в период, приложенная к кольцу с каждым сдвигом от
+// нового отсчёта: сдвиг с наибольшей средней огибающей — последняя доля
+void TempoTracker::estimatePhase() {
+    float period = periodUs / SLOT_US;
+    int offsets = (int)ceilf(period);
+    uint16_t count = head < ENVELOPE_SIZE ? head : ENVELOPE_SIZE;
+    float* scores = vImag; // После оценки темпа свободен
+    for (int offset = 0; offset < offsets; offset++) {
+        float sum = 0;
+        int teeth = 0;
+        for (float age = offset; age + 0.5f < count; age += period, teeth++) {
+            sum += envelope[(head - 1 - (uint32_t)lroundf(age)) & (ENVELOPE_SIZE - 1)];
+        }
+        scores[offset] = teeth ? sum / teeth : 0;
+    }
+    int best = 0;
+    for (int offset = 1; offset < offsets; offset++) {
+        if (scores[offset] > scores[best]) {
+            best = offset;
+        }
+    }
+    float before = scores[(best + offsets - 1) % offsets], peak = scores[best], after = scores[(best + 1) % offsets];
+    float curvature = before - 2 * peak + after;
+    float age = best + (curvature < 0 ? constrain(0.5f * (before - after) / curvature, -0.5f, 0.5f) : 0.0f);
+
+    // Середина нового отсчёта кольца — полтора отсчёта до конца текущего
+    uint32_t newestUs = nextSlotUs - SLOT_US - SLOT_US / 2;
+    beatUs = newestUs - (int32_t)lroundf(age * SLOT_US);
+}
@@ -0,0 +1,85 @@
+#ifndef TEMPO_TRACKER_HPP
+#define TEMPO_TRACKER_HPP
+
+#include <arduinoFFT.h>
+#include <stdint.h>
+#include "config.hpp"
+
+// Темп и фаза долей по огибающей логарифмической энергии.
+// Огибающая — прирост энергии за цикл анализа (спад отбрасывается),
+// собранный в отсчёты постоянной частоты TEMPO_ENVELOPE_RATE: частота
+// анализа меняется и в простое падает. Последние TEMPO_ENVELOPE_SIZE
+// отсчётов лежат в кольце. Раз в TEMPO_UPDATE_INTERVAL новых отсчётов снимок
+// кольца автокоррелируется через FFT с дополнением нулями. Оценка разбита на
+// шаги, и update() выполняет не больше одного шага за цикл анализа, поэтому
+// ни один цикл не платит за неё целиком.
+class TempoTracker {
+public:
+    static constexpr uint16_t ENVELOPE_SIZE = TEMPO_ENVELOPE_SIZE;
+    static constexpr uint16_t FFT_SIZE = ENVELOPE_SIZE * 2; // Дополнение нулями: без кругового наложения сдвигов
+    static constexpr uint32_t SLOT_US = 1000000 / TEMPO_ENVELOPE_RATE;
+    static constexpr uint16_t MIN_LAG = TEMPO_ENVELOPE_RATE * 60 / TEMPO_MAX_BPM;
+    static constexpr uint16_t MAX_LAG = (TEMPO_ENVELOPE_RATE * 60 + TEMPO_MIN_BPM - 1) / TEMPO_MIN_BPM;
+    static constexpr uint16_t MIN_ENVELOPE = ENVELOPE_SIZE / 2; // Отсчётов до первой оценки
+    static constexpr float PREFERRED_BPM = 120.0f; // Из кратных темпов предпочитается ближний к нему
+    static constexpr float MIN_CONFIDENCE = 0.2f;  // Пик автокорреляции относительно нулевого сдвига
+    static constexpr float PERIOD_TOLERANCE = 0.08f; // Оценки ближе этой доли периода — один темп
+
+    static_assert((ENVELOPE_SIZE & (ENVELOPE_SIZE - 1)) == 0, "TEMPO_ENVELOPE_SIZE must be a power of two");
+    static_assert(MIN_LAG >= 2 && MIN_LAG < MAX_LAG, "TEMPO_MIN_BPM..TEMPO_MAX_BPM must span several envelope samples");
+    static_assert(MAX_LAG * 2 < MIN_ENVELOPE, "TEMPO_ENVELOPE_SIZE must hold four beats of TEMPO_MIN_BPM");
+
+    TempoTracker();
+    void reset();
+
+    // Энергия цикла анализа (дБ) и его время micros()
+    void update(float logEnergy, uint32_t nowUs);
+
+    bool isLocked() const { return locked; }
+    float getBpm() const { return locked ? 60000000.0f / periodUs : 0.0f; }
+    uint32_t getBeatPeriodUs() const { return locked ? (uint32_t)periodUs : 0; } // 0 — темп не захвачен
+    uint32_t getBeatUs() const { return beatUs; } // micros() одной из прошедших долей
+    float getConfidence() const { return confidence; }
+
+private:
+    // Шаги оценки; Collect — ожидание новых отсчётов
+    enum class Stage : uint8_t {
+        Collect,
+        Prepare, // Снимок кольца без среднего
+        Forward, // Прямое FFT
+        Power,   // Спектр мощности
+        Inverse, // Обратное FFT: автокорреляция
+        Tempo,   // Пик автокорреляции в диапазоне темпов
+        Phase    // Сдвиг гребёнки долей по кольцу
+    };
+
+    float envelope[ENVELOPE_SIZE];
+    uint32_t head = 0;          // Всего записано отсчётов огибающей
+    uint16_t newSlots = 0;      // Отсчётов с последней оценки
+    uint32_t nextSlotUs = 0;    // Конец текущего отсчёта
+    float pendingOnset = 0;     // Наибольший прирост энергии в текущем отсчёте
+    float previousEnergy = 0;
+    bool started = false;
+
+    ArduinoFFT<float> FFT;
+    float vReal[FFT_SIZE];
+    float vImag[FFT_SIZE];
+    float lagWeights[MAX_LAG - MIN_LAG + 1]; // Предпочтение темпов около PREFERRED_BPM
+    uint16_t snapshotSize = 0;
+    Stage stage = Stage::Collect;
+
+    float periodUs = 0;        // Период доли
+    float candidateUs = 0;     // Новый период ждёт подтверждения следующей оценкой
+    uint32_t beatUs = 0;
+    float confidence = 0;
+    bool locked = false;
+
+    void step();
+    void prepare();
+    void estimateTempo();
+    void estimatePhase();
+    // Автокорреляция сдвига lag без смещения от длины снимка
+    float correlation(int lag) const { return vReal[lag] / (snapshotSize - lag); }
+};
+
+#endif // TEMPO_TRACKER_HPP
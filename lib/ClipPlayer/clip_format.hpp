@@ -0,0 +1,58 @@
+#ifndef CLIP_FORMAT_HPP
+#define CLIP_FORMAT_HPP
+
+#include <stdint.h>
+
+// Формат образа клипов в разделе flash (little-endian, как ESP32 и хост).
+//
+// Образ: ClipImageHeader, clipCount записей ClipDirectoryEntry, затем клипы.
+// Клип:  ClipHeader, keyframeCount смещений ключевых кадров (u32 от начала
+//        клипа), затем кадры подряд. Ключевой — каждый keyframeInterval-й кадр.
+//
+// Кадр — поток операций над холстом NUM_LEDS пикселей в порядке ленты
+// (LedMatrix::XY), пока не пройдены все пиксели. Байт операции: старшие
+// два бита — код, младшие шесть — длина минус один (1..64 пикселя):
+//   00 — пропустить: пиксели как в прошлом кадре
+//   01 — литерал: следом длина * 3 байта RGB
+//   10 — серия: следом 3 байта RGB одного цвета
+// Ключевые кадры не содержат пропусков, поэтому декодируются без истории.
+
+constexpr char CLIP_IMAGE_MAGIC[4] = {'L', 'M', 'C', 'I'};
+constexpr char CLIP_MAGIC[4] = {'L', 'M', 'C', 'L'};
+constexpr uint8_t CLIP_FORMAT_VERSION = 1;
+constexpr uint8_t CLIP_NAME_LENGTH = 16; // С завершающим нулём
+
+constexpr uint8_t CLIP_OP_SKIP = 0x00;
+constexpr uint8_t CLIP_OP_LITERAL = 0x40;
+constexpr uint8_t CLIP_OP_RUN = 0x80;
+constexpr uint8_t CLIP_OP_MASK = 0xC0;
+constexpr uint8_t CLIP_OP_MAX_LENGTH = 64;
+
+struct ClipImageHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t reserved;
+    uint16_t clipCount;
+};
+
+struct ClipDirectoryEntry {
+    char name[CLIP_NAME_LENGTH];
+    uint32_t offset; // От начала образа
+    uint32_t size;
+};
+
+struct ClipHeader {
+    char magic[4];
+    uint8_t width;
+    uint8_t height;
+    uint16_t frameIntervalMs;
+    uint32_t frameCount;
+    uint16_t keyframeInterval;
+    uint16_t keyframeCount;
+};
+
+static_assert(sizeof(ClipImageHeader) == 8, "ClipImageHeader layout");
+static_assert(sizeof(ClipDirectoryEntry) == 24, "ClipDirectoryEntry layout");
+static_assert(sizeof(ClipHeader) == 16, "ClipHeader layout");
+
+#endif // CLIP_FORMAT_HPP
@@ -0,0 +1,195 @@
+#include "clip_reader.hpp"
+#include "deferred_log.hpp"
+#include <string.h>
+
+// ======================
+//    ClipReader
+// ======================
+bool ClipReader::open(const uint8_t* clipData, size_t clipSize) {
+    close();
+    if (!clipData || clipSize < sizeof(ClipHeader)) {
+        return false;
+    }
+    ClipHeader h;
+    memcpy(&h, clipData, sizeof(h));
+    if (memcmp(h.magic, CLIP_MAGIC, sizeof(h.magic)) != 0) {
+        LOG(ClipBadMagic);
+        return false;
+    }
+    if (h.width != MATRIX_WIDTH || h.height != MATRIX_HEIGHT) {
+        LOG(ClipSizeMismatch, h.width, h.height, MATRIX_WIDTH, MATRIX_HEIGHT);
+        return false;
+    }
+    if (h.frameCount == 0 || h.frameIntervalMs == 0 || h.keyframeInterval == 0 ||
+        h.keyframeCount != (h.frameCount + h.keyframeInterval - 1) / h.keyframeInterval ||
+        sizeof(ClipHeader) + (size_t)h.keyframeCount * 4 > clipSize) {
+        LOG(ClipBadHeader);
+        return false;
+    }
+
+    data = clipData;
+    size = clipSize;
+    header = h;
+    // Смещения индекса проверяются один раз, чтобы seek() им доверял
+    for (uint16_t i = 0; i < header.keyframeCount; i++) {
+        uint32_t offset = keyframeOffset(i);
+        if (offset < sizeof(ClipHeader) + (size_t)header.keyframeCount * 4 || offset >= size) {
+            LOG(ClipBadKeyframes);
+            close();
+            return false;
+        }
+    }
+    cursor = keyframeOffset(0);
+    nextFrame = 0;
+    return true;
+}
+
+void ClipReader::close() {
+    data = nullptr;
+    size = 0;
+    header = {};
+    cursor = 0;
+    nextFrame = 0;
+}
+
+uint32_t ClipReader::keyframeOffset(uint16_t index) const {
+    uint32_t offset;
+    memcpy(&offset, data + sizeof(ClipHeader) + (size_t)index * 4, sizeof(offset));
+    return offset;
+}
+
+bool ClipReader::decodeNext(CRGB* canvas) {
+    if (!data || nextFrame >= header.frameCount) {
+        return false;
+    }
+
+    const uint8_t* p = data + cursor;
+    const uint8_t* end = data + size;
+    uint8_t* out = canvas[0].raw;
+    int pixel = 0;
+    while (pixel < NUM_LEDS) {
+        if (p >= end) {
+            break;
+        }
+        uint8_t op = *p++;
+        int length = (op & ~CLIP_OP_MASK) + 1;
+        if (pixel + length > NUM_LEDS) {
+            break;
+        }
+        switch (op & CLIP_OP_MASK) {
+            case CLIP_OP_SKIP:
+                break;
+            case CLIP_OP_LITERAL:
+                if (end - p < length * 3) {
+                    p = end;
+                    continue;
+                }
+                memcpy(out + pixel * 3, p, length * 3);
+                p += length * 3;
+                break;
+            case CLIP_OP_RUN:
+                if (end - p < 3) {
+                    p = end;
+                    continue;
+                }
+                for (int i = 0; i < length; i++) {
+                    memcpy(out + (pixel + i) * 3, p, 3);
+                }
+                p += 3;
+                break;
+            default:
+                p = end;
+                continue;
+        }
+        pixel += length;
+    }
+
+    if (pixel != NUM_LEDS) {
+        LOG(ClipCorruptFrame, nextFrame);
+        nextFrame = header.frameCount; // Дальше читать нельзя
+        return false;
+    }
+    cursor = p - data;
+    nextFrame++;
+    return true;
+}
+
+bool ClipReader::seek(uint32_t frame, CRGB* canvas) {
+    if (!data || frame >= header.frameCount) {
+        return false;
+    }
+    // Вперёд в пределах группы ключевого кадра — только дельты
+    uint16_t key = frame / header.keyframeInterval;
+    bool sameGroup = nextFrame > 0 && nextFrame <= frame && (nextFrame - 1) / header.keyframeInterval == key;
+    if (!sameGroup) {
+        cursor = keyframeOffset(key);
+        nextFrame = (uint32_t)key * header.keyframeInterval;
+    }
+    while (nextFrame <= frame) {
+        if (!decodeNext(canvas)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ======================
+//    ClipDirectory
+// ======================
+bool ClipDirectory::open(const uint8_t* imageData, size_t imageSize) {
+    data = nullptr;
+    size = 0;
+    clipCount = 0;
+    if (!imageData || imageSize < sizeof(ClipImageHeader)) {
+        return false;
+    }
+    ClipImageHeader h;
+    memcpy(&h, imageData, sizeof(h));
+    if (memcmp(h.magic, CLIP_IMAGE_MAGIC, sizeof(h.magic)) != 0 || h.version != CLIP_FORMAT_VERSION) {
+        LOG(ClipNoImage);
+        return false;
+    }
+    if (sizeof(ClipImageHeader) + (size_t)h.clipCount * sizeof(ClipDirectoryEntry) > imageSize) {
+        LOG(ClipDirectoryOverflow);
+        return false;
+    }
+    data = imageData;
+    size = imageSize;
+    clipCount = h.clipCount;
+    return true;
+}
+
+bool ClipDirectory::readEntry(uint16_t index, ClipDirectoryEntry& entry) const {
+    if (index >= clipCount) {
+        return false;
+    }
+    memcpy(&entry, data + sizeof(ClipImageHeader) + (size_t)index * sizeof(entry), sizeof(entry));
+    entry.name[CLIP_NAME_LENGTH - 1] = '\0';
+    return entry.offset <= size && entry.size <= size - entry.offset;
+}
+
+const char* ClipDirectory::getClipName(uint16_t index, char* name) const {
+    ClipDirectoryEntry entry;
+    if (!readEntry(index, entry)) {
+        name[0] = '\0';
+    } else {
+        memcpy(name, entry.name, CLIP_NAME_LENGTH);
+    }
+    return name;
+}
+
+bool ClipDirectory::openClip(uint16_t index, ClipReader& reader) const {
+    ClipDirectoryEntry entry;
+    return readEntry(index, entry) && reader.open(data + entry.offset, entry.size);
+}
+
+bool ClipDirectory::openClip(const char* name, ClipReader& reader) const {
+    ClipDirectoryEntry entry;
+    for (uint16_t i = 0; i < clipCount; i++) {
+        if (readEntry(i, entry) && strncmp(entry.name, name, CLIP_NAME_LENGTH) == 0) {
+            return reader.open(data + entry.offset, entry.size);
+        }
+    }
+    LOG(ClipNotFound, name);
+    return false;
+}
@@ -0,0 +1,57 @@
+#ifndef CLIP_READER_HPP
+#define CLIP_READER_HPP
+
+#include <FastLED.h>
+#include "config.hpp"
+#include "clip_format.hpp"
+
+// Декодер одного клипа прямо из отображённой памяти (flash или файл).
+// Сжатые данные не копируются: операции читаются по указателю и пишутся
+// сразу в холст. Дельта-кадры применяются к прошлому содержимому холста,
+// поэтому холст между вызовами должен сохраняться.
+class ClipReader {
+public:
+    // Проверить заголовок и индекс клипа; данные должны жить дольше читателя
+    bool open(const uint8_t* data, size_t size);
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+    uint32_t getFrameCount() const { return header.frameCount; }
+    uint16_t getFrameIntervalMs() const { return header.frameIntervalMs; }
+    uint16_t getKeyframeInterval() const { return header.keyframeInterval; }
+    uint32_t getNextFrame() const { return nextFrame; } // Номер следующего декодируемого кадра
+
+    // Декодировать следующий кадр поверх холста из NUM_LEDS пикселей
+    bool decodeNext(CRGB* canvas);
+    // Перейти к кадру frame: ближайший ключевой кадр и дельты до frame включительно
+    bool seek(uint32_t frame, CRGB* canvas);
+
+private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    ClipHeader header = {};
+    size_t cursor = 0; // Смещение следующего кадра от начала клипа
+    uint32_t nextFrame = 0;
+
+    uint32_t keyframeOffset(uint16_t index) const;
+};
+
+// Каталог клипов в образе раздела
+class ClipDirectory {
+public:
+    bool open(const uint8_t* data, size_t size);
+
+    uint16_t getClipCount() const { return clipCount; }
+    const char* getClipName(uint16_t index, char* name) const; // name — CLIP_NAME_LENGTH байт
+    bool openClip(uint16_t index, ClipReader& reader) const;
+    bool openClip(const char* name, ClipReader& reader) const;
+
+private:
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    uint16_t clipCount = 0;
+
+    bool readEntry(uint16_t index, ClipDirectoryEntry& entry) const;
+};
+
+#endif // CLIP_READER_HPP
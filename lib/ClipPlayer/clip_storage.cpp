@@ -0,0 +1,38 @@
+#include "clip_storage.hpp"
+#include "deferred_log.hpp"
+
+ClipStorage::~ClipStorage() {
+    end();
+}
+
+bool ClipStorage::begin(const char* label) {
+    end();
+    const esp_partition_t* partition =
+        esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label);
+    if (!partition) {
+        LOG(StorageNoPartition, label);
+        return false;
+    }
+
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size, SPI_FLASH_MMAP_DATA, &mapped, &mapHandle);
+    if (err != ESP_OK) {
+        LOG(StorageMapFailed, label, err);
+        mapped = nullptr;
+        return false;
+    }
+    if (!directory.open(static_cast<const uint8_t*>(mapped), partition->size)) {
+        end();
+        return false;
+    }
+    LOG(StorageReady, directory.getClipCount(), label, (unsigned)(partition->size / 1024));
+    return true;
+}
+
+void ClipStorage::end() {
+    if (mapped) {
+        spi_flash_munmap(mapHandle);
+        mapped = nullptr;
+        mapHandle = 0;
+    }
+    directory = ClipDirectory();
+}
@@ -0,0 +1,29 @@
+#ifndef CLIP_STORAGE_HPP
+#define CLIP_STORAGE_HPP
+
+#include <Arduino.h>
+#include <esp_partition.h>
+#include <esp_spi_flash.h>
+#include "clip_reader.hpp"
+
+// Раздел flash с образом клипов, отображённый в адресное пространство.
+// Клипы читаются прямо из кэша flash без копирования в RAM.
+// На хосте раздел — файл, отображённый через mmap (см. host/shim).
+// Открытые читатели клипов действительны до end().
+class ClipStorage {
+public:
+    ~ClipStorage();
+
+    bool begin(const char* label = CLIP_PARTITION_LABEL);
+    void end();
+
+    bool isReady() const { return mapped != nullptr; }
+    const ClipDirectory& getDirectory() const { return directory; }
+
+private:
+    const void* mapped = nullptr;
+    spi_flash_mmap_handle_t mapHandle = 0;
+    ClipDirectory directory;
+};
+
+#endif // CLIP_STORAGE_HPP
@@ -0,0 +1,137 @@
+#include "deferred_log.hpp"
+
+DeferredLog::Ring DeferredLog::rings[portNUM_PROCESSORS];
+volatile uint8_t DeferredLog::runtimeLevel = LOG_LEVEL;
+TaskHandle_t DeferredLog::taskHandle = nullptr;
+std::atomic_flag DeferredLog::draining = ATOMIC_FLAG_INIT;
+
+void DeferredLog::begin() {
+    if (taskHandle) {
+        return;
+    }
+    if (xTaskCreatePinnedToCore(task, "LogTask", LOG_TASK_STACK_SIZE, nullptr, LOG_TASK_PRIORITY,
+                                &taskHandle, LOG_TASK_CORE) != pdPASS) {
+        taskHandle = nullptr; // Хост: записи выводятся сразу
+    }
+}
+
+void DeferredLog::write(LogEvent event, const uint32_t* args, uint8_t count) {
+    // Маска прерываний своего ядра: ни другая задача, ни прерывание этого ядра
+    // не вклинятся в запись, а ядро не сменится до её конца
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    uint8_t core = xPortGetCoreID();
+    Ring& ring = rings[core];
+    uint32_t head = ring.head.load(std::memory_order_relaxed);
+    uint32_t used = head - ring.tail.load(std::memory_order_acquire);
+    uint32_t size = LOG_HEADER_WORDS + count;
+
+    if (RING_WORDS - used < size) {
+        ring.dropped = ring.dropped + 1;
+    } else {
+        ring.words[head & (RING_WORDS - 1)] = packLogHeader((uint8_t)event, count, core);
+        ring.words[(head + 1) & (RING_WORDS - 1)] = micros();
+        for (uint8_t i = 0; i < count; i++) {
+            ring.words[(head + LOG_HEADER_WORDS + i) & (RING_WORDS - 1)] = args[i];
+        }
+        ring.head.store(head + size, std::memory_order_release);
+    }
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+
+    if (!taskHandle) {
+        drain();
+    }
+}
+
+// Без задачи вывода пишут и выводят задачи обоих ядер сразу. Флаг оставляет
+// кольцам одного читателя. Запись, добавленная, пока флаг снимался,
+// подхватывается повторной проверкой, а не ждёт следующего LOG
+void DeferredLog::drain() {
+    do {
+        if (draining.test_and_set()) {
+            return;
+        }
+        while (drainOne()) {
+        }
+        reportDropped();
+        draining.clear();
+    } while (hasPending());
+}
+
+bool DeferredLog::hasPending() {
+    for (Ring& ring : rings) {
+        if (ring.tail.load() != ring.head.load()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Из колец выводится самая ранняя запись, так что порядок общий для обоих ядер
+bool DeferredLog::drainOne() {
+    Ring* oldest = nullptr;
+    uint32_t oldestTime = 0;
+    for (Ring& ring : rings) {
+        uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+        if (tail == ring.head.load(std::memory_order_acquire)) {
+            continue;
+        }
+        uint32_t timestamp = ring.words[(tail + 1) & (RING_WORDS - 1)];
+        if (!oldest || (int32_t)(timestamp - oldestTime) < 0) {
+            oldest = &ring;
+            oldestTime = timestamp;
+        }
+    }
+    if (!oldest) {
+        return false;
+    }
+
+    uint32_t tail = oldest->tail.load(std::memory_order_relaxed);
+    uint8_t words = LOG_HEADER_WORDS + (uint8_t)(oldest->words[tail & (RING_WORDS - 1)] >> 16);
+    uint32_t record[LOG_HEADER_WORDS + LOG_MAX_ARG_WORDS];
+    for (uint8_t i = 0; i < words; i++) {
+        record[i] = oldest->words[(tail + i) & (RING_WORDS - 1)];
+    }
+    oldest->tail.store(tail + words, std::memory_order_release);
+    output(record, words);
+    return true;
+}
+
+// LOG_BINARY: запись уходит как есть, текст собирает host/log_decoder
+void DeferredLog::output(const uint32_t* record, uint8_t words) {
+#if LOG_BINARY
+    Serial.write((const uint8_t*)record, words * sizeof(uint32_t));
+#else
+    char line[LOG_MAX_LINE];
+    uint8_t event = record[0] >> 8;
+    if (formatLogRecord(event, record + LOG_HEADER_WORDS, words - LOG_HEADER_WORDS, line, sizeof(line)) < 0) {
+        snprintf(line, sizeof(line), "[Log] Malformed record %u", event);
+    }
+    Serial.println(line);
+#endif
+}
+
+// Потери выводятся мимо колец: они могут быть снова заполнены
+void DeferredLog::reportDropped() {
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+        Ring& ring = rings[core];
+        uint32_t dropped = ring.dropped;
+        if (dropped == ring.reportedDropped) {
+            continue;
+        }
+        uint32_t record[] = {
+            packLogHeader((uint8_t)LogEvent::LogDropped, 2, core),
+            (uint32_t)micros(),
+            core,
+            dropped - ring.reportedDropped,
+        };
+        ring.reportedDropped = dropped;
+        output(record, sizeof(record) / sizeof(record[0]));
+    }
+}
+
+void DeferredLog::task(void*) {
+    while (true) {
+        drain();
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL));
+    }
+}
@@ -0,0 +1,112 @@
+#ifndef DEFERRED_LOG_HPP
+#define DEFERRED_LOG_HPP
+
+#include <Arduino.h>
+#include <atomic>
+#include <string.h>
+#include <type_traits>
+#include "config.hpp"
+#include "log_format.hpp"
+
+// Отложенный лог. Вызывающий только кладёт номер события и аргументы
+// в кольцо своего ядра (десятки наносекунд, без форматирования и Serial);
+// текст собирает и выводит задача с низким приоритетом.
+// В кольце один писатель на ядро: запись идёт с маской прерываний этого
+// ядра, поэтому блокировки между ядрами нет. Задача вывода — единственный
+// читатель обоих колец. Когда кольцо полно, запись отбрасывается и
+// считается; задача вывода сообщает о потерях событием LogDropped.
+// Пока задача не запущена (до begin(), хост), записи выводятся сразу.
+class DeferredLog {
+public:
+    static constexpr uint32_t RING_WORDS = LOG_RING_WORDS;
+    static_assert((RING_WORDS & (RING_WORDS - 1)) == 0, "LOG_RING_WORDS must be a power of two");
+
+    static void begin(); // Запустить задачу вывода
+    static TaskHandle_t getTaskHandle() { return taskHandle; }
+
+    // Уровень во время работы; события подробнее LOG_LEVEL не собираются вовсе
+    static void setLevel(LogLevel level) { runtimeLevel = (uint8_t)level; }
+    static LogLevel getLevel() { return (LogLevel)runtimeLevel; }
+
+    static uint32_t getDropped(uint8_t core) { return rings[core].dropped; }
+
+    // Вывести всё накопленное (задача вывода или вызывающий, если её нет).
+    // Читатель колец всегда один: если вывод уже идёт, вызов сразу возвращается,
+    // а записи выводит тот, кто держит вывод
+    static void drain();
+
+    template <LogEvent Event, typename... Args>
+    static void log(Args... args) {
+        constexpr LogLevel level = LOG_EVENT_LEVELS[(int)Event];
+        if constexpr ((uint8_t)level <= LOG_LEVEL) {
+            if ((uint8_t)level > runtimeLevel) {
+                return;
+            }
+            Arguments encoded;
+            (encoded.put(args), ...);
+            write(Event, encoded.words, encoded.count);
+        }
+    }
+
+private:
+    struct Ring {
+        uint32_t words[RING_WORDS];
+        std::atomic<uint32_t> head{0}; // Пишет только ядро-владелец
+        std::atomic<uint32_t> tail{0}; // Пишет только задача вывода
+        volatile uint32_t dropped = 0;
+        uint32_t reportedDropped = 0;
+    };
+
+    // Аргументы записи словами, в порядке формата
+    struct Arguments {
+        uint32_t words[LOG_MAX_ARG_WORDS];
+        uint8_t count = 0;
+
+        template <typename T>
+        typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type put(T value) {
+            if (count < LOG_MAX_ARG_WORDS) {
+                words[count++] = (uint32_t)value;
+            }
+        }
+        void put(double value) {
+            float single = value;
+            if (count < LOG_MAX_ARG_WORDS) {
+                memcpy(&words[count++], &single, sizeof(single));
+            }
+        }
+        // Строка: слово длины и текст; не влезающий хвост обрезается
+        void put(const char* text) {
+            if (count >= LOG_MAX_ARG_WORDS) {
+                return;
+            }
+            size_t room = (LOG_MAX_ARG_WORDS - count - 1) * 4;
+            size_t length = 0;
+            while (text && length < LOG_MAX_STRING && length < room && text[length]) {
+                length++;
+            }
+            size_t stringWords = (length + 3) / 4;
+            words[count++] = length;
+            if (stringWords) {
+                words[count + stringWords - 1] = 0;
+                memcpy(&words[count], text, length);
+                count += stringWords;
+            }
+        }
+    };
+
+    static Ring rings[portNUM_PROCESSORS];
+    static volatile uint8_t runtimeLevel;
+    static TaskHandle_t taskHandle;
+    static std::atomic_flag draining;
+
+    static void write(LogEvent event, const uint32_t* args, uint8_t count);
+    static bool drainOne();
+    static bool hasPending();
+    static void output(const uint32_t* record, uint8_t words);
+    static void reportDropped();
+    static void task(void* param);
+};
+
+#define LOG(event, ...) DeferredLog::log<LogEvent::event>(__VA_ARGS__)
+
+#endif // DEFERRED_LOG_HPP
@@ -0,0 +1,32 @@
+#include "latency_probe.hpp"
+
+volatile uint32_t LatencyProbe::stamps[(int)LatencyStage::Count];
+volatile int8_t LatencyProbe::lastStage = (int8_t)LatencyStage::Count;
+
+void LatencyProbe::arm() {
+    for (int i = 0; i < (int)LatencyStage::Count; i++) {
+        stamps[i] = 0;
+    }
+    lastStage = -1;
+}
+
+void LatencyProbe::mark(LatencyStage stage) {
+    markAt(stage, micros());
+}
+
+void LatencyProbe::markAt(LatencyStage stage, uint32_t timestamp) {
+    // Принимаем только следующий по порядку этап
+    if ((int8_t)stage != lastStage + 1) {
+        return;
+    }
+    stamps[(int)stage] = timestamp;
+    lastStage = (int8_t)stage;
+}
+
+bool LatencyProbe::isComplete() {
+    return lastStage == (int8_t)LatencyStage::Transmit;
+}
+
+uint32_t LatencyProbe::elapsed(LatencyStage stage) {
+    return stamps[(int)stage] - stamps[(int)LatencyStage::Inject];
+}
@@ -0,0 +1,39 @@
+#ifndef LATENCY_PROBE_HPP
+#define LATENCY_PROBE_HPP
+
+#include <Arduino.h>
+#include "config.hpp"
+
+// Этапы конвейера звук -> светодиоды
+enum class LatencyStage : uint8_t {
+    Inject,    // Начало синтетического импульса (отмечается при первом его отсчёте)
+    Capture,   // Блок отсчётов с импульсом собран
+    Analysis,  // FFT и полосы посчитаны
+    Render,    // Кадр отрисован (вход в LedMatrix::update)
+    Transmit,  // Кадр передан в ленту (FastLED.show вернулся)
+    Count
+};
+
+// Отметки времени одного прогона импульса через конвейер.
+// Каждый этап фиксируется только после предыдущего, так что кадр,
+// отрисованный до прихода импульса, не засчитывается.
+class LatencyProbe {
+public:
+    static void arm();                     // Сбросить отметки перед новым импульсом
+    static void mark(LatencyStage stage);  // Отметить этап текущим временем
+    static void markAt(LatencyStage stage, uint32_t timestamp); // Отметить этап заданным временем
+    static bool isComplete();              // Импульс дошёл до передачи кадра
+    static uint32_t elapsed(LatencyStage stage); // Время от Inject до этапа, мкс
+
+private:
+    static volatile uint32_t stamps[(int)LatencyStage::Count];
+    static volatile int8_t lastStage;
+};
+
+#if LATENCY_BENCHMARK
+#define LATENCY_MARK(stage) LatencyProbe::mark(stage)
+#else
+#define LATENCY_MARK(stage) ((void)0)
+#endif
+
+#endif // LATENCY_PROBE_HPP
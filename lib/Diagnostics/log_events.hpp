@@ -0,0 +1,89 @@
+#ifndef LOG_EVENTS_HPP
+#define LOG_EVENTS_HPP
+
+#include <stdint.h>
+
+// Уровни записей лога: чем больше, тем подробнее
+enum class LogLevel : uint8_t {
+    Error,
+    Warn,
+    Info,
+    Debug
+};
+
+// События отложенного лога: X(имя, уровень, формат printf).
+// В кольцо пишется только номер события и аргументы; по формату текст
+// собирает задача вывода на устройстве или host/log_decoder. Номер — позиция
+// в списке, поэтому декодер должен быть собран из того же дерева, что прошивка.
+// Аргументы: целые (%d %u %x %c), float (%f %e %g) и строки (%s, до LOG_MAX_STRING символов).
+#define LOG_EVENTS(X) \
+    X(LogDropped,              Warn,  "[Log] Core %u dropped %u records") \
+    X(AnalyzerInit,            Info,  "[AudioAnalyzer] Initializing...") \
+    X(AnalyzerReady,           Info,  "[AudioAnalyzer] Initialization complete.") \
+    X(AnalyzerPrefsFailed,     Error, "[AudioAnalyzer] Failed to open preferences%s.") \
+    X(AnalyzerKeyMissing,      Info,  "[AudioAnalyzer] Key '%s' not found. Using default value.") \
+    X(AnalyzerLoadedFloat,     Debug, "[AudioAnalyzer] Loaded %s: %.2f") \
+    X(AnalyzerLoadedInt,       Debug, "[AudioAnalyzer] Loaded %s: %d") \
+    X(AnalyzerSavedFloat,      Debug, "[AudioAnalyzer] Saved %s: %.2f") \
+    X(AnalyzerSavedInt,        Debug, "[AudioAnalyzer] Saved %s: %d") \
+    X(AnalyzerBadFftSize,      Warn,  "[AudioAnalyzer] Unsupported FFT size %u") \
+    X(AnalyzerBadRange,        Error, "[AudioAnalyzer] Invalid frequency range.") \
+    X(AnalyzerBadOversampling, Error, "[AudioAnalyzer] Unsupported ADC_OVERSAMPLING %d") \
+    X(TempoLocked,             Debug, "[TempoTracker] Locked %.1f BPM, confidence %.2f") \
+    X(TempoLost,               Debug, "[TempoTracker] Tempo lost") \
+    X(AnimatorInit,            Info,  "[SoundAnimator] Initializing...") \
+    X(AnimatorLoading,         Info,  "[SoundAnimator] Loading settings from NVS...") \
+    X(AnimatorReady,           Info,  "[SoundAnimator] Initialization complete.") \
+    X(AnimatorDestroyed,       Info,  "[SoundAnimator] Destructor called. Resources cleaned up.") \
+    X(AnimatorSettingFloat,    Debug, "[SoundAnimator] %-14s = %.2f") \
+    X(AnimatorSettingInt,      Debug, "[SoundAnimator] %-14s = %u") \
+    X(AnimatorRates,           Debug, "[SoundAnimator] rates          = %u / %u Hz, blend %u") \
+    X(AnimatorSavedFloat,      Debug, "[SoundAnimator] Saved %s = %.2f") \
+    X(AnimatorSavedInt,        Debug, "[SoundAnimator] Saved %s = %u") \
+    X(AnimatorBadRates,        Warn,  "[SoundAnimator] Unsupported rates %u / %u Hz") \
+    X(AnimatorSwitchPending,   Warn,  "[SoundAnimator] Previous switch is still pending!") \
+    X(AnimatorBadType,         Error, "[SoundAnimator] Unsupported animation type!") \
+    X(AnimatorIdle,            Info,  "[SoundAnimator] Silence detected, entering idle mode") \
+    X(AnimatorWake,            Info,  "[SoundAnimator] Sound detected, leaving idle mode") \
+    X(AnimatorClip,            Info,  "[SoundAnimator] Playing clip '%s' (%u frames)") \
+    X(TaskCommandTimeout,      Error, "[ControlledTask] %s did not reach %s in time") \
+    X(QualityChanged,          Info,  "[QualityGovernor] %s -> %s (avg %u us, budget %u us)") \
+    X(MatrixSyncShow,          Warn,  "[LedMatrix] Show task not started, transmitting synchronously") \
+    X(PlaylistEmpty,           Warn,  "[Playlist] No entries to play.") \
+    X(PlaylistTimerFailed,     Error, "[Playlist] Failed to create timer.") \
+    X(PlaylistSwitched,        Info,  "[Playlist] Switched to %s") \
+    X(IngestDriverFailed,      Error, "[FrameIngest] UART%d driver install failed") \
+    X(IngestListening,         Info,  "[FrameIngest] Listening on UART%d at %d baud") \
+    X(IngestManual,            Warn,  "[FrameIngest] Task not started, call service() manually") \
+    X(IngestBlank,             Info,  "[FrameIngest] No frames, blanking matrix") \
+    X(ClipBadMagic,            Error, "[ClipReader] Bad clip magic") \
+    X(ClipSizeMismatch,        Error, "[ClipReader] Clip is %ux%u, matrix is %ux%u") \
+    X(ClipBadHeader,           Error, "[ClipReader] Bad clip header") \
+    X(ClipBadKeyframes,        Error, "[ClipReader] Bad keyframe index") \
+    X(ClipCorruptFrame,        Error, "[ClipReader] Corrupt frame %u") \
+    X(ClipPending,             Warn,  "[ClipLayer] Previous clip request is still pending!") \
+    X(ClipNoImage,             Warn,  "[ClipDirectory] No clip image") \
+    X(ClipDirectoryOverflow,   Error, "[ClipDirectory] Directory exceeds image") \
+    X(ClipNotFound,            Warn,  "[ClipDirectory] Clip '%s' not found") \
+    X(StorageNoPartition,      Warn,  "[ClipStorage] Partition '%s' not found") \
+    X(StorageMapFailed,        Error, "[ClipStorage] Cannot map '%s': %d") \
+    X(StorageReady,            Info,  "[ClipStorage] %u clips in '%s' (%u KB)")
+
+#define LOG_EVENT_ENUM(name, level, format) name,
+enum class LogEvent : uint8_t {
+    LOG_EVENTS(LOG_EVENT_ENUM)
+    Count
+};
+#undef LOG_EVENT_ENUM
+
+#define LOG_EVENT_LEVEL(name, level, format) LogLevel::level,
+constexpr LogLevel LOG_EVENT_LEVELS[] = {LOG_EVENTS(LOG_EVENT_LEVEL)};
+#undef LOG_EVENT_LEVEL
+
+#define LOG_EVENT_FORMAT(name, level, format) format,
+constexpr const char* LOG_EVENT_FORMATS[] = {LOG_EVENTS(LOG_EVENT_FORMAT)};
+#undef LOG_EVENT_FORMAT
+
+static_assert((int)LogEvent::Count <= 255, "LogEvent must fit in a byte");
+
+#endif // LOG_EVENTS_HPP
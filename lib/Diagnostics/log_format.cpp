@@ -0,0 +1,112 @@
+#include "log_format.hpp"
+#include <stdio.h>
+#include <string.h>
+
+bool unpackLogHeader(uint32_t word, uint32_t timestamp, LogRecordHeader& header) {
+    header.event = word >> 8;
+    header.argWords = word >> 16;
+    header.core = word >> 24;
+    header.timestamp = timestamp;
+    return (word & 0xFF) == LOG_SYNC && header.event < (uint8_t)LogEvent::Count &&
+           header.argWords <= LOG_MAX_ARG_WORDS;
+}
+
+// Аргументы хранятся 32-битными словами, поэтому модификаторы длины
+// (l, h, z...) из спецификации выбрасываются
+int formatLogRecord(uint8_t event, const uint32_t* args, uint8_t argWords, char* out, size_t size) {
+    if (event >= (uint8_t)LogEvent::Count || size == 0) {
+        return -1;
+    }
+    const char* format = LOG_EVENT_FORMATS[event];
+    size_t length = 0;
+    uint8_t used = 0;
+    out[0] = '\0';
+
+    for (const char* p = format; *p; p++) {
+        if (*p != '%') {
+            if (length + 1 < size) {
+                out[length++] = *p;
+                out[length] = '\0';
+            }
+            continue;
+        }
+
+        char spec[16] = "%";
+        size_t specLength = 1;
+        p++;
+        while (*p && strchr("-+ #0123456789.", *p) && specLength < sizeof(spec) - 2) {
+            spec[specLength++] = *p++;
+        }
+        while (*p && strchr("hlzjtL", *p)) {
+            p++;
+        }
+        if (!*p) {
+            return -1;
+        }
+        char conversion = *p;
+        spec[specLength++] = conversion;
+        spec[specLength] = '\0';
+
+        char* tail = out + length;
+        size_t room = size - length;
+        int written = 0;
+        switch (conversion) {
+            case '%':
+                written = snprintf(tail, room, "%%");
+                break;
+            case 'd':
+            case 'i':
+                if (used + 1 > argWords) return -1;
+                written = snprintf(tail, room, spec, (int)(int32_t)args[used++]);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+            case 'c':
+                if (used + 1 > argWords) return -1;
+                written = snprintf(tail, room, spec, (unsigned)args[used++]);
+                break;
+            case 'f':
+            case 'F':
+            case 'e':
+            case 'E':
+            case 'g':
+            case 'G': {
+                if (used + 1 > argWords) return -1;
+                float value;
+                memcpy(&value, &args[used++], sizeof(value));
+                written = snprintf(tail, room, spec, (double)value);
+                break;
+            }
+            case 's': {
+                if (used + 1 > argWords) return -1;
+                uint32_t stringLength = args[used++];
+                uint32_t stringWords = (stringLength + 3) / 4;
+                if (stringLength > LOG_MAX_STRING || used + stringWords > argWords) return -1;
+                char text[LOG_MAX_STRING + 1];
+                memcpy(text, &args[used], stringLength);
+                text[stringLength] = '\0';
+                used += stringWords;
+                written = snprintf(tail, room, spec, text);
+                break;
+            }
+            default:
+                return -1;
+        }
+        if (written > 0) {
+            length = written < (int)room ? length + written : size - 1;
+        }
+    }
+    return used == argWords ? (int)length : -1;
+}
+
+const char* getLogLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Error: return "E";
+        case LogLevel::Warn:  return "W";
+        case LogLevel::Info:  return "I";
+        case LogLevel::Debug: return "D";
+    }
+    return "?";
+}
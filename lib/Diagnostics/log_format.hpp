@@ -0,0 +1,39 @@
+#ifndef LOG_FORMAT_HPP
+#define LOG_FORMAT_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include "log_events.hpp"
+
+// Запись отложенного лога — в кольце и в двоичном потоке одинаковая:
+// слово заголовка, слово времени (micros) и слова аргументов.
+// Слова идут в порядке little-endian, как на ESP32.
+//   заголовок: LOG_SYNC | событие << 8 | слов аргументов << 16 | ядро << 24
+// Строковый аргумент — слово длины и символы, упакованные по четыре в слово.
+constexpr uint8_t LOG_SYNC = 0xA5;         // Не встречается в тексте ASCII
+constexpr uint8_t LOG_HEADER_WORDS = 2;
+constexpr uint8_t LOG_MAX_ARG_WORDS = 24;
+constexpr uint8_t LOG_MAX_STRING = 31;     // Длиннее — обрезается
+constexpr size_t LOG_MAX_LINE = 192;       // Строка текста записи с завершающим нулём
+
+struct LogRecordHeader {
+    uint8_t event;
+    uint8_t argWords;
+    uint8_t core;
+    uint32_t timestamp;
+};
+
+constexpr uint32_t packLogHeader(uint8_t event, uint8_t argWords, uint8_t core) {
+    return LOG_SYNC | (uint32_t)event << 8 | (uint32_t)argWords << 16 | (uint32_t)core << 24;
+}
+
+// Разобрать два слова заголовка; false — не заголовок записи
+bool unpackLogHeader(uint32_t word, uint32_t timestamp, LogRecordHeader& header);
+
+// Текст записи по формату события. Возвращает длину текста или -1, если
+// аргументы не сходятся с форматом (обрыв потока, другая версия прошивки).
+int formatLogRecord(uint8_t event, const uint32_t* args, uint8_t argWords, char* out, size_t size);
+
+const char* getLogLevelName(LogLevel level);
+
+#endif // LOG_FORMAT_HPP
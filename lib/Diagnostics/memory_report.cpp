@@ -0,0 +1,43 @@
+#include "memory_report.hpp"
+#include <esp_heap_caps.h>
+
+TaskStackInfo MemoryReport::taskStack(const char* name, TaskHandle_t handle, uint32_t stackSize) {
+    TaskStackInfo info = { name, stackSize, 0 };
+    if (handle) {
+        // В ESP-IDF глубина стека и high-water mark измеряются в байтах
+        info.highWater = uxTaskGetStackHighWaterMark(handle);
+    }
+    return info;
+}
+
+uint32_t MemoryReport::heapFree() {
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+uint32_t MemoryReport::heapMinFree() {
+    return heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+}
+
+uint32_t MemoryReport::heapLargestBlock() {
+    return heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+}
+
+void MemoryReport::printTask(const char* name, TaskHandle_t handle, uint32_t stackSize) {
+    if (!handle) {
+        Serial.printf("[Memory] Task %-10s not running\n", name);
+        return;
+    }
+    TaskStackInfo info = taskStack(name, handle, stackSize);
+    Serial.printf("[Memory] Task %-10s stack %5u / %5u used, %5u free (min)\n",
+                  info.name, (unsigned)(info.stackSize - info.highWater),
+                  (unsigned)info.stackSize, (unsigned)info.highWater);
+}
+
+void MemoryReport::printHeap() {
+    Serial.printf("[Memory] Heap free %u, min free %u, largest block %u\n",
+                  (unsigned)heapFree(), (unsigned)heapMinFree(), (unsigned)heapLargestBlock());
+}
+
+void MemoryReport::printObject(const char* name, size_t size, size_t budget) {
+    Serial.printf("[Memory] sizeof(%s) = %u / %u budget\n", name, (unsigned)size, (unsigned)budget);
+}
@@ -0,0 +1,27 @@
+#ifndef MEMORY_REPORT_HPP
+#define MEMORY_REPORT_HPP
+
+#include <Arduino.h>
+#include "config.hpp"
+
+// Снимок использования стека одной задачи
+struct TaskStackInfo {
+    const char* name;
+    uint32_t stackSize;   // Выделено, байт
+    uint32_t highWater;   // Минимальный остаток за время работы, байт
+};
+
+// Учёт памяти: стеки задач, куча и статические размеры объектов
+class MemoryReport {
+public:
+    static TaskStackInfo taskStack(const char* name, TaskHandle_t handle, uint32_t stackSize);
+    static uint32_t heapFree();      // Свободная куча сейчас
+    static uint32_t heapMinFree();   // Минимум свободной кучи с момента старта
+    static uint32_t heapLargestBlock(); // Крупнейший непрерывный блок
+
+    static void printTask(const char* name, TaskHandle_t handle, uint32_t stackSize);
+    static void printHeap();
+    static void printObject(const char* name, size_t size, size_t budget);
+};
+
+#endif // MEMORY_REPORT_HPP
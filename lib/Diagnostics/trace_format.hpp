@@ -0,0 +1,65 @@
+#ifndef TRACE_FORMAT_HPP
+#define TRACE_FORMAT_HPP
+
+#include <stdint.h>
+
+// События трассы: X(имя, категория). Номер — позиция в списке, поэтому
+// host/trace_export должен быть собран из того же дерева, что прошивка.
+#define TRACE_EVENTS(X) \
+    X(Capture,       "analysis") /* Сбор блока отсчётов */ \
+    X(Analysis,      "analysis") /* FFT, полосы, публикация кадра */ \
+    X(Render,        "render")   /* Отрисовка анимации */ \
+    X(Show,          "show")     /* Передача кадра в ленту */ \
+    X(SettingsWrite, "nvs")      /* Запись настройки в NVS */ \
+    X(Wait,          "task")     /* Задача ждёт: отдала ядро другим */ \
+    X(DeadlineMiss,  "trigger")  /* Кадр дольше бюджета, arg — время кадра, мкс */ \
+    X(Trigger,       "trigger")  /* Срабатывание записи, arg — TraceTrigger */ \
+    X(Sync,          "clock")    /* Привязка тактов к micros(): task — micros() */
+
+#define TRACE_EVENT_ENUM(name, category) name,
+enum class TraceEvent : uint8_t {
+    TRACE_EVENTS(TRACE_EVENT_ENUM)
+    Count
+};
+#undef TRACE_EVENT_ENUM
+
+#define TRACE_EVENT_NAME(name, category) #name,
+constexpr const char* TRACE_EVENT_NAMES[] = {TRACE_EVENTS(TRACE_EVENT_NAME)};
+#undef TRACE_EVENT_NAME
+
+#define TRACE_EVENT_CATEGORY(name, category) category,
+constexpr const char* TRACE_EVENT_CATEGORIES[] = {TRACE_EVENTS(TRACE_EVENT_CATEGORY)};
+#undef TRACE_EVENT_CATEGORY
+
+enum class TracePhase : uint8_t {
+    Begin,
+    End,
+    Instant
+};
+
+// Причина срабатывания записи
+enum class TraceTrigger : uint8_t {
+    Command,      // Команда 't' по Serial или TraceRecorder::trigger()
+    DeadlineMiss  // Кадр отрисовки дольше бюджета
+};
+
+// Запись кольца: 12 байт
+struct TraceRecord {
+    uint32_t cycles; // Счётчик тактов своего ядра
+    uint32_t task;   // Хэндл задачи (у Sync — micros())
+    uint8_t event;
+    uint8_t phase;
+    uint16_t arg;
+};
+
+// Дамп — текст, чтобы идти по тому же Serial, что лог и отчёты:
+//   [Trace] start <причина> <МГц> <ядер> <записей на ядро>
+//   [Trace] task <хэндл hex> <имя>            для каждой встреченной задачи
+//   [Trace] core <ядро> <записей>
+//   [Trace] <записи hex>                      до TRACE_DUMP_PER_LINE в строке
+//   [Trace] end
+// Запись hex: cycles, task (по 8 знаков), event, phase (по 2), arg (4)
+constexpr uint8_t TRACE_DUMP_PER_LINE = 8;
+constexpr uint8_t TRACE_RECORD_HEX = 24;
+
+#endif // TRACE_FORMAT_HPP
@@ -0,0 +1,127 @@
+#include "trace_recorder.hpp"
+#include <algorithm>
+
+#if TRACE_RECORDER
+
+TraceRecorder::Ring TraceRecorder::rings[portNUM_PROCESSORS];
+std::atomic<TraceRecorder::State> TraceRecorder::state{TraceRecorder::State::Recording};
+volatile TraceTrigger TraceRecorder::reason = TraceTrigger::Command;
+std::atomic<int32_t> TraceRecorder::remaining{0};
+
+void TraceRecorder::record(TraceEvent event, TracePhase phase, uint16_t arg) {
+    if (state.load(std::memory_order_relaxed) == State::Frozen) {
+        return;
+    }
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    Ring& ring = rings[xPortGetCoreID()];
+    uint32_t cycles = ESP.getCycleCount();
+    // Sync каждую четверть кольца: в дампе всегда есть привязка
+    if (!ring.synced || (ring.head & (SYNC_EVERY - 1)) == 0 || cycles - ring.syncCycles >= TRACE_SYNC_CYCLES) {
+        write(ring, cycles, micros(), TraceEvent::Sync, TracePhase::Instant, 0);
+        ring.syncCycles = cycles;
+        ring.synced = true;
+    }
+    write(ring, cycles, (uint32_t)(uintptr_t)xTaskGetCurrentTaskHandle(), event, phase, arg);
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+
+    if (state.load(std::memory_order_relaxed) == State::Triggered && remaining.fetch_sub(1) == 1) {
+        state = State::Frozen;
+    }
+}
+
+void TraceRecorder::write(Ring& ring, uint32_t cycles, uint32_t task, TraceEvent event, TracePhase phase,
+                          uint16_t arg) {
+    TraceRecord& record = ring.records[ring.head & (RECORDS - 1)];
+    record.cycles = cycles;
+    record.task = task;
+    record.event = (uint8_t)event;
+    record.phase = (uint8_t)phase;
+    record.arg = arg;
+    ring.head++;
+}
+
+void TraceRecorder::sync() {
+    UBaseType_t mask = portSET_INTERRUPT_MASK_FROM_ISR();
+    rings[xPortGetCoreID()].synced = false; // Sync запишется вместе со следующей записью
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+}
+
+// Срабатывает только первый из одновременных поводов
+bool TraceRecorder::trigger(TraceTrigger why) {
+    State expected = State::Recording;
+    if (!state.compare_exchange_strong(expected, State::Triggered)) {
+        return false;
+    }
+    reason = why;
+    remaining = TRACE_POST_TRIGGER;
+    record(TraceEvent::Trigger, TracePhase::Instant, (uint16_t)why);
+    return true;
+}
+
+void TraceRecorder::arm() {
+    for (Ring& ring : rings) {
+        ring.head = 0;
+        ring.synced = false;
+    }
+    state = State::Recording;
+}
+
+// Последние записи ядер дописаны задолго до вызова из loop(), кольца не меняются.
+// Задачи проекта не удаляются, поэтому хэндлы из записей ещё действительны
+bool TraceRecorder::dump() {
+    if (!isFrozen()) {
+        return false;
+    }
+    char line[16 + TRACE_DUMP_PER_LINE * TRACE_RECORD_HEX];
+    snprintf(line, sizeof(line), "[Trace] start %u %u %u %u", (unsigned)reason, ESP.getCpuFreqMHz(),
+             (unsigned)portNUM_PROCESSORS, (unsigned)RECORDS);
+    Serial.println(line);
+
+    constexpr uint8_t MAX_TASKS = 16;
+    uint32_t tasks[MAX_TASKS];
+    uint8_t taskCount = 0;
+    for (const Ring& ring : rings) {
+        uint32_t count = std::min(ring.head, RECORDS);
+        for (uint32_t i = ring.head - count; i != ring.head; i++) {
+            const TraceRecord& record = ring.records[i & (RECORDS - 1)];
+            if (record.event == (uint8_t)TraceEvent::Sync) {
+                continue;
+            }
+            bool known = false;
+            for (uint8_t t = 0; t < taskCount && !known; t++) {
+                known = tasks[t] == record.task;
+            }
+            if (!known && taskCount < MAX_TASKS) {
+                tasks[taskCount++] = record.task;
+                TaskHandle_t handle = (TaskHandle_t)(uintptr_t)record.task;
+                snprintf(line, sizeof(line), "[Trace] task %08x %s", (unsigned)record.task,
+                         handle ? pcTaskGetName(handle) : "main");
+                Serial.println(line);
+            }
+        }
+    }
+
+    for (uint8_t core = 0; core < portNUM_PROCESSORS; core++) {
+        const Ring& ring = rings[core];
+        uint32_t count = std::min(ring.head, RECORDS);
+        snprintf(line, sizeof(line), "[Trace] core %u %u", core, (unsigned)count);
+        Serial.println(line);
+
+        uint32_t i = ring.head - count;
+        while (i != ring.head) {
+            int length = snprintf(line, sizeof(line), "[Trace] ");
+            for (uint8_t n = 0; n < TRACE_DUMP_PER_LINE && i != ring.head; n++, i++) {
+                const TraceRecord& record = ring.records[i & (RECORDS - 1)];
+                length += snprintf(line + length, sizeof(line) - length, "%08x%08x%02x%02x%04x",
+                                   (unsigned)record.cycles, (unsigned)record.task, record.event, record.phase,
+                                   record.arg);
+            }
+            Serial.println(line);
+        }
+    }
+    Serial.println("[Trace] end");
+    arm();
+    return true;
+}
+
+#endif // TRACE_RECORDER
@@ -0,0 +1,81 @@
+#ifndef TRACE_RECORDER_HPP
+#define TRACE_RECORDER_HPP
+
+#include <Arduino.h>
+#include <atomic>
+#include "config.hpp"
+#include "trace_format.hpp"
+
+// Трасса: начало и конец этапов с тактами CPU в кольце своего ядра.
+// Кольца пишутся непрерывно и хранят последние TRACE_RECORDS_PER_CORE
+// записей. По срабатыванию (команда или пропуск срока кадра) пишется ещё
+// TRACE_POST_TRIGGER записей, после чего запись замирает до dump():
+// в дампе видно, что было до и сразу после сбоя.
+// Писатель кольца один — своё ядро под маской прерываний, как в DeferredLog.
+// Счётчики тактов ядер не связаны, поэтому каждое ядро пишет записи Sync
+// (такты и micros() одного момента): при первой записи, каждую четверть
+// кольца, раз в TRACE_SYNC_CYCLES и после light sleep, когда счётчик стоял.
+class TraceRecorder {
+public:
+    static constexpr uint32_t RECORDS = TRACE_RECORDS_PER_CORE;
+    static_assert((RECORDS & (RECORDS - 1)) == 0, "TRACE_RECORDS_PER_CORE must be a power of two");
+    static constexpr uint32_t SYNC_EVERY = RECORDS / 4;
+
+    static void record(TraceEvent event, TracePhase phase, uint16_t arg = 0);
+    static void sync(); // Счётчик тактов мог стоять (light sleep)
+
+    // false — запись уже сработала или замерла
+    static bool trigger(TraceTrigger reason);
+    static bool isFrozen() { return state.load() == State::Frozen; }
+
+    // Вывести замершую трассу в Serial и снова начать запись
+    static bool dump();
+    static void arm();
+
+private:
+    enum class State : uint8_t {
+        Recording,
+        Triggered, // Дописываются записи после срабатывания
+        Frozen
+    };
+
+    struct Ring {
+        TraceRecord records[RECORDS];
+        uint32_t head = 0;       // Пишет только своё ядро
+        uint32_t syncCycles = 0;
+        bool synced = false;
+    };
+
+    static Ring rings[portNUM_PROCESSORS];
+    static std::atomic<State> state;
+    static volatile TraceTrigger reason;
+    static std::atomic<int32_t> remaining;
+
+    static void write(Ring& ring, uint32_t cycles, uint32_t task, TraceEvent event, TracePhase phase, uint16_t arg);
+};
+
+// Отрезок до конца области видимости
+class TraceScope {
+public:
+    explicit TraceScope(TraceEvent event) : event(event) { TraceRecorder::record(event, TracePhase::Begin); }
+    ~TraceScope() { TraceRecorder::record(event, TracePhase::End); }
+
+private:
+    TraceEvent event;
+};
+
+#if TRACE_RECORDER
+#define TRACE_BEGIN(event) TraceRecorder::record(TraceEvent::event, TracePhase::Begin)
+#define TRACE_END(event) TraceRecorder::record(TraceEvent::event, TracePhase::End)
+#define TRACE_INSTANT(event, arg) TraceRecorder::record(TraceEvent::event, TracePhase::Instant, arg)
+#define TRACE_SCOPE(event) TraceScope traceScope(TraceEvent::event)
+#define TRACE_SYNC() TraceRecorder::sync()
+#else
+#define TRACE_BEGIN(event) ((void)0)
+#define TRACE_END(event) ((void)0)
+#define TRACE_INSTANT(event, arg) ((void)0)
+#define TRACE_SCOPE(event) ((void)0)
+#define TRACE_SYNC() ((void)0)
+#endif
+
+#endif // TRACE_RECORDER_HPP
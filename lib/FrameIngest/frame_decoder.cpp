@@ -0,0 +1,179 @@
+#include "frame_decoder.hpp"
+#include <string.h>
+
+constexpr uint32_t FRAME_BYTES = NUM_LEDS * 3;
+
+void FrameDecoder::beginPayload(State payloadState, uint32_t bytes) {
+    state = payloadState;
+    remaining = bytes;
+    written = 0;
+    runLength = 0;
+}
+
+// Недописанный хвост кадра гасится, чтобы в буфере не осталось старых пикселей
+FrameDecoder::Event FrameDecoder::finishFrame(CRGB* target) {
+    state = State::Sync;
+    if (written < FRAME_BYTES) {
+        memset(target[0].raw + written, 0, FRAME_BYTES - written);
+    }
+    return Event::Frame;
+}
+
+bool FrameDecoder::abort() {
+    bool inFrame = state != State::Sync && !command;
+    state = State::Sync;
+    return inFrame;
+}
+
+size_t FrameDecoder::feed(const uint8_t* data, size_t length, CRGB* target, Event& event) {
+    event = Event::None;
+    uint8_t* pixels = target[0].raw;
+    size_t i = 0;
+
+    while (i < length) {
+        switch (state) {
+            case State::Sync: {
+                uint8_t b = data[i++];
+                if (b == 'A') {
+                    header[0] = b;
+                    headerLength = 1;
+                    state = State::AdaHeader;
+                } else if (b == TPM2_START) {
+                    headerLength = 0;
+                    state = State::TpmHeader;
+                } else {
+                    syncBytes++;
+                }
+                break;
+            }
+
+            case State::AdaHeader: {
+                uint8_t b = data[i];
+                if ((headerLength == 1 && b != 'd') || (headerLength == 2 && b != 'a')) {
+                    // Не заголовок: байт проверяется заново как возможное начало
+                    syncBytes += headerLength;
+                    state = State::Sync;
+                    break;
+                }
+                header[headerLength++] = b;
+                i++;
+                if (headerLength < ADA_HEADER_LENGTH) {
+                    break;
+                }
+                if ((header[3] ^ header[4] ^ 0x55) != header[5] ||
+                    ((uint32_t)header[3] << 8 | header[4]) >= MAX_FRAME_LEDS) {
+                    state = State::Sync;
+                    event = Event::Dropped;
+                    return i;
+                }
+                tpm2 = false;
+                command = false;
+                beginPayload(State::Pixels, (((uint32_t)header[3] << 8 | header[4]) + 1) * 3);
+                break;
+            }
+
+            case State::TpmHeader: {
+                uint8_t b = data[i];
+                if (headerLength == 0 && b != TPM2_DATA && b != TPM2_RLE && b != TPM2_COMMAND && b != TPM2_ANSWER) {
+                    // Случайный 0xC9 в потоке: байт проверяется заново
+                    syncBytes++;
+                    state = State::Sync;
+                    break;
+                }
+                header[headerLength++] = b;
+                i++;
+                if (headerLength < TPM2_HEADER_LENGTH) {
+                    break;
+                }
+                uint8_t type = header[0];
+                uint32_t size = (uint32_t)header[1] << 8 | header[2];
+                uint32_t limit = type == TPM2_DATA ? MAX_FRAME_LEDS * 3
+                               : type == TPM2_RLE  ? MAX_FRAME_LEDS * 4
+                                                   : MAX_COMMAND_BYTES;
+                if (size > limit) {
+                    // Ложный заголовок не должен проглотить следующие кадры
+                    syncBytes += 1 + TPM2_HEADER_LENGTH;
+                    state = State::Sync;
+                    break;
+                }
+                tpm2 = true;
+                command = type != TPM2_DATA && type != TPM2_RLE;
+                beginPayload(command ? State::Skip : type == TPM2_RLE ? State::Runs : State::Pixels, size);
+                if (size == 0) {
+                    state = State::TpmEnd;
+                }
+                break;
+            }
+
+            case State::Pixels: {
+                // Полезная нагрузка копируется в кадр кусками, как пришла
+                uint32_t n = std::min<uint32_t>(remaining, length - i);
+                if (written < FRAME_BYTES) {
+                    memcpy(pixels + written, data + i, std::min<uint32_t>(n, FRAME_BYTES - written));
+                }
+                written += n;
+                remaining -= n;
+                i += n;
+                if (remaining == 0) {
+                    if (tpm2) {
+                        state = State::TpmEnd;
+                    } else {
+                        event = finishFrame(target);
+                        return i;
+                    }
+                }
+                break;
+            }
+
+            case State::Runs: {
+                run[runLength++] = data[i++];
+                remaining--;
+                if (runLength == sizeof(run)) {
+                    uint32_t count = run[0] + 1;
+                    for (uint32_t k = 0; k < count && written < FRAME_BYTES; k++, written += 3) {
+                        memcpy(pixels + written, run + 1, 3);
+                    }
+                    runLength = 0;
+                }
+                if (remaining == 0) {
+                    state = State::TpmEnd;
+                    if (runLength != 0) {
+                        // Обрезанный повтор: кадр не сходится
+                        state = State::Sync;
+                        event = Event::Dropped;
+                        return i;
+                    }
+                }
+                break;
+            }
+
+            case State::Skip: {
+                uint32_t n = std::min<uint32_t>(remaining, length - i);
+                remaining -= n;
+                i += n;
+                if (remaining == 0) {
+                    state = State::TpmEnd;
+                }
+                break;
+            }
+
+            case State::TpmEnd: {
+                uint8_t b = data[i++];
+                state = State::Sync;
+                if (b != TPM2_END) {
+                    if (!command) {
+                        event = Event::Dropped;
+                        return i;
+                    }
+                    break;
+                }
+                if (!command) {
+                    event = finishFrame(target);
+                    return i;
+                }
+                break;
+            }
+        }
+    }
+    return i;
+}
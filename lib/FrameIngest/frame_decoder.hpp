@@ -0,0 +1,67 @@
+#ifndef FRAME_DECODER_HPP
+#define FRAME_DECODER_HPP
+
+#include <FastLED.h>
+#include "config.hpp"
+
+// Потоковый разбор кадров от внешнего контроллера шоу.
+// Пиксели пишутся прямо в целевой буфер по мере прихода байтов, без
+// промежуточного буфера кадра. Порядок пикселей — порядок ленты
+// (LedMatrix::XY), цвет — RGB. Лишние пиксели отбрасываются, недостающие гасятся.
+//
+// Adalight:  'A' 'd' 'a' hi lo (hi ^ lo ^ 0x55), затем (hi << 8 | lo) + 1 пикселей RGB
+// TPM2:      0xC9 тип sizeHi sizeLo, size байт данных, 0x36
+//   тип 0xDA — данные RGB подряд
+//   тип 0xDB — RLE (расширение): повторы [число - 1, R, G, B], число 1..256
+//   0xC0 / 0xAA — команды и ответы, пропускаются целиком
+// Заголовки с неизвестным типом или неправдоподобным размером считаются
+// мусором: иначе случайный 0xC9 в данных проглотил бы следующие кадры.
+class FrameDecoder {
+public:
+    enum class Event : uint8_t {
+        None,    // Кадр ещё не собран
+        Frame,   // Кадр полностью записан в target
+        Dropped  // Кадр испорчен и отброшен; target может быть перезаписан частично
+    };
+
+    // Разобрать данные до конца первого завершённого или отброшенного кадра.
+    // Возвращает число поглощённых байтов; после Frame целевой буфер обычно
+    // меняется, поэтому остаток подаётся следующим вызовом.
+    size_t feed(const uint8_t* data, size_t length, CRGB* target, Event& event);
+
+    // Бросить незаконченный кадр (тайм-аут); true — кадр был начат
+    bool abort();
+    bool isInFrame() const { return state != State::Sync; }
+
+    uint32_t getSyncBytes() const { return syncBytes; } // Байтов пропущено при поиске заголовка
+
+private:
+    enum class State : uint8_t { Sync, AdaHeader, TpmHeader, Pixels, Runs, Skip, TpmEnd };
+
+    static constexpr uint8_t TPM2_START = 0xC9;
+    static constexpr uint8_t TPM2_END = 0x36;
+    static constexpr uint8_t TPM2_DATA = 0xDA;
+    static constexpr uint8_t TPM2_RLE = 0xDB;
+    static constexpr uint8_t TPM2_COMMAND = 0xC0;
+    static constexpr uint8_t TPM2_ANSWER = 0xAA;
+    static constexpr uint32_t MAX_FRAME_LEDS = 1024;   // Больше матрицы: лишнее отбрасывается
+    static constexpr uint32_t MAX_COMMAND_BYTES = 64;
+    static constexpr uint8_t ADA_HEADER_LENGTH = 6;  // 'A' 'd' 'a' hi lo checksum
+    static constexpr uint8_t TPM2_HEADER_LENGTH = 3; // Тип и размер после стартового байта
+
+    State state = State::Sync;
+    bool tpm2 = false;
+    bool command = false;    // Пакет TPM2 без кадра: пропускается
+    uint8_t header[ADA_HEADER_LENGTH];
+    uint8_t headerLength = 0;
+    uint32_t remaining = 0;  // Байтов полезной нагрузки до конца кадра
+    uint32_t written = 0;    // Байтов пикселей, записанных в кадр
+    uint8_t run[4];
+    uint8_t runLength = 0;
+    uint32_t syncBytes = 0;
+
+    void beginPayload(State payloadState, uint32_t bytes);
+    Event finishFrame(CRGB* target);
+};
+
+#endif // FRAME_DECODER_HPP
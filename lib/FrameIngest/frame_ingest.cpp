@@ -0,0 +1,170 @@
+#include "frame_ingest.hpp"
+#include "deferred_log.hpp"
+
+FrameIngest::FrameIngest(LedMatrix& matrix, uart_port_t uartPort)
+    : ledMatrix(matrix), port(uartPort), ingestTask("IngestTask", INGEST_TASK_STACK_SIZE, 1, 1) {
+}
+
+FrameIngest::~FrameIngest() {
+    stopTask();
+    if (driverInstalled) {
+        uart_driver_delete(port);
+    }
+}
+
+bool FrameIngest::begin() {
+    if (driverInstalled) {
+        return true;
+    }
+    uart_config_t config = {};
+    config.baud_rate = INGEST_BAUD;
+    config.data_bits = UART_DATA_8_BITS;
+    config.parity = UART_PARITY_DISABLE;
+    config.stop_bits = UART_STOP_BITS_1;
+    config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+
+    // Драйвер сам складывает принятое в кольцевой буфер из прерывания
+    if (uart_driver_install(port, INGEST_RX_BUFFER, 0, 0, nullptr, 0) != ESP_OK) {
+        LOG(IngestDriverFailed, port);
+        return false;
+    }
+    uart_param_config(port, &config);
+    uart_set_pin(port, INGEST_TX_PIN, INGEST_RX_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    driverInstalled = true;
+    LOG(IngestListening, port, INGEST_BAUD);
+    if (!ingestTask.create(ingestBody, this)) {
+        LOG(IngestManual);
+    }
+    return true;
+}
+
+void FrameIngest::startTask() {
+    if (!begin()) {
+        return;
+    }
+    switch (ingestTask.getState()) {
+        case TaskState::Running:
+            return;
+        case TaskState::Paused:
+            resumeTask();
+            return;
+        case TaskState::Stopped:
+            break;
+    }
+    // Приветствие Adalight: контроллер шоу узнаёт по нему устройство
+    uart_write_bytes(port, "Ada\n", 4);
+    resetStats();
+    lastByteTime = lastFrameTime = millis();
+    ingestTask.request(TaskState::Running);
+}
+
+void FrameIngest::stopTask() {
+    if (ingestTask.getState() == TaskState::Stopped) {
+        return;
+    }
+    ingestTask.request(TaskState::Stopped);
+    ledMatrix.clear();
+    ledMatrix.update();
+}
+
+void FrameIngest::pauseTask() {
+    if (ingestTask.isRunning()) {
+        ingestTask.request(TaskState::Paused);
+    }
+}
+
+void FrameIngest::resumeTask() {
+    if (ingestTask.getState() != TaskState::Paused) {
+        return;
+    }
+    // Пауза не считается обрывом кадра и молчанием контроллера
+    lastByteTime = lastFrameTime = millis();
+    ingestTask.request(TaskState::Running);
+}
+
+// Ожидание данных ограничено INGEST_SERVICE_TIMEOUT, поэтому команда
+// забирается не позже чем через столько
+void FrameIngest::ingestBody(void* param) {
+    FrameIngest* ingest = static_cast<FrameIngest*>(param);
+    while (ingest->ingestTask.sleep(0)) {
+        ingest->service(INGEST_SERVICE_TIMEOUT);
+    }
+}
+
+void FrameIngest::service(uint32_t timeoutMs) {
+    if (!driverInstalled) {
+        return;
+    }
+    // Ждём первый байт, затем забираем всё, что уже лежит в кольце
+    size_t available = 0;
+    uart_get_buffered_data_len(port, &available);
+    size_t received = 0;
+    if (available == 0) {
+        int n = uart_read_bytes(port, chunk, 1, pdMS_TO_TICKS(timeoutMs));
+        if (n <= 0) {
+            checkTimeouts();
+            return;
+        }
+        received = 1;
+        uart_get_buffered_data_len(port, &available);
+    }
+    if (available > 0) {
+        int n = uart_read_bytes(port, chunk + received, std::min(available, sizeof(chunk) - received), 0);
+        received += n > 0 ? n : 0;
+    }
+
+    lastByteTime = millis();
+    bytes += received;
+    consume(chunk, received);
+    checkTimeouts();
+}
+
+void FrameIngest::consume(const uint8_t* data, size_t length) {
+    while (length > 0) {
+        FrameDecoder::Event event;
+        // Задний буфер меняется после каждого показанного кадра
+        size_t used = decoder.feed(data, length, ledMatrix.getLeds(), event);
+        data += used;
+        length -= used;
+
+        if (event == FrameDecoder::Event::Frame) {
+            ledMatrix.update();
+            frames++;
+            lastFrameTime = millis();
+            blanked = false;
+        } else if (event == FrameDecoder::Event::Dropped) {
+            dropped++;
+        }
+    }
+}
+
+void FrameIngest::checkTimeouts() {
+    unsigned long now = millis();
+    if (decoder.isInFrame() && now - lastByteTime > INGEST_FRAME_TIMEOUT && decoder.abort()) {
+        dropped++;
+    }
+    if (!blanked && now - lastFrameTime > INGEST_BLANK_TIMEOUT) {
+        LOG(IngestBlank);
+        ledMatrix.clear();
+        ledMatrix.update();
+        blanked = true;
+    }
+}
+
+IngestStats FrameIngest::getStats() const {
+    IngestStats stats;
+    stats.bytes = bytes;
+    stats.frames = frames;
+    stats.dropped = dropped;
+    stats.syncBytes = decoder.getSyncBytes() - syncBytesAtReset;
+    stats.elapsedMs = millis() - statsStart;
+    return stats;
+}
+
+void FrameIngest::resetStats() {
+    bytes = 0;
+    frames = 0;
+    dropped = 0;
+    syncBytesAtReset = decoder.getSyncBytes();
+    statsStart = millis();
+}
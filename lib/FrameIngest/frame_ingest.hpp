@@ -0,0 +1,67 @@
+#ifndef FRAME_INGEST_HPP
+#define FRAME_INGEST_HPP
+
+#include <Arduino.h>
+#include <driver/uart.h>
+#include "config.hpp"
+#include "led_matrix.hpp"
+#include "matrix_task.hpp"
+#include "frame_decoder.hpp"
+
+// Счётчики приёма с момента последнего сброса
+struct IngestStats {
+    uint32_t bytes;      // Принято байтов
+    uint32_t frames;     // Показано кадров
+    uint32_t dropped;    // Отброшено испорченных или оборванных кадров
+    uint32_t syncBytes;  // Пропущено байтов вне кадров
+    uint32_t elapsedMs;  // Длительность интервала
+};
+
+// Матрицей управляет внешний контроллер: кадры приходят по UART
+// (Adalight / TPM2, см. FrameDecoder). Данные из кольцевого буфера драйвера
+// UART разбираются прямо в задний буфер LedMatrix, готовый кадр сразу
+// показывается. Без кадров дольше INGEST_BLANK_TIMEOUT матрица гаснет.
+class FrameIngest : public MatrixTask {
+public:
+    explicit FrameIngest(LedMatrix& matrix, uart_port_t port = INGEST_UART_PORT);
+    ~FrameIngest();
+
+    bool begin(); // Установить драйвер UART и создать задачу приёма (в setup)
+    void startTask() override;
+    void stopTask() override;
+    void pauseTask() override;
+    void resumeTask() override;
+    TaskState getTaskState() const override { return ingestTask.getState(); }
+
+    // Один проход приёма: ждать данных не дольше timeoutMs, разобрать
+    // и показать готовые кадры. Задача крутит его в цикле, хост — сам.
+    void service(uint32_t timeoutMs);
+
+    IngestStats getStats() const;
+    void resetStats();
+    TaskHandle_t getTaskHandle() const { return ingestTask.getHandle(); }
+
+private:
+    LedMatrix& ledMatrix;
+    uart_port_t port;
+    bool driverInstalled = false;
+    FrameDecoder decoder;
+    uint8_t chunk[INGEST_CHUNK_SIZE]; // Окно чтения из кольца драйвера
+
+    ControlledTask ingestTask;
+    unsigned long lastByteTime = 0;
+    unsigned long lastFrameTime = 0;
+    bool blanked = true;
+
+    uint32_t bytes = 0;
+    uint32_t frames = 0;
+    uint32_t dropped = 0;
+    uint32_t syncBytesAtReset = 0;
+    unsigned long statsStart = 0;
+
+    static void ingestBody(void* param);
+    void consume(const uint8_t* data, size_t length);
+    void checkTimeouts();
+};
+
+#endif // FRAME_INGEST_HPP
@@ -0,0 +1,134 @@
+#include "latency_benchmark.hpp"
+#include <algorithm>
+
+static const AnimationType BENCHMARK_ANIMATIONS[] = {
+    AnimationType::ColorAmplitude,
+    AnimationType::PulsingRectangle,
+    AnimationType::StarrySky,
+    AnimationType::Wave,
+    AnimationType::Spectrogram
+};
+static const int BENCHMARK_ANIMATION_COUNT = sizeof(BENCHMARK_ANIMATIONS) / sizeof(BENCHMARK_ANIMATIONS[0]);
+
+static const char* const STAGE_NAMES[] = { "capture", "analysis", "render", "transmit" };
+
+LatencyBenchmark::LatencyBenchmark(SoundAnimator& animator)
+    : animator(animator) {
+}
+
+void LatencyBenchmark::begin() {
+    Serial.println("[Latency] Benchmark started");
+    animator.getAudioAnalyzer().setSampleReader(readSample, this);
+    startAnimation(0);
+}
+
+bool LatencyBenchmark::isDone() const {
+    return state == State::Done;
+}
+
+// Синтетический микрофон: тихий шум у середины шкалы и пачка меандра 1 кГц.
+// Источник в центре: оба канала слышат одно и то же в момент своего чтения
+uint16_t LatencyBenchmark::readSample(void* context, uint8_t channel) {
+    LatencyBenchmark* b = static_cast<LatencyBenchmark*>(context);
+
+    // Настоящее чтение АЦП сохраняет время выборки (на хосте двигает часы)
+    analogRead(channel ? MIC2_PIN : MIC_PIN);
+    uint32_t now = micros();
+
+    b->noiseState = b->noiseState * 1664525u + 1013904223u;
+    int value = 2048 + (int)(b->noiseState >> 28) - 8;
+
+    uint32_t t = b->impulseTime;
+    if (t && (int32_t)(now - t) >= 0 && now - t < IMPULSE_DURATION_US) {
+        // Засчитывается только первый отсчёт; задержка считается от начала импульса,
+        // даже если в этот момент задача ещё не читала микрофон
+        LatencyProbe::markAt(LatencyStage::Inject, t);
+        value += (((now - t) / 500) & 1) ? 1500 : -1500;
+    }
+    return (uint16_t)value;
+}
+
+void LatencyBenchmark::startAnimation(int index) {
+    animationIndex = index;
+    trialCount = 0;
+    missedCount = 0;
+    resultCount = 0;
+    animator.setAnimation(BENCHMARK_ANIMATIONS[index], CRGB::White);
+    state = State::Settle;
+    stateStartTime = micros();
+}
+
+void LatencyBenchmark::startTrial() {
+    LatencyProbe::arm();
+    // Случайная фаза импульса относительно кадра
+    uint32_t now = micros();
+    impulseTime = (now + random(1, IMPULSE_JITTER_US)) | 1;
+    state = State::Armed;
+    stateStartTime = now;
+}
+
+void LatencyBenchmark::finishTrial(bool completed) {
+    impulseTime = 0;
+    if (completed) {
+        for (int s = 0; s < MEASURED_STAGES; s++) {
+            results[s][resultCount] = LatencyProbe::elapsed((LatencyStage)(s + 1));
+        }
+        resultCount++;
+    } else {
+        missedCount++;
+    }
+
+    if (++trialCount < LATENCY_TRIALS) {
+        state = State::Settle;
+        stateStartTime = micros();
+        return;
+    }
+
+    report();
+    if (animationIndex + 1 < BENCHMARK_ANIMATION_COUNT) {
+        startAnimation(animationIndex + 1);
+    } else {
+        animator.getAudioAnalyzer().setSampleReader(nullptr);
+        state = State::Done;
+        Serial.println("[Latency] Benchmark finished");
+    }
+}
+
+void LatencyBenchmark::poll() {
+    uint32_t now = micros();
+    switch (state) {
+        case State::Settle:
+            if (now - stateStartTime >= SETTLE_TIME_US) {
+                startTrial();
+            }
+            break;
+        case State::Armed:
+            if (LatencyProbe::isComplete()) {
+                finishTrial(true);
+            } else if (now - stateStartTime >= TRIAL_TIMEOUT_US) {
+                finishTrial(false);
+            }
+            break;
+        case State::Done:
+            break;
+    }
+}
+
+void LatencyBenchmark::report() {
+    Serial.printf("[Latency] %s: %d trials, %d missed\n",
+                  SoundAnimator::getAnimationName(BENCHMARK_ANIMATIONS[animationIndex]),
+                  resultCount, missedCount);
+    if (resultCount == 0) {
+        return;
+    }
+
+    for (int s = 0; s < MEASURED_STAGES; s++) {
+        uint32_t* values = results[s];
+        std::sort(values, values + resultCount);
+        // Ранговые перцентили
+        uint32_t p50 = values[(resultCount - 1) * 50 / 100];
+        uint32_t p99 = values[(resultCount - 1) * 99 / 100];
+        Serial.printf("[Latency]   %-8s p50 %7.2f ms  p99 %7.2f ms\n",
+                      STAGE_NAMES[s], p50 / 1000.0f, p99 / 1000.0f);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef LATENCY_BENCHMARK_HPP
+#define LATENCY_BENCHMARK_HPP
+
+#include <Arduino.h>
+#include "config.hpp"
+#include "latency_probe.hpp"
+#include "sound_animator.hpp"
+
+// Бенчмарк задержки звук -> светодиоды.
+// Подменяет источник отсчётов анализатора синтетическим сигналом,
+// подаёт импульсы со случайным сдвигом относительно кадра и собирает
+// p50/p99 задержки каждого этапа для каждой анимации.
+// На устройстве poll() вызывается из loop(), на хосте — между кадрами
+// с симулированными часами.
+class LatencyBenchmark {
+public:
+    LatencyBenchmark(SoundAnimator& animator);
+
+    void begin();         // Подменить источник отсчётов и начать с первой анимации
+    void poll();          // Шаг автомата, вызывать не реже раза в кадр
+    bool isDone() const;
+
+private:
+    enum class State { Settle, Armed, Done };
+
+    static constexpr uint32_t SETTLE_TIME_US = 500000;     // Пауза между импульсами
+    static constexpr uint32_t TRIAL_TIMEOUT_US = 1000000;  // Импульс потерян
+    static constexpr uint32_t IMPULSE_DURATION_US = 40000; // Длина пачки меандра
+    static constexpr uint32_t IMPULSE_JITTER_US = 100000;  // Разброс момента импульса (больше периода кадра)
+    static constexpr int MEASURED_STAGES = (int)LatencyStage::Count - 1;
+
+    static uint16_t readSample(void* context, uint8_t channel);
+
+    void startTrial();
+    void finishTrial(bool completed);
+    void startAnimation(int index);
+    void report();
+
+    SoundAnimator& animator;
+    State state = State::Done;
+    int animationIndex = 0;
+    int trialCount = 0;
+    int missedCount = 0;
+    uint32_t stateStartTime = 0;
+    volatile uint32_t impulseTime = 0; // 0 — импульс не запланирован
+    uint32_t noiseState = 1;
+
+    // Задержки от Inject до каждого следующего этапа, мкс
+    uint32_t results[MEASURED_STAGES][LATENCY_TRIALS];
+    int resultCount = 0;
+};
+
+#endif // LATENCY_BENCHMARK_HPP
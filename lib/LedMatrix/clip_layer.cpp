@@ -0,0 +1,107 @@
+#include "clip_layer.hpp"
+#include "deferred_log.hpp"
+#include "render_math.hpp"
+
+bool ClipLayer::play(const ClipReader& clip, ClipBlend mode, bool repeat) {
+    if (!clip.isOpen()) {
+        return false;
+    }
+    // Пока отрисовка не забрала прошлый запуск, его поля читаются
+    if (playPending) {
+        LOG(ClipPending);
+        return false;
+    }
+    pendingReader = clip;
+    pendingBlend = mode;
+    pendingLoop = repeat;
+    stopPending = false; // Новый запуск отменяет остановку, которую ещё не забрали
+    playPending = true;
+    return true;
+}
+
+void ClipLayer::stop() {
+    stopPending = true;
+}
+
+// Запуск забирается раньше остановки: stop() после play() гасит новый клип
+void ClipLayer::takeRequests(unsigned long now) {
+    if (playPending) {
+        reader = pendingReader;
+        blend = pendingBlend;
+        loop = pendingLoop;
+        reader.seek(0, canvas);
+        startTime = now;
+        active = true;
+        playPending = false;
+    }
+    if (stopPending) {
+        active = false;
+        stopPending = false;
+    }
+}
+
+// Догнать кадр frame: подряд идущие дельты дешевле, дальний прыжок или
+// возврат — через ключевой кадр
+bool ClipLayer::advanceTo(uint32_t frame) {
+    uint32_t next = reader.getNextFrame();
+    if (frame + 1 == next) {
+        return true;
+    }
+    if (frame >= next && frame - next < reader.getKeyframeInterval()) {
+        while (reader.getNextFrame() <= frame) {
+            if (!reader.decodeNext(canvas)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return reader.seek(frame, canvas);
+}
+
+void ClipLayer::draw(CRGB* target, unsigned long now) {
+    takeRequests(now);
+    if (!active) {
+        return;
+    }
+
+    uint32_t frame = (now - startTime) / reader.getFrameIntervalMs();
+    if (frame >= reader.getFrameCount()) {
+        if (!loop) {
+            active = false;
+            return;
+        }
+        frame %= reader.getFrameCount();
+    }
+    if (!advanceTo(frame)) {
+        active = false;
+        return;
+    }
+
+    switch (blend) {
+        case ClipBlend::Replace:
+            for (int i = 0; i < NUM_LEDS; i++) {
+                for (int c = 0; c < 3; c++) {
+                    target[i][c] = lerpQ8(target[i][c], canvas[i][c], opacity);
+                }
+            }
+            break;
+        case ClipBlend::Over:
+            for (int i = 0; i < NUM_LEDS; i++) {
+                if (canvas[i] == CRGB(CRGB::Black)) {
+                    continue;
+                }
+                for (int c = 0; c < 3; c++) {
+                    target[i][c] = lerpQ8(target[i][c], canvas[i][c], opacity);
+                }
+            }
+            break;
+        case ClipBlend::Add:
+            for (int i = 0; i < NUM_LEDS; i++) {
+                for (int c = 0; c < 3; c++) {
+                    uint16_t sum = target[i][c] + scale8(canvas[i][c], opacity);
+                    target[i][c] = sum > 255 ? 255 : sum;
+                }
+            }
+            break;
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef CLIP_LAYER_HPP
+#define CLIP_LAYER_HPP
+
+#include <FastLED.h>
+#include "config.hpp"
+#include "clip_reader.hpp"
+
+// Способ наложения клипа на кадр анимации
+enum class ClipBlend : uint8_t {
+    Replace, // Клип целиком вместо кадра
+    Over,    // Чёрные пиксели клипа прозрачны
+    Add      // Сложение с насыщением
+};
+
+// Заранее отрисованный клип поверх живой анимации.
+// Кадр клипа выбирается по времени от старта, так что темп не зависит от
+// частоты кадров. Дельты применяются к собственному холсту слоя: задний
+// буфер матрицы после выходного каскада и обмена кадрами для них не годится.
+//
+// play() и stop() вызываются из других задач и только оставляют запрос;
+// читатель и холст трогает один draw() в задаче отрисовки, забирая запрос
+// в начале кадра.
+class ClipLayer {
+public:
+    // Читатель копируется; данные клипа должны оставаться отображёнными.
+    // false — клип не открыт или прошлый запуск ещё не забран отрисовкой
+    bool play(const ClipReader& clip, ClipBlend mode = ClipBlend::Over, bool repeat = false);
+    void stop();
+    void setOpacity(uint8_t value) { opacity = value; }
+
+    // Запущенный, но ещё не забранный клип тоже активен: отрисовка не должна
+    // уйти в простой, не начав его
+    bool isActive() const { return active || playPending; }
+
+    // Наложить текущий кадр клипа на target (до выходного каскада)
+    void draw(CRGB* target, unsigned long now);
+
+private:
+    ClipReader reader;
+    CRGB canvas[NUM_LEDS];
+    ClipBlend blend = ClipBlend::Over;
+    uint8_t opacity = 255;
+    bool loop = false;
+    bool active = false;
+    unsigned long startTime = 0;
+
+    // Запрос от другой задачи. Поля запуска пишутся, только пока
+    // playPending сброшен, и читаются, только пока он поднят
+    ClipReader pendingReader;
+    ClipBlend pendingBlend = ClipBlend::Over;
+    bool pendingLoop = false;
+    volatile bool playPending = false;
+    volatile bool stopPending = false;
+    void takeRequests(unsigned long now);
+
+    bool advanceTo(uint32_t frame);
+};
+
+#endif // CLIP_LAYER_HPP
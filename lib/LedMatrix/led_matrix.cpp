@@ -1,13 +1,33 @@
 #include "led_matrix.hpp"
+#include "deferred_log.hpp"
+#include "latency_probe.hpp"
+#include "trace_recorder.hpp"
+#include <cmath>
+#include <utility>
 
-// Конструктор — только сохраняем ссылки
-LedMatrix::LedMatrix() {}
+// Конструктор — строим таблицу выходного каскада (без инициализации FastLED)
+LedMatrix::LedMatrix() {
+    rebuildOutputLut();
+}
 
 // Инициализация FastLED — вызывать в setup()
 void LedMatrix::begin() {
-    FastLED.addLeds<WS2812B, LED_PIN, GRB>(leds, NUM_LEDS);
-    FastLED.setBrightness(BRIGHTNESS);
-    clear(); // Очистка и show
+    controller = &FastLED.addLeds<WS2812B, LED_PIN, GRB>(front, NUM_LEDS);
+    // Яркость, коррекция и дизеринг применяются в собственном выходном каскаде
+    FastLED.setBrightness(255);
+    FastLED.setCorrection(UncorrectedColor);
+    FastLED.setDither(DISABLE_DITHER);
+
+    frontReleased = xSemaphoreCreateBinary();
+    xSemaphoreGive(frontReleased);
+    if (xTaskCreatePinnedToCore(showTask, "ShowTask", SHOW_TASK_STACK_SIZE, this, SHOW_TASK_PRIORITY,
+                                &showTaskHandle, SHOW_TASK_CORE) != pdPASS) {
+        LOG(MatrixSyncShow);
+        showTaskHandle = nullptr;
+    }
+
+    clear();
+    update();
 }
 
 // Преобразование координат (сверху вниз, слева направо)
@@ -17,7 +37,7 @@ int LedMatrix::XY(int x, int y) {
 
 // Очистка матрицы (fill_solid)
 void LedMatrix::clear() {
-    fill_solid(leds, width * height, CRGB::Black);
+    fill_solid(back, width * height, CRGB::Black);
 }
 
 // Установка цвета
@@ -25,26 +45,133 @@ void LedMatrix::setPixel(int x, int y, const CRGB& color) {
     if (x < 0 || x >= width || y < 0 || y >= height) {
         return;
     }
-    leds[XY(x, y)] = color;
+    back[XY(x, y)] = color;
+}
+
+// Установка яркости (таблица пересчитывается только при изменении)
+void LedMatrix::setBrightness(uint8_t value) {
+    if (value == brightness) {
+        return;
+    }
+    brightness = value;
+    rebuildOutputLut();
+}
+
+void LedMatrix::setGamma(float value) {
+    if (value >= 1.0f && value <= 3.0f && value != gamma) {
+        gamma = value;
+        rebuildOutputLut();
+    }
+}
+
+void LedMatrix::setColorCorrection(const CRGB& correction) {
+    if (correction != colorCorrection) {
+        colorCorrection = correction;
+        rebuildOutputLut();
+    }
 }
 
-// Установка яркости
-void LedMatrix::setBrightness(uint8_t brightness) {
-    FastLED.setBrightness(brightness);
+void LedMatrix::setDithering(bool enabled) {
+    ditherEnabled = enabled;
+}
+
+void LedMatrix::suppressDithering(bool suppressed) {
+    ditherSuppressed = suppressed;
+}
+
+// Пересчёт таблицы: вся работа с float выполняется здесь, а не на каждый пиксель
+void LedMatrix::rebuildOutputLut() {
+    for (int c = 0; c < 3; c++) {
+        // Максимум 255.0 * 256 = 0xFF00, поэтому старший байт не переполняется
+        float scale = 255.0f * 256.0f * (brightness / 255.0f) * (colorCorrection[c] / 255.0f);
+        for (int i = 0; i < 256; i++) {
+            float level = powf(i / 255.0f, gamma);
+            outputLut[c][i] = (uint16_t)(level * scale + 0.5f);
+        }
+    }
+}
+
+// Выходной каскад: таблица + временной дизеринг за один проход на месте
+void LedMatrix::applyOutputStage() {
+    // Порог дробной части меняется от кадра к кадру по бит-реверсному счётчику,
+    // так что за 8 кадров пиксель в среднем получает свой дробный уровень.
+    // Без дизеринга порог 0x7F даёт обычное округление.
+    uint8_t threshold = 0x7F;
+    if (ditherEnabled && !ditherSuppressed) {
+        uint8_t f = ditherFrame++ & 0x07;
+        uint8_t reversed = ((f & 1) << 2) | (f & 2) | ((f & 4) >> 2);
+        threshold = (reversed << 5) | 0x10;
+    }
+
+    for (int i = 0; i < NUM_LEDS; i++) {
+        for (int c = 0; c < 3; c++) {
+            uint16_t v = outputLut[c][back[i][c]];
+            back[i][c] = (v >> 8) + ((v & 0xFF) > threshold);
+        }
+    }
+}
+
+CRGB LedMatrix::correctColor(const CRGB& color) const {
+    CRGB result;
+    for (int c = 0; c < 3; c++) {
+        result[c] = (outputLut[c][color[c]] + 0x80) >> 8;
+    }
+    return result;
 }
 
 // Обновление матрицы (показать)
 void LedMatrix::update() {
+    LATENCY_MARK(LatencyStage::Render);
+    // Клип смешивается с кадром до выходного каскада, как обычная отрисовка
+    clipLayer.draw(back, millis());
+    applyOutputStage();
+    // Текст накладывается после выходного каскада, цвет корректируется отдельно
+    textLayer.draw(*this, back, correctColor(textLayer.getColor()), millis());
+
+    if (!showTaskHandle) {
+        std::swap(front, back);
+        transmit();
+        return;
+    }
+
+    // После обмена передний буфер станет задним, поэтому ждём, пока лента
+    // его дочитает. Обычно передача уже закончилась за время отрисовки.
+    TRACE_BEGIN(Wait);
+    xSemaphoreTake(frontReleased, portMAX_DELAY);
+    TRACE_END(Wait);
+    std::swap(front, back);
+    xTaskNotifyGive(showTaskHandle);
+}
+
+void LedMatrix::transmit() {
+    TRACE_SCOPE(Show);
+    controller->setLeds(front, NUM_LEDS);
     FastLED.show();
+    LATENCY_MARK(LatencyStage::Transmit);
+}
+
+// Задача передачи: отправляет передний буфер по сигналу update()
+void LedMatrix::showTask(void* param) {
+    LedMatrix* matrix = static_cast<LedMatrix*>(param);
+    for (;;) {
+        TRACE_BEGIN(Wait);
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        TRACE_END(Wait);
+        matrix->transmit();
+        xSemaphoreGive(matrix->frontReleased);
+    }
 }
 
 // Полное выключение (очистить + показать)
 void LedMatrix::off() {
     clear();
-    FastLED.show();
+    update();
 }
 
 // Получить массив пикселей
 CRGB* LedMatrix::getLeds() {
-    return leds;
+    return back;
 }
+
+static_assert(sizeof(LedMatrix) <= LED_MATRIX_RAM_BUDGET,
+              "LedMatrix exceeds LED_MATRIX_RAM_BUDGET");
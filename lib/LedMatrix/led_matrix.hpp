@@ -3,14 +3,52 @@
 
 
 #include <FastLED.h>
+#include <freertos/semphr.h>
 #include "config.hpp"
+#include "text_layer.hpp"
+#include "clip_layer.hpp"
+
+// --- Дефолтные значения выходного каскада ---
+constexpr float DEFAULT_GAMMA = 2.2f;
+constexpr uint32_t DEFAULT_COLOR_CORRECTION = 0xFFB0F0; // TypicalLEDStrip
 
 class LedMatrix {
 private:
-    CRGB leds[NUM_LEDS];
+    // Два кадра: анимации рисуют в задний, передний передаётся в ленту.
+    // update() прогоняет задний через выходной каскад на месте и меняет
+    // указатели местами, поэтому передача кадра N идёт параллельно с
+    // отрисовкой кадра N+1.
+    CRGB buffers[2][NUM_LEDS];
+    CRGB* back = buffers[0];
+    CRGB* front = buffers[1];
+    CLEDController* controller = nullptr;
     int width = MATRIX_WIDTH;
     int height = MATRIX_HEIGHT;
 
+    // Таблица выходного каскада: гамма * яркость * цветокоррекция,
+    // значения в формате 8.8 (старший байт — уровень, младший — дробь для дизеринга)
+    uint16_t outputLut[3][256];
+    uint8_t brightness = BRIGHTNESS;
+    float gamma = DEFAULT_GAMMA;
+    CRGB colorCorrection = CRGB(DEFAULT_COLOR_CORRECTION);
+    bool ditherEnabled = true;
+    bool ditherSuppressed = false; // Временно выключен регулятором качества
+    uint8_t ditherFrame = 0;
+
+    TextLayer textLayer; // Бегущая строка поверх кадра
+    ClipLayer clipLayer; // Заранее отрисованный клип поверх анимации
+
+    // Передача кадра в отдельной задаче на другом ядре.
+    // Без задачи (хост) кадр передаётся синхронно внутри update().
+    TaskHandle_t showTaskHandle = nullptr;
+    SemaphoreHandle_t frontReleased = nullptr; // Лента закончила передний кадр
+    static void showTask(void* param);
+    void transmit();
+
+    void rebuildOutputLut();
+    void applyOutputStage();
+    CRGB correctColor(const CRGB& color) const; // Цвет через таблицу, без дизеринга
+
 public:
     LedMatrix(); // Конструктор (без инициализации FastLED)
     
@@ -18,9 +56,16 @@ public:
     void clear();                        // Очистка матрицы и show()
     void setPixel(int x, int y, const CRGB& color); // Установка цвета
     void setBrightness(uint8_t brightness);         // Установка яркости
-    void update();                       // Применить изменения
+    void setGamma(float value);                     // Гамма выходного каскада
+    void setColorCorrection(const CRGB& correction); // Поканальная цветокоррекция
+    void setDithering(bool enabled);                // Временной дизеринг
+    void suppressDithering(bool suppressed);        // Выключить дизеринг, не трогая настройку
+    void update();                       // Применить изменения и отдать кадр в ленту
     void off();                          // Очистить и выключить
-    CRGB* getLeds();                     // Доступ к массиву
+    CRGB* getLeds();                     // Задний буфер, безопасный для отрисовки
+    TaskHandle_t getShowTaskHandle() const { return showTaskHandle; }
+    TextLayer& getTextLayer() { return textLayer; } // Бегущая строка
+    ClipLayer& getClipLayer() { return clipLayer; } // Слой клипов
     int XY(int x, int y);                // Преобразование координат
 };
 
@@ -0,0 +1,82 @@
+#include "text_layer.hpp"
+#include "led_matrix.hpp"
+#include "font5x7.hpp"
+
+constexpr uint8_t SPACE_WIDTH = 3;   // Ширина пробела, столбцов
+constexpr uint8_t GLYPH_SPACING = 1; // Пустой столбец между символами
+
+void TextLayer::setText(const char* text) {
+    // Пока лента перестраивается, слой не рисуется
+    active = false;
+    stripLength = 0;
+
+    for (const char* p = text; *p && stripLength < TEXT_MAX_COLUMNS; p++) {
+        uint8_t c = (uint8_t)*p;
+        if (c < FONT5X7_FIRST_CHAR || c > FONT5X7_LAST_CHAR) {
+            c = '?';
+        }
+
+        const uint8_t* glyph = FONT5X7 + (c - FONT5X7_FIRST_CHAR) * FONT5X7_WIDTH;
+
+        // Пропорциональная ширина: отбрасываем пустые столбцы по краям глифа
+        int first = 0;
+        int last = FONT5X7_WIDTH - 1;
+        while (first <= last && pgm_read_byte(glyph + first) == 0) first++;
+        while (last >= first && pgm_read_byte(glyph + last) == 0) last--;
+
+        if (first > last) {
+            for (int i = 0; i < SPACE_WIDTH && stripLength < TEXT_MAX_COLUMNS; i++) {
+                strip[stripLength++] = 0;
+            }
+            continue;
+        }
+
+        for (int i = first; i <= last && stripLength < TEXT_MAX_COLUMNS; i++) {
+            strip[stripLength++] = pgm_read_byte(glyph + i);
+        }
+        for (int i = 0; i < GLYPH_SPACING && stripLength < TEXT_MAX_COLUMNS; i++) {
+            strip[stripLength++] = 0;
+        }
+    }
+
+    startTime = millis();
+    active = stripLength > 0;
+}
+
+void TextLayer::clear() {
+    active = false;
+    stripLength = 0;
+}
+
+void TextLayer::setSpeed(uint8_t columnsPerSecond) {
+    if (columnsPerSecond > 0) {
+        speed = columnsPerSecond;
+    }
+}
+
+void TextLayer::draw(LedMatrix& matrix, CRGB* target, const CRGB& drawColor, unsigned long now) const {
+    if (!active) {
+        return;
+    }
+
+    // Виртуальная лента: MATRIX_WIDTH пустых столбцов, затем сообщение,
+    // так что текст въезжает справа и целиком уходит влево
+    const uint32_t total = stripLength + MATRIX_WIDTH;
+    // Произведение в 64 битах: в 32 при 255 столбцах/с переполнилось бы через ~4.7 ч
+    const uint32_t offset = (uint32_t)((uint64_t)(uint32_t)(now - startTime) * speed / 1000 % total);
+    const int top = (MATRIX_HEIGHT - FONT5X7_HEIGHT) / 2;
+
+    for (int x = 0; x < MATRIX_WIDTH; x++) {
+        uint32_t v = (offset + x) % total;
+        if (v < MATRIX_WIDTH) {
+            continue;
+        }
+        uint8_t column = strip[v - MATRIX_WIDTH];
+        for (int row = 0; column; row++, column >>= 1) {
+            int y = top + row;
+            if ((column & 1) && y >= 0 && y < MATRIX_HEIGHT) {
+                target[matrix.XY(x, y)] = drawColor;
+            }
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef TEXT_LAYER_HPP
+#define TEXT_LAYER_HPP
+
+#include <FastLED.h>
+#include "config.hpp"
+
+class LedMatrix;
+
+constexpr uint8_t DEFAULT_TEXT_SPEED = 8; // Столбцов в секунду
+
+// Бегущая строка поверх кадра.
+// Сообщение один раз растрируется в ленту столбцов (бит 0 — верхняя строка
+// глифа), а прокрутка лишь сдвигает окно просмотра по этой ленте.
+class TextLayer {
+public:
+    void setText(const char* text);       // Растрировать и начать прокрутку
+    void clear();                         // Убрать строку
+    void setColor(const CRGB& value) { color = value; }
+    void setSpeed(uint8_t columnsPerSecond);
+
+    bool isActive() const { return active; }
+    const CRGB& getColor() const { return color; }
+
+    // Нарисовать видимую часть ленты в буфер target с раскладкой matrix.XY()
+    void draw(LedMatrix& matrix, CRGB* target, const CRGB& drawColor, unsigned long now) const;
+
+private:
+    uint8_t strip[TEXT_MAX_COLUMNS];
+    uint16_t stripLength = 0;
+    volatile bool active = false;
+    CRGB color = CRGB::White;
+    uint8_t speed = DEFAULT_TEXT_SPEED;
+    unsigned long startTime = 0;
+};
+
+#endif // TEXT_LAYER_HPP
@@ -0,0 +1,60 @@
+#include "palette.hpp"
+#include <string.h>
+
+CRGB Palette::colorAt(uint8_t index) const {
+    if (index <= stops[0].position) {
+        return CRGB(stops[0].r, stops[0].g, stops[0].b);
+    }
+    for (uint8_t i = 1; i < count; i++) {
+        const GradientStop& a = stops[i - 1];
+        const GradientStop& b = stops[i];
+        if (index <= b.position) {
+            int32_t span = b.position - a.position;
+            int32_t t = index - a.position;
+            return CRGB(a.r + (b.r - a.r) * t / span,
+                        a.g + (b.g - a.g) * t / span,
+                        a.b + (b.b - a.b) * t / span);
+        }
+    }
+    const GradientStop& last = stops[count - 1];
+    return CRGB(last.r, last.g, last.b);
+}
+
+namespace palettes {
+
+const Palette* find(const char* name) {
+    struct Named {
+        const char* name;
+        const Palette* palette;
+    };
+    static const Named NAMED[] = {
+        {"rainbow", &RAINBOW}, {"fire", &FIRE}, {"ocean", &OCEAN}, {"forest", &FOREST}, {"heat", &HEAT},
+    };
+    for (const Named& entry : NAMED) {
+        if (strcmp(entry.name, name) == 0) {
+            return entry.palette;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace palettes
+
+void ColorTable::bake(const Palette& source, uint8_t level) {
+    palette = source;
+    brightness = level;
+    for (int i = 0; i < 256; i++) {
+        CRGB color = palette.colorAt(i);
+        // (level + 1) / 256: полная яркость оставляет цвет без изменений
+        color.r = color.r * (level + 1) >> 8;
+        color.g = color.g * (level + 1) >> 8;
+        color.b = color.b * (level + 1) >> 8;
+        colors[i] = color;
+    }
+}
+
+void ColorTable::setBrightness(uint8_t level) {
+    if (level != brightness) {
+        bake(palette, level);
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef PALETTE_HPP
+#define PALETTE_HPP
+
+#include <FastLED.h>
+#include "render_math.hpp"
+
+// Опорная точка градиента: позиция 0..255 и цвет в ней
+struct GradientStop {
+    uint8_t position;
+    uint8_t r, g, b;
+};
+
+// Градиентная палитра: до MAX_STOPS опорных точек по возрастанию позиции,
+// между ними цвет интерполируется линейно. Одна точка — сплошной цвет.
+// Палитра — значение небольшого размера, её можно копировать и хранить в плейлисте.
+class Palette {
+public:
+    static constexpr uint8_t MAX_STOPS = 12;
+
+    constexpr Palette() : stops{{0, 0, 0, 0}}, count(1) {}
+    template <size_t N>
+    constexpr Palette(const GradientStop (&points)[N]) : stops{}, count(N) {
+        static_assert(N >= 1 && N <= MAX_STOPS, "Palette: 1..MAX_STOPS stops");
+        for (size_t i = 0; i < N; i++) {
+            stops[i] = points[i];
+        }
+    }
+
+    static constexpr Palette solid(const CRGB& color) {
+        return Palette({GradientStop{0, color.r, color.g, color.b}});
+    }
+
+    CRGB colorAt(uint8_t index) const; // Медленно: для запекания таблицы
+    bool isSolid() const { return count == 1; }
+
+private:
+    GradientStop stops[MAX_STOPS];
+    uint8_t count;
+};
+
+// Встроенные палитры
+namespace palettes {
+
+// Ключевые цвета радуги CHSV из FastLED: RAINBOW.colorAt(h) совпадает с CHSV(h, 255, 255)
+// с точностью до округления
+constexpr GradientStop RAINBOW_STOPS[] = {
+    {0, 0xFF, 0x00, 0x00},   {32, 0xAB, 0x55, 0x00},  {64, 0xAB, 0xAB, 0x00},
+    {96, 0x00, 0xFF, 0x00},  {128, 0x00, 0xAB, 0x55}, {160, 0x00, 0x00, 0xFF},
+    {192, 0x55, 0x00, 0xAB}, {224, 0xAB, 0x00, 0x55}, {255, 0xFF, 0x00, 0x00},
+};
+constexpr GradientStop FIRE_STOPS[] = {
+    {0, 0x20, 0x00, 0x00}, {96, 0xC0, 0x10, 0x00}, {176, 0xFF, 0x80, 0x00}, {255, 0xFF, 0xFF, 0x80},
+};
+constexpr GradientStop OCEAN_STOPS[] = {
+    {0, 0x00, 0x00, 0x40}, {96, 0x00, 0x30, 0xC0}, {192, 0x00, 0xC0, 0xC0}, {255, 0xC0, 0xFF, 0xFF},
+};
+constexpr GradientStop FOREST_STOPS[] = {
+    {0, 0x00, 0x30, 0x00}, {128, 0x20, 0xA0, 0x10}, {255, 0xC0, 0xFF, 0x20},
+};
+constexpr GradientStop HEAT_STOPS[] = {
+    {0, 0x00, 0x00, 0xFF}, {96, 0x00, 0xFF, 0x00}, {176, 0xFF, 0xFF, 0x00}, {255, 0xFF, 0x00, 0x00},
+};
+
+inline constexpr Palette RAINBOW(RAINBOW_STOPS);
+inline constexpr Palette FIRE(FIRE_STOPS);
+inline constexpr Palette OCEAN(OCEAN_STOPS);
+inline constexpr Palette FOREST(FOREST_STOPS);
+inline constexpr Palette HEAT(HEAT_STOPS); // Синий → зелёный → жёлтый → красный, как у индикатора уровня
+
+// Палитра по имени ("rainbow", "fire", ...); nullptr, если такой нет
+const Palette* find(const char* name);
+
+} // namespace palettes
+
+// Таблица цветов анимации: палитра, запечённая в 256 цветов вместе с яркостью.
+// Отрисовка только выбирает цвет по индексу (высота, громкость, яркость частицы),
+// без HSV и интерполяции в кадре. Перезапекается при смене палитры или яркости.
+class ColorTable {
+public:
+    void bake(const Palette& palette, uint8_t brightness);
+    void setBrightness(uint8_t brightness); // Перезапечь, если яркость изменилась
+
+    const CRGB& operator[](q8_t index) const { return colors[index]; }
+    uint8_t getBrightness() const { return brightness; }
+
+private:
+    Palette palette;
+    uint8_t brightness = 255;
+    CRGB colors[256];
+};
+
+#endif // PALETTE_HPP
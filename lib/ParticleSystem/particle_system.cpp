@@ -0,0 +1,89 @@
+#include "particle_system.hpp"
+#include "led_matrix.hpp"
+#include "palette.hpp"
+#include <algorithm>
+
+ParticleSystem::ParticleSystem() {
+    limit = CAPACITY;
+    reset();
+}
+
+void ParticleSystem::reset() {
+    for (uint16_t i = 0; i < CAPACITY; i++) {
+        nextFree[i] = (i + 1 < CAPACITY) ? i + 1 : NONE;
+    }
+    freeHead = 0;
+    activeCount = 0;
+}
+
+void ParticleSystem::setLimit(uint16_t value) {
+    limit = constrain(value, 1, CAPACITY);
+}
+
+bool ParticleSystem::spawn(int16_t x, int16_t y, int8_t vx, int8_t vy, uint8_t peakBrightness, uint8_t lifetime) {
+    if (activeCount >= limit || freeHead == NONE) {
+        return false;
+    }
+
+    uint16_t slot = freeHead;
+    freeHead = nextFree[slot];
+
+    posX[slot] = x;
+    posY[slot] = y;
+    velX[slot] = vx;
+    velY[slot] = vy;
+    peak[slot] = peakBrightness;
+    brightness[slot] = 0;
+    age[slot] = 0;
+    life[slot] = lifetime ? lifetime : 1;
+
+    activeList[activeCount++] = slot;
+    return true;
+}
+
+// Удаление из плотного списка перестановкой последнего элемента на место удалённого
+void ParticleSystem::release(uint16_t listIndex) {
+    uint16_t slot = activeList[listIndex];
+    activeList[listIndex] = activeList[--activeCount];
+    nextFree[slot] = freeHead;
+    freeHead = slot;
+}
+
+void ParticleSystem::update(uint8_t decay) {
+    const int16_t maxX = MATRIX_WIDTH << 8;
+    const int16_t maxY = MATRIX_HEIGHT << 8;
+
+    uint16_t i = 0;
+    while (i < activeCount) {
+        uint16_t p = activeList[i];
+
+        posX[p] += velX[p];
+        posY[p] += velY[p];
+
+        uint8_t a = ++age[p];
+        if (a <= RISE_FRAMES) {
+            brightness[p] = (uint16_t)peak[p] * a / RISE_FRAMES;
+        } else {
+            brightness[p] = ((uint16_t)brightness[p] * decay) >> 8;
+        }
+
+        bool outside = posX[p] < 0 || posX[p] >= maxX || posY[p] < 0 || posY[p] >= maxY;
+        if (a >= life[p] || outside || (a > RISE_FRAMES && brightness[p] == 0)) {
+            release(i); // На место i встал последний — индекс не двигаем
+            continue;
+        }
+        i++;
+    }
+}
+
+void ParticleSystem::draw(LedMatrix& matrix, CRGB* leds, const ColorTable& colors) const {
+    for (uint16_t i = 0; i < activeCount; i++) {
+        uint16_t p = activeList[i];
+        CRGB& pixel = leds[matrix.XY(posX[p] >> 8, posY[p] >> 8)];
+        CRGB c = colors[brightness[p]];
+        c.nscale8(brightness[p]);
+        pixel.r = std::max(pixel.r, c.r);
+        pixel.g = std::max(pixel.g, c.g);
+        pixel.b = std::max(pixel.b, c.b);
+    }
+}
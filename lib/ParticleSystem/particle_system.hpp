@@ -0,0 +1,63 @@
+#ifndef PARTICLE_SYSTEM_HPP
+#define PARTICLE_SYSTEM_HPP
+
+#include <FastLED.h>
+#include "config.hpp"
+
+class LedMatrix;
+class ColorTable;
+
+// Пул частиц фиксированной ёмкости без кучи.
+// Данные хранятся структурой массивов, живые частицы перечислены в плотном
+// списке (для пакетных проходов update/draw), свободные слоты — в free-list.
+// Координаты и скорости в фиксированной точке 8.8 (пиксель = 256).
+// Координата 8.8 в int16_t вмещает до 127 пикселей: (127 << 8) + 255 и шаг
+// скорости (до 127) ещё меньше 32768. Для матриц шире или выше 127 пикселей
+// позиции и границы нужно перевести в int32_t (пул частиц вырастет вдвое по позициям).
+static_assert(MATRIX_WIDTH < 128 && MATRIX_HEIGHT < 128,
+              "ParticleSystem 8.8 int16_t positions hold at most 127 pixels per axis");
+
+class ParticleSystem {
+public:
+    static constexpr uint16_t CAPACITY = PARTICLE_POOL_SIZE;
+    static constexpr uint16_t NONE = 0xFFFF;
+    static constexpr uint8_t RISE_FRAMES = 3; // Кадров разгорания до пиковой яркости
+
+    ParticleSystem();
+
+    void reset();
+    void setLimit(uint16_t limit);   // Сколько частиц может жить одновременно (<= CAPACITY)
+    uint16_t getLimit() const { return limit; }
+    uint16_t getActiveCount() const { return activeCount; }
+
+    // Создать частицу; false, если достигнут лимит
+    bool spawn(int16_t x, int16_t y, int8_t vx, int8_t vy, uint8_t peak, uint8_t life);
+
+    // Пакетный шаг: движение, разгорание, затухание (яркость *= decay / 256), смерть
+    void update(uint8_t decay);
+
+    // Пакетная отрисовка: цвет из таблицы по яркости частицы и с этой яркостью,
+    // перекрытия — по максимуму
+    void draw(LedMatrix& matrix, CRGB* leds, const ColorTable& colors) const;
+
+private:
+    void release(uint16_t listIndex);
+
+    // Состояние частиц (SoA)
+    int16_t posX[CAPACITY];
+    int16_t posY[CAPACITY];
+    int8_t velX[CAPACITY];
+    int8_t velY[CAPACITY];
+    uint8_t peak[CAPACITY];
+    uint8_t brightness[CAPACITY];
+    uint8_t age[CAPACITY];
+    uint8_t life[CAPACITY];
+
+    uint16_t nextFree[CAPACITY];   // Односвязный список свободных слотов
+    uint16_t freeHead;
+    uint16_t activeList[CAPACITY]; // Плотный список живых слотов
+    uint16_t activeCount;
+    uint16_t limit;
+};
+
+#endif // PARTICLE_SYSTEM_HPP
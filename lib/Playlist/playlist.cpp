@@ -0,0 +1,88 @@
+#include "playlist.hpp"
+#include "deferred_log.hpp"
+
+Playlist::Playlist(SoundAnimator& animator)
+    : animator(animator) {
+}
+
+Playlist::~Playlist() {
+    stop();
+    if (timer) {
+        xTimerDelete(timer, portMAX_DELAY);
+    }
+}
+
+void Playlist::setEntries(const PlaylistEntry* list, size_t count) {
+    entries = list;
+    entryCount = count;
+}
+
+void Playlist::start() {
+    if (!entries || entryCount == 0) {
+        LOG(PlaylistEmpty);
+        return;
+    }
+    if (!timer) {
+        timer = xTimerCreate("Playlist", pdMS_TO_TICKS(PREPARE_DELAY), pdFALSE, this, timerCallback);
+        if (!timer) {
+            LOG(PlaylistTimerFailed);
+            return;
+        }
+    }
+
+    // Первый элемент включается сразу, следующий готовится по таймеру
+    currentIndex = 0;
+    nextIndex = entryCount > 1 ? 1 : 0;
+    if (prepareEntry(currentIndex)) {
+        animator.commitAnimation();
+    }
+    switchTime = xTaskGetTickCount();
+    phase = Phase::Prepare;
+    xTimerChangePeriod(timer, pdMS_TO_TICKS(PREPARE_DELAY), portMAX_DELAY);
+}
+
+void Playlist::stop() {
+    if (timer) {
+        xTimerStop(timer, portMAX_DELAY);
+    }
+}
+
+bool Playlist::prepareEntry(size_t index) {
+    const PlaylistEntry& entry = entries[index];
+    if (entry.palette) {
+        return animator.prepareAnimation(entry.animation, *entry.palette, entry.overrides);
+    }
+    return animator.prepareAnimation(entry.animation, entry.color, entry.overrides);
+}
+
+void Playlist::timerCallback(TimerHandle_t timer) {
+    static_cast<Playlist*>(pvTimerGetTimerID(timer))->onTimer();
+}
+
+// Выполняется в задаче таймеров FreeRTOS: блокироваться здесь нельзя
+void Playlist::onTimer() {
+    if (phase == Phase::Prepare) {
+        if (animator.isSwitchPending()) {
+            // Задача анимации ещё не забрала прошлый элемент — проверим через кадр
+            // текущей частоты отрисовки
+            xTimerChangePeriod(timer, pdMS_TO_TICKS(1000 / animator.getRenderRate()), 0);
+            return;
+        }
+        prepareEntry(nextIndex);
+        phase = Phase::Switch;
+
+        TickType_t elapsed = xTaskGetTickCount() - switchTime;
+        TickType_t duration = pdMS_TO_TICKS(entries[currentIndex].durationMs);
+        xTimerChangePeriod(timer, duration > elapsed ? duration - elapsed : 1, 0);
+        return;
+    }
+
+    animator.commitAnimation();
+    currentIndex = nextIndex;
+    nextIndex = (nextIndex + 1) % entryCount;
+    switchTime = xTaskGetTickCount();
+    phase = Phase::Prepare;
+    xTimerChangePeriod(timer, pdMS_TO_TICKS(PREPARE_DELAY), 0);
+
+    LOG(PlaylistSwitched, SoundAnimator::getAnimationName(entries[currentIndex].animation));
+}
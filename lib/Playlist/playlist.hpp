@@ -0,0 +1,51 @@
+#ifndef PLAYLIST_HPP
+#define PLAYLIST_HPP
+
+#include <Arduino.h>
+#include <freertos/timers.h>
+#include "sound_animator.hpp"
+
+// Элемент плейлиста: анимация, цвет, длительность и переопределения параметров
+struct PlaylistEntry {
+    AnimationType animation;
+    CRGB color;                   // CRGB::Black — радужная палитра
+    uint32_t durationMs;
+    AnimationOverrides overrides;
+    const Palette* palette = nullptr; // Если задана, используется вместо color
+};
+
+// Плейлист анимаций на программном таймере FreeRTOS.
+// Таймер работает в две фазы: в момент смены переключает аниматор на заранее
+// подготовленный элемент, а спустя пару кадров готовит следующий, так что
+// ни выделение памяти, ни сборка замыкания не попадают в кадр перехода.
+class Playlist {
+public:
+    Playlist(SoundAnimator& animator);
+    ~Playlist();
+
+    void setEntries(const PlaylistEntry* entries, size_t count); // Массив должен жить дольше плейлиста
+    void start();
+    void stop();
+
+    size_t getCurrentIndex() const { return currentIndex; }
+
+private:
+    enum class Phase { Prepare, Switch };
+
+    static constexpr uint32_t PREPARE_DELAY = 2 * UPDATE_INTERVAL; // Пауза после смены до подготовки следующего, мс
+
+    static void timerCallback(TimerHandle_t timer);
+    void onTimer();
+    bool prepareEntry(size_t index);
+
+    SoundAnimator& animator;
+    TimerHandle_t timer = nullptr;
+    const PlaylistEntry* entries = nullptr;
+    size_t entryCount = 0;
+    size_t currentIndex = 0;
+    size_t nextIndex = 0;
+    Phase phase = Phase::Prepare;
+    TickType_t switchTime = 0;
+};
+
+#endif // PLAYLIST_HPP
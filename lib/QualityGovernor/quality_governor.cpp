@@ -0,0 +1,65 @@
+#include "quality_governor.hpp"
+#include "deferred_log.hpp"
+#include <algorithm>
+
+QualityGovernor::QualityGovernor(uint32_t frameBudgetUs, QualityLevel firstStep, QualityLevel lastStep)
+    : frameBudgetUs(frameBudgetUs), firstStep(firstStep), lastStep(lastStep) {
+}
+
+bool QualityGovernor::addFrame(uint32_t frameUs) {
+    if (averageFrameUs == 0) {
+        averageFrameUs = frameUs;
+    } else {
+        averageFrameUs += ((int32_t)frameUs - (int32_t)averageFrameUs) >> AVERAGE_SHIFT;
+    }
+    if (probation && ++framesSinceUp >= upDelayFrames) {
+        // Повышенный уровень продержался без перегрузки — выдержка снова исходная
+        probation = false;
+        upDelayFrames = UP_FRAMES;
+    }
+
+    if (averageFrameUs > frameBudgetUs) {
+        headroomFrames = 0;
+        if (level == lastStep || ++overloadFrames < DOWN_FRAMES) {
+            return false;
+        }
+        // Перегрузка вскоре после повышения — повышение было преждевременным
+        if (probation) {
+            probation = false;
+            upDelayFrames = std::min<uint32_t>(upDelayFrames * 2, MAX_UP_FRAMES);
+        }
+        setLevel(level == QualityLevel::Full ? firstStep : (QualityLevel)((uint8_t)level + 1));
+        return true;
+    }
+
+    overloadFrames = 0;
+    if (averageFrameUs * 100 > frameBudgetUs * HEADROOM_PERCENT) {
+        headroomFrames = 0;
+        return false;
+    }
+    if (++headroomFrames < upDelayFrames || level == QualityLevel::Full) {
+        return false;
+    }
+    setLevel(level == firstStep ? QualityLevel::Full : (QualityLevel)((uint8_t)level - 1));
+    probation = true;
+    framesSinceUp = 0;
+    return true;
+}
+
+void QualityGovernor::setLevel(QualityLevel next) {
+    LOG(QualityChanged, getLevelName(level), getLevelName(next), averageFrameUs, frameBudgetUs);
+    level = next;
+    overloadFrames = 0;
+    headroomFrames = 0;
+}
+
+const char* QualityGovernor::getLevelName(QualityLevel level) {
+    switch (level) {
+        case QualityLevel::Full:           return "Full";
+        case QualityLevel::NoDither:       return "NoDither";
+        case QualityLevel::FewerParticles: return "FewerParticles";
+        case QualityLevel::HalfAnalysis:   return "HalfAnalysis";
+        case QualityLevel::SmallFft:       return "SmallFft";
+        default:                           return "Unknown";
+    }
+}
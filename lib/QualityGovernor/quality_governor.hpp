@@ -0,0 +1,59 @@
+#ifndef QUALITY_GOVERNOR_HPP
+#define QUALITY_GOVERNOR_HPP
+
+#include <Arduino.h>
+
+// Уровни качества от полного к самому дешёвому. Каждый следующий уровень
+// лестницы регулятора включает упрощения предыдущих.
+enum class QualityLevel : uint8_t {
+    Full,           // Всё включено
+    NoDither,       // Без временного дизеринга
+    FewerParticles, // Вдвое меньше частиц
+    HalfAnalysis,   // Анализ с половинной частотой, между кадрами анализа — смешивание
+    SmallFft,       // FFT вдвое меньше: короче и захват, и преобразование
+    Count
+};
+
+// Регулятор качества по измеренному времени кадра.
+// Понижает уровень, когда среднее время кадра держится выше бюджета,
+// и повышает, когда долго держится запас. Между порогами — гистерезис,
+// а неудачное повышение удваивает выдержку перед следующей попыткой.
+// Регулятор ходит по своей лестнице: Full и уровни firstStep..lastStep.
+// Так упрощения отрисовки и анализа управляются временем своей задачи.
+class QualityGovernor {
+public:
+    explicit QualityGovernor(uint32_t frameBudgetUs, QualityLevel firstStep = QualityLevel::NoDither,
+                             QualityLevel lastStep = QualityLevel::SmallFft);
+
+    // Учесть время очередного кадра; true — уровень изменился
+    bool addFrame(uint32_t frameUs);
+
+    void setFrameBudget(uint32_t budgetUs) { frameBudgetUs = budgetUs; } // При смене частоты кадров
+    uint32_t getFrameBudget() const { return frameBudgetUs; }
+
+    QualityLevel getLevel() const { return level; }
+    uint32_t getAverageFrameUs() const { return averageFrameUs; }
+    static const char* getLevelName(QualityLevel level);
+
+private:
+    static constexpr uint8_t AVERAGE_SHIFT = 3;     // Экспоненциальное среднее за ~8 кадров
+    static constexpr uint8_t DOWN_FRAMES = 8;       // Кадров перегрузки до понижения
+    static constexpr uint16_t UP_FRAMES = 250;      // Кадров запаса до повышения (5 с при 50 FPS)
+    static constexpr uint16_t MAX_UP_FRAMES = 2000;
+    static constexpr uint8_t HEADROOM_PERCENT = 85; // Порог запаса, % бюджета
+
+    uint32_t frameBudgetUs;
+    QualityLevel firstStep; // Первое упрощение лестницы
+    QualityLevel lastStep;  // Самое дешёвое
+    uint32_t averageFrameUs = 0;
+    QualityLevel level = QualityLevel::Full;
+    uint8_t overloadFrames = 0;
+    uint16_t headroomFrames = 0;
+    uint16_t upDelayFrames = UP_FRAMES;
+    bool probation = false;      // Идёт проверка последнего повышения
+    uint16_t framesSinceUp = 0;  // Кадров после последнего повышения
+
+    void setLevel(QualityLevel next);
+};
+
+#endif // QUALITY_GOVERNOR_HPP
@@ -0,0 +1,94 @@
+#ifndef RENDER_MATH_HPP
+#define RENDER_MATH_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Целочисленная математика отрисовки.
+// Отрисовка кадра не трогает float: величины анализа приходят в Q16.16,
+// синус и масштабы берутся из таблиц, построенных при компиляции.
+
+typedef uint8_t q8_t;   // Доля 0..255 (255 ~ 1.0)
+typedef int32_t q16_t;  // Фиксированная точка 16.16
+
+constexpr q16_t Q16_ONE = (q16_t)1 << 16;
+
+constexpr q16_t q16FromInt(int32_t value) { return value * Q16_ONE; }
+constexpr int32_t q16ToInt(q16_t value) { return value >> 16; }
+constexpr q16_t q16Mul(q16_t a, q16_t b) { return (q16_t)(((int64_t)a * b) >> 16); }
+
+// Перевод из float — только вне отрисовки (настройки, публикация кадра)
+constexpr q16_t q16FromFloat(float value) {
+    return (q16_t)(value * 65536.0f + (value >= 0.0f ? 0.5f : -0.5f));
+}
+
+// Угол: полный оборот — 65536
+typedef uint16_t angle16_t;
+
+constexpr angle16_t angleFromRadians(float radians) {
+    return (angle16_t)(int32_t)(radians * (65536.0f / 6.283185307f) + 0.5f);
+}
+
+// Линейная интерполяция от a к b по доле t; t = 255 даёт ровно b
+constexpr int32_t lerpQ8(int32_t a, int32_t b, q8_t t) {
+    return a + (b - a) * t / 255;
+}
+
+// Таблица, построенная constexpr-функцией
+template <typename T, size_t N>
+struct LookupTable {
+    T values[N];
+    constexpr T operator[](size_t index) const { return values[index]; }
+    static constexpr size_t size() { return N; }
+};
+
+namespace render_math_detail {
+
+constexpr double TWO_PI = 6.283185307179586;
+
+// Ряд Тейлора на [-pi, pi]: 12 членов дают точность много выше Q15
+constexpr double sine(double x) {
+    double term = x;
+    double sum = x;
+    for (int n = 1; n < 12; n++) {
+        term *= -x * x / ((2 * n) * (2 * n + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr LookupTable<int16_t, 257> makeSineTable() {
+    LookupTable<int16_t, 257> table{};
+    for (int i = 0; i <= 256; i++) {
+        double x = (i <= 128 ? i : i - 256) * TWO_PI / 256;
+        double value = sine(x) * 32767.0;
+        table.values[i] = (int16_t)(value >= 0 ? value + 0.5 : value - 0.5);
+    }
+    return table;
+}
+
+} // namespace render_math_detail
+
+// Синус на 256 точек за оборот в Q15; последняя точка повторяет первую для интерполяции
+inline constexpr LookupTable<int16_t, 257> SINE_TABLE = render_math_detail::makeSineTable();
+
+// Синус угла в Q15 (-32767..32767) с линейной интерполяцией между точками таблицы
+inline int16_t sin16(angle16_t angle) {
+    uint8_t index = angle >> 8;
+    int32_t fraction = angle & 0xFF;
+    int32_t a = SINE_TABLE[index];
+    int32_t b = SINE_TABLE[index + 1];
+    return (int16_t)(a + (((b - a) * fraction) >> 8));
+}
+
+// Таблица масштаба: table[i] = map(i, 0, N - 1, 0, outMax)
+template <size_t N>
+constexpr LookupTable<uint8_t, N> makeScaleTable(uint8_t outMax) {
+    LookupTable<uint8_t, N> table{};
+    for (size_t i = 0; i < N; i++) {
+        table.values[i] = (uint8_t)(i * outMax / (N - 1));
+    }
+    return table;
+}
+
+#endif // RENDER_MATH_HPP
@@ -1,8 +1,12 @@
 #include "sound_animator.hpp"
+#include "deferred_log.hpp"
+#include "trace_recorder.hpp"
 #include "config.hpp"
-#include <cmath>
 #include <Arduino.h>
+#include <algorithm>
+#include <math.h>
 #include <Preferences.h>
+#include <esp_sleep.h>
 
 // Константы (объявления)
 constexpr const char* NVS_NAMESPACE = "soundanim";
@@ -17,6 +21,10 @@ constexpr const char* KEY_FADE_AMT = "FADE_AMT";
 constexpr const char* KEY_WAVE_PHASE = "WAVE_PHASE";
 constexpr const char* KEY_WAVE_FREQ = "WAVE_FREQ";
 constexpr const char* KEY_RECT_MIN = "RECT_MIN";
+constexpr const char* KEY_COLOR_BRI = "COLOR_BRI";
+constexpr const char* KEY_RENDER_HZ = "RENDER_HZ";
+constexpr const char* KEY_ANALYSIS_HZ = "ANALYSIS_HZ";
+constexpr const char* KEY_SPEC_BLEND = "SPEC_BLEND";
 
 constexpr float DEFAULT_COLOR_AMPLITUDE_SENSITIVITY = 1.5f;
 constexpr float DEFAULT_PULSING_RECTANGLE_SENSITIVITY = 0.9f;
@@ -29,8 +37,21 @@ constexpr uint8_t DEFAULT_FADE_AMOUNT = 200;
 constexpr float DEFAULT_WAVE_PHASE_INCREMENT = 0.1f;
 constexpr float DEFAULT_WAVE_FREQUENCY = 0.3f;
 constexpr uint8_t DEFAULT_RECTANGLE_MIN_SIZE = 1;
-
-SoundAnimator::SoundAnimator(LedMatrix& matrix)
+constexpr uint8_t DEFAULT_COLOR_BRIGHTNESS = 255;
+constexpr uint8_t DEFAULT_RENDER_RATE = RENDER_RATE;
+constexpr uint8_t DEFAULT_ANALYSIS_RATE = ANALYSIS_RATE;
+constexpr SpectrumBlend DEFAULT_SPECTRUM_BLEND = SpectrumBlend::Interpolate;
+constexpr uint8_t MIN_RENDER_RATE = 20;
+constexpr uint8_t MIN_ANALYSIS_RATE = 10;
+
+// Параметры звёзд (частиц) звёздного неба
+constexpr uint8_t STAR_MIN_LIFE = 12;     // Кадров
+constexpr uint8_t STAR_MAX_LIFE = 40;     // Кадров
+constexpr uint8_t STAR_AVERAGE_LIFE = 16; // Средняя видимая жизнь с учётом затухания, кадров
+constexpr int8_t STAR_MAX_DRIFT = 24;     // Скорость дрейфа, 1/256 пикселя за кадр
+
+template <typename Analyzer>
+BasicSoundAnimator<Analyzer>::BasicSoundAnimator(LedMatrix& matrix)
     : ledMatrix(matrix),
       audioAnalyzer(),
       preferences(),
@@ -45,22 +66,32 @@ SoundAnimator::SoundAnimator(LedMatrix& matrix)
       wavePhaseIncrement(DEFAULT_WAVE_PHASE_INCREMENT),
       waveFrequency(DEFAULT_WAVE_FREQUENCY),
       rectangleMinSize(DEFAULT_RECTANGLE_MIN_SIZE),
+      colorBrightness(DEFAULT_COLOR_BRIGHTNESS),
+      renderRate(DEFAULT_RENDER_RATE),
+      analysisRate(DEFAULT_ANALYSIS_RATE),
+      spectrumBlend(DEFAULT_SPECTRUM_BLEND),
       isAnimating(false),
       currentRenderMethod(nullptr),
-      animationTaskHandle(nullptr) {
-   
+      qualityGovernor(1000000 / DEFAULT_RENDER_RATE, QualityLevel::NoDither, QualityLevel::FewerParticles),
+      analysisGovernor(1000000 / DEFAULT_ANALYSIS_RATE, QualityLevel::HalfAnalysis, QualityLevel::SmallFft),
+      animationTask("AnimTask", ANIM_TASK_STACK_SIZE, 1, 1),
+      analysisTask("AnalysisTask", ANALYSIS_TASK_STACK_SIZE, 1, ANALYSIS_TASK_CORE) {
+    updateFixedSettings();
 }
 
-void SoundAnimator::init() {
-    Serial.println("[SoundAnimator] Initializing...");
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::init() {
+    LOG(AnimatorInit);
     preferences.begin(NVS_NAMESPACE, false);
-    Serial.println("[SoundAnimator] Loading settings from NVS...");
+    LOG(AnimatorLoading);
     loadSettings();
     preferences.end();
-    Serial.println("[SoundAnimator] Initialization complete.");
+    createTasks();
+    LOG(AnimatorReady);
 }
 
-SoundAnimator::~SoundAnimator() {
+template <typename Analyzer>
+BasicSoundAnimator<Analyzer>::~BasicSoundAnimator() {
     // Останавливаем задачу анимации, если она запущена
     stopTask();
 
@@ -71,110 +102,143 @@ SoundAnimator::~SoundAnimator() {
     // Завершаем работу с NVS
     preferences.end();
 
-    Serial.println("[SoundAnimator] Destructor called. Resources cleaned up.");
+    LOG(AnimatorDestroyed);
 }
 
 // ======================
 //    NVS: загрузка
 // ======================
-void SoundAnimator::loadSettings() {
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::loadSettings() {
     if (!preferences.isKey(KEY_COLOR_SENS)) {
         preferences.putFloat(KEY_COLOR_SENS, colorAmplitudeSensitivity);
     } else {
         colorAmplitudeSensitivity = preferences.getFloat(KEY_COLOR_SENS, DEFAULT_COLOR_AMPLITUDE_SENSITIVITY);
     }
-    Serial.printf("[SoundAnimator] colorAmpSens = %.2f\n", colorAmplitudeSensitivity);
+    LOG(AnimatorSettingFloat, "colorAmpSens", colorAmplitudeSensitivity);
 
     if (!preferences.isKey(KEY_RECT_SENS)) {
         preferences.putFloat(KEY_RECT_SENS, pulsingRectangleSensitivity);
     } else {
         pulsingRectangleSensitivity = preferences.getFloat(KEY_RECT_SENS, DEFAULT_PULSING_RECTANGLE_SENSITIVITY);
     }
-    Serial.printf("[SoundAnimator] pulseRectSens = %.2f\n", pulsingRectangleSensitivity);
+    LOG(AnimatorSettingFloat, "pulseRectSens", pulsingRectangleSensitivity);
 
     if (!preferences.isKey(KEY_SKY_SENS)) {
         preferences.putFloat(KEY_SKY_SENS, starrySkySensitivity);
     } else {
         starrySkySensitivity = preferences.getFloat(KEY_SKY_SENS, DEFAULT_STARRY_SKY_SENSITIVITY);
     }
-    Serial.printf("[SoundAnimator] starrySens     = %.2f\n", starrySkySensitivity);
+    LOG(AnimatorSettingFloat, "starrySens", starrySkySensitivity);
 
     if (!preferences.isKey(KEY_WAVE_SENS)) {
         preferences.putFloat(KEY_WAVE_SENS, waveSensitivity);
     } else {
         waveSensitivity = preferences.getFloat(KEY_WAVE_SENS, DEFAULT_WAVE_SENSITIVITY);
     }
-    Serial.printf("[SoundAnimator] waveSens       = %.2f\n", waveSensitivity);
+    LOG(AnimatorSettingFloat, "waveSens", waveSensitivity);
 
     if (!preferences.isKey(KEY_STAR_MAX)) {
         preferences.putUChar(KEY_STAR_MAX, starrySkyMaxStars);
     } else {
         starrySkyMaxStars = preferences.getUChar(KEY_STAR_MAX, DEFAULT_STAR_MAX_COUNT);
     }
-    Serial.printf("[SoundAnimator] starMax        = %u\n", starrySkyMaxStars);
+    LOG(AnimatorSettingInt, "starMax", starrySkyMaxStars);
 
     if (!preferences.isKey(KEY_STAR_MIN_BRI)) {
         preferences.putUChar(KEY_STAR_MIN_BRI, starrySkyMinBrightness);
     } else {
         starrySkyMinBrightness = preferences.getUChar(KEY_STAR_MIN_BRI, DEFAULT_STAR_MIN_BRIGHTNESS);
     }
-    Serial.printf("[SoundAnimator] starMinB       = %u\n", starrySkyMinBrightness);
+    LOG(AnimatorSettingInt, "starMinB", starrySkyMinBrightness);
 
     if (!preferences.isKey(KEY_STAR_MAX_BRI)) {
         preferences.putUChar(KEY_STAR_MAX_BRI, starrySkyMaxBrightness);
     } else {
         starrySkyMaxBrightness = preferences.getUChar(KEY_STAR_MAX_BRI, DEFAULT_STAR_MAX_BRIGHTNESS);
     }
-    Serial.printf("[SoundAnimator] starMaxB       = %u\n", starrySkyMaxBrightness);
+    LOG(AnimatorSettingInt, "starMaxB", starrySkyMaxBrightness);
 
     if (!preferences.isKey(KEY_FADE_AMT)) {
         preferences.putUChar(KEY_FADE_AMT, fadeAmount);
     } else {
         fadeAmount = preferences.getUChar(KEY_FADE_AMT, DEFAULT_FADE_AMOUNT);
     }
-    Serial.printf("[SoundAnimator] fadeAmt        = %u\n", fadeAmount);
+    LOG(AnimatorSettingInt, "fadeAmt", fadeAmount);
 
     if (!preferences.isKey(KEY_WAVE_PHASE)) {
         preferences.putFloat(KEY_WAVE_PHASE, wavePhaseIncrement);
     } else {
         wavePhaseIncrement = preferences.getFloat(KEY_WAVE_PHASE, DEFAULT_WAVE_PHASE_INCREMENT);
     }
-    Serial.printf("[SoundAnimator] wavePhase      = %.2f\n", wavePhaseIncrement);
+    LOG(AnimatorSettingFloat, "wavePhase", wavePhaseIncrement);
 
     if (!preferences.isKey(KEY_WAVE_FREQ)) {
         preferences.putFloat(KEY_WAVE_FREQ, waveFrequency);
     } else {
         waveFrequency = preferences.getFloat(KEY_WAVE_FREQ, DEFAULT_WAVE_FREQUENCY);
     }
-    Serial.printf("[SoundAnimator] waveFreq       = %.2f\n", waveFrequency);
+    LOG(AnimatorSettingFloat, "waveFreq", waveFrequency);
 
     if (!preferences.isKey(KEY_RECT_MIN)) {
         preferences.putUChar(KEY_RECT_MIN, rectangleMinSize);
     } else {
         rectangleMinSize = preferences.getUChar(KEY_RECT_MIN, DEFAULT_RECTANGLE_MIN_SIZE);
     }
-    Serial.printf("[SoundAnimator] rectMin        = %u\n", rectangleMinSize);
+    LOG(AnimatorSettingInt, "rectMin", rectangleMinSize);
+
+    if (!preferences.isKey(KEY_COLOR_BRI)) {
+        preferences.putUChar(KEY_COLOR_BRI, colorBrightness);
+    } else {
+        colorBrightness = preferences.getUChar(KEY_COLOR_BRI, DEFAULT_COLOR_BRIGHTNESS);
+    }
+    LOG(AnimatorSettingInt, "colorBri", colorBrightness);
+
+    if (!preferences.isKey(KEY_RENDER_HZ)) {
+        preferences.putUChar(KEY_RENDER_HZ, renderRate);
+    } else {
+        renderRate = preferences.getUChar(KEY_RENDER_HZ, DEFAULT_RENDER_RATE);
+    }
+    if (!preferences.isKey(KEY_ANALYSIS_HZ)) {
+        preferences.putUChar(KEY_ANALYSIS_HZ, analysisRate);
+    } else {
+        analysisRate = preferences.getUChar(KEY_ANALYSIS_HZ, DEFAULT_ANALYSIS_RATE);
+    }
+    if (!preferences.isKey(KEY_SPEC_BLEND)) {
+        preferences.putUChar(KEY_SPEC_BLEND, (uint8_t)spectrumBlend);
+    } else {
+        spectrumBlend = (SpectrumBlend)preferences.getUChar(KEY_SPEC_BLEND, (uint8_t)DEFAULT_SPECTRUM_BLEND);
+    }
+    LOG(AnimatorRates, renderRate, analysisRate, spectrumBlend);
+    rateSettingsDirty = true;
+
+    updateFixedSettings();
 }
 
 // ======================
 //    NVS: сохранение
 // ======================
-void SoundAnimator::saveSetting(const char* key, float value) {
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::saveSetting(const char* key, float value) {
+    TRACE_SCOPE(SettingsWrite);
     preferences.begin(NVS_NAMESPACE, false);
     preferences.putFloat(key, value);
     preferences.end();
-    Serial.printf("[SoundAnimator] Saved %s = %.2f\n", key, value);
+    LOG(AnimatorSavedFloat, key, value);
 }
 
-void SoundAnimator::saveSetting(const char* key, uint8_t value) {
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::saveSetting(const char* key, uint8_t value) {
+    TRACE_SCOPE(SettingsWrite);
     preferences.begin(NVS_NAMESPACE, false);
     preferences.putUChar(key, value);
     preferences.end();
-    Serial.printf("[SoundAnimator] Saved %s = %u\n", key, value);
+    LOG(AnimatorSavedInt, key, value);
 }
 
 // Сброс всех настроек на дефолты
-void SoundAnimator::resetSettings() {
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::resetSettings() {
     preferences.begin(NVS_NAMESPACE, false);
     preferences.clear(); // Очищаем все сохранённые настройки
 
@@ -190,6 +254,10 @@ void SoundAnimator::resetSettings() {
     preferences.putFloat(KEY_WAVE_PHASE, DEFAULT_WAVE_PHASE_INCREMENT);
     preferences.putFloat(KEY_WAVE_FREQ, DEFAULT_WAVE_FREQUENCY);
     preferences.putUChar(KEY_RECT_MIN, DEFAULT_RECTANGLE_MIN_SIZE);
+    preferences.putUChar(KEY_COLOR_BRI, DEFAULT_COLOR_BRIGHTNESS);
+    preferences.putUChar(KEY_RENDER_HZ, DEFAULT_RENDER_RATE);
+    preferences.putUChar(KEY_ANALYSIS_HZ, DEFAULT_ANALYSIS_RATE);
+    preferences.putUChar(KEY_SPEC_BLEND, (uint8_t)DEFAULT_SPECTRUM_BLEND);
 
     preferences.end();
 
@@ -205,117 +273,158 @@ void SoundAnimator::resetSettings() {
     wavePhaseIncrement = DEFAULT_WAVE_PHASE_INCREMENT;
     waveFrequency = DEFAULT_WAVE_FREQUENCY;
     rectangleMinSize = DEFAULT_RECTANGLE_MIN_SIZE;
+    colorBrightness = DEFAULT_COLOR_BRIGHTNESS;
+    renderRate = DEFAULT_RENDER_RATE;
+    analysisRate = DEFAULT_ANALYSIS_RATE;
+    spectrumBlend = DEFAULT_SPECTRUM_BLEND;
+    rateSettingsDirty = true;
+    updateFixedSettings();
 }
 
 // ======================
 // Сеттеры с валидацией
 // ======================
-void SoundAnimator::setColorAmplitudeSensitivity(float v) {
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setColorAmplitudeSensitivity(float v) {
     if (v > 0.0f && v <= 10.0f) {
         colorAmplitudeSensitivity = v;
         saveSetting(KEY_COLOR_SENS, v);
     }
 }
-void SoundAnimator::setPulsingRectangleSensitivity(float v) {
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setPulsingRectangleSensitivity(float v) {
     if (v > 0.0f && v <= 10.0f) {
         pulsingRectangleSensitivity = v;
+        updateFixedSettings();
         saveSetting(KEY_RECT_SENS, v);
     }
 }
-void SoundAnimator::setStarrySkySensitivity(float v) {
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setStarrySkySensitivity(float v) {
     if (v > 0.0f && v <= 10.0f) {
         starrySkySensitivity = v;
+        updateFixedSettings();
         saveSetting(KEY_SKY_SENS, v);
     }
 }
-void SoundAnimator::setWaveSensitivity(float v) {
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setWaveSensitivity(float v) {
     if (v > 0.0f && v <= 10.0f) {
         waveSensitivity = v;
+        updateFixedSettings();
         saveSetting(KEY_WAVE_SENS, v);
     }
 }
-void SoundAnimator::setStarrySkyMaxStars(uint8_t v) {
-    starrySkyMaxStars = constrain(v, 1, MATRIX_WIDTH * MATRIX_HEIGHT);
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setStarrySkyMaxStars(uint8_t v) {
+    starrySkyMaxStars = constrain(v, 1, ParticleSystem::CAPACITY);
+    stars.setLimit(starrySkyMaxStars);
     saveSetting(KEY_STAR_MAX, v);
 }
-void SoundAnimator::setStarrySkyMinBrightness(uint8_t v) {
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setStarrySkyMinBrightness(uint8_t v) {
     starrySkyMinBrightness = constrain(v, 0, 255);
     saveSetting(KEY_STAR_MIN_BRI, v);
 }
-void SoundAnimator::setStarrySkyMaxBrightness(uint8_t v) {
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setStarrySkyMaxBrightness(uint8_t v) {
     starrySkyMaxBrightness = constrain(v, 0, 255);
     saveSetting(KEY_STAR_MAX_BRI, v);
 }
-void SoundAnimator::setFadeAmount(uint8_t v) {
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setFadeAmount(uint8_t v) {
     fadeAmount = constrain(v, 0, 255);
+    rateSettingsDirty = true; // Затухание за кадр зависит от частоты
     saveSetting(KEY_FADE_AMT, v);
 }
-void SoundAnimator::setWavePhaseIncrement(float v) {
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setWavePhaseIncrement(float v) {
     if (v > 0.0f && v <= 1.0f) {
         wavePhaseIncrement = v;
+        updateFixedSettings();
         saveSetting(KEY_WAVE_PHASE, v);
     }
 }
-void SoundAnimator::setWaveFrequency(float v) {
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setWaveFrequency(float v) {
     if (v > 0.0f && v <= 5.0f) {
         waveFrequency = v;
+        updateFixedSettings();
         saveSetting(KEY_WAVE_FREQ, v);
     }
 }
-void SoundAnimator::setRectangleMinSize(uint8_t v) {
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setRectangleMinSize(uint8_t v) {
     rectangleMinSize = constrain(v, 1, MATRIX_WIDTH);
     saveSetting(KEY_RECT_MIN, v);
 }
+// Таблица текущей анимации перезапекается задачей в начале следующего кадра
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setColorBrightness(uint8_t v) {
+    colorBrightness = v;
+    saveSetting(KEY_COLOR_BRI, v);
+}
+// Новые частоты применяет задача анимации в начале следующего кадра
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setFrameRates(uint8_t render, uint8_t analysis) {
+    if (render < MIN_RENDER_RATE || render > MAX_RENDER_RATE || analysis < MIN_ANALYSIS_RATE || analysis > render) {
+        LOG(AnimatorBadRates, render, analysis);
+        return;
+    }
+    renderRate = render;
+    analysisRate = analysis;
+    rateSettingsDirty = true;
+    saveSetting(KEY_RENDER_HZ, render);
+    saveSetting(KEY_ANALYSIS_HZ, analysis);
+}
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setSpectrumBlend(SpectrumBlend mode) {
+    spectrumBlend = mode;
+    rateSettingsDirty = true;
+    saveSetting(KEY_SPEC_BLEND, (uint8_t)mode);
+}
 
 // ==============
 // Методы рендеринга
 // ==============
-void SoundAnimator::renderColorAmplitude(CRGB color) {
-    audioAnalyzer.processAudio();
+// Индекс в таблице цветов по высоте столбца и по отклонению волны от центра
+constexpr auto HEIGHT_INDEX = makeScaleTable<MATRIX_HEIGHT + 1>(255);
+constexpr auto WAVE_INDEX = makeScaleTable<MATRIX_HEIGHT / 2 + 1>(255);
+
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::renderColorAmplitude(const ColorTable& colors, const FixedOverrides& overrides) {
     uint16_t heights[MATRIX_WIDTH];
-    audioAnalyzer.getNormalizedHeights(heights, MATRIX_WIDTH);
+    normalizeHeights(frameBlender.getFrame(), heights, MATRIX_HEIGHT);
+    // Переопределённая чувствительность умножает высоту столбцов;
+    // без неё высоты остаются нормированными анализатором
+    if (overrides.sensitivity) {
+        for (int x = 0; x < MATRIX_WIDTH; x++) {
+            heights[x] = std::min<int32_t>(q16ToInt(q16Mul(q16FromInt(heights[x]), overrides.sensitivity)), MATRIX_HEIGHT);
+        }
+    }
 
     CRGB* leds = ledMatrix.getLeds();
     fill_solid(leds, MATRIX_WIDTH * MATRIX_HEIGHT, CRGB::Black);
 
     for (int x = 0; x < MATRIX_WIDTH; x++) {
+        // Цвет зависит только от высоты, поэтому выбирается раз на столбец
+        CRGB columnColor = colors[HEIGHT_INDEX[heights[x]]];
         for (int y = MATRIX_HEIGHT - heights[x]; y < MATRIX_HEIGHT; y++) {
-            if (color == CRGB::Black) {
-                uint8_t hue = map(heights[x], 0, MATRIX_HEIGHT, 0, 255);
-                leds[ledMatrix.XY(x, y)] = CHSV(hue, 255, 255);
-            } else {
-                leds[ledMatrix.XY(x, y)] = color;
-            }
+            leds[ledMatrix.XY(x, y)] = columnColor;
         }
     }
-    ledMatrix.update(); // Заменено FastLED.show()
 }
 
-void SoundAnimator::renderPulsingRectangle(CRGB color) {
-    // Обрабатываем аудиосигнал
-    audioAnalyzer.processAudio();
-    float logRmsEnergy = audioAnalyzer.getTotalLogRmsEnergy(); // Получаем логарифмическую RMS-энергию
-    float minLogPower = audioAnalyzer.getMinLogPower();        // Минимальное значение мощности
-    float maxLogPower = audioAnalyzer.getMaxLogPower();        // Максимальное значение мощности
-
-    // Усиление сигнала с учётом чувствительности
-    float amplified = logRmsEnergy * pulsingRectangleSensitivity;
-
-    // Используем статистику для определения диапазона
-    float dynamicMinLogPower = minLogPower;
-    float dynamicMaxLogPower = maxLogPower;
-
-    // Убедимся, что диапазон корректен
-    dynamicMinLogPower = constrain(dynamicMinLogPower, 1.0f, 50.0f);
-    dynamicMaxLogPower = constrain(dynamicMaxLogPower, dynamicMinLogPower + 1.0f, 100.0f);
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::renderPulsingRectangle(const ColorTable& colors, const FixedOverrides& overrides) {
+    // Громкость с учётом чувствительности
+    q16_t sensitivity = overrides.sensitivity ? overrides.sensitivity : pulsingRectangleSensitivityQ16;
+    uint8_t minSize = overrides.rectangleMinSize ? overrides.rectangleMinSize : rectangleMinSize;
+    q8_t level = energyLevel(frameBlender.getFrame(), sensitivity);
 
     // Вычисляем размеры прямоугольника
-    uint8_t w = map(amplified, dynamicMinLogPower, dynamicMaxLogPower, rectangleMinSize, MATRIX_WIDTH);
-    uint8_t h = map(amplified, dynamicMinLogPower, dynamicMaxLogPower, rectangleMinSize, MATRIX_HEIGHT);
-
-    // Ограничиваем размеры
-    w = constrain(w, rectangleMinSize, MATRIX_WIDTH);
-    h = constrain(h, rectangleMinSize, MATRIX_HEIGHT);
+    int w = lerpQ8(minSize, MATRIX_WIDTH, level);
+    int h = lerpQ8(minSize, MATRIX_HEIGHT, level);
 
     // Получаем массив светодиодов
     CRGB* leds = ledMatrix.getLeds();
@@ -331,7 +440,8 @@ void SoundAnimator::renderPulsingRectangle(CRGB color) {
     ex = constrain(ex, 0, MATRIX_WIDTH - 1);
     ey = constrain(ey, 0, MATRIX_HEIGHT - 1);
 
-    // Рисуем прямоугольник
+    // Рисуем прямоугольник цветом громкости
+    CRGB color = colors[level];
     for (int x = sx; x <= ex; x++) {
         leds[ledMatrix.XY(x, sy)] = color;
         leds[ledMatrix.XY(x, ey)] = color;
@@ -340,88 +450,89 @@ void SoundAnimator::renderPulsingRectangle(CRGB color) {
         leds[ledMatrix.XY(sx, y)] = color;
         leds[ledMatrix.XY(ex, y)] = color;
     }
-
-    // Обновляем матрицу
-    ledMatrix.update();
 }
 
-void SoundAnimator::renderStarrySky(CRGB color) {
-    // Обрабатываем аудиосигнал
-    audioAnalyzer.processAudio();
-    float logRmsEnergy = audioAnalyzer.getTotalLogRmsEnergy(); // Получаем логарифмическую RMS-энергию
-    float minLogPower = audioAnalyzer.getMinLogPower();        // Минимальное значение мощности
-    float maxLogPower = audioAnalyzer.getMaxLogPower();        // Максимальное значение мощности
-
-    // Усиление сигнала с учётом чувствительности
-    float amplified = logRmsEnergy * starrySkySensitivity;
-
-    // Используем статистику для определения диапазона
-    float dynamicMinLogPower = minLogPower;
-    float dynamicMaxLogPower = maxLogPower;
-
-    // Убедимся, что диапазон корректен
-    dynamicMinLogPower = constrain(dynamicMinLogPower, 1.0f, 50.0f);
-    dynamicMaxLogPower = constrain(dynamicMaxLogPower, dynamicMinLogPower + 1.0f, 100.0f);
-
-    // Вычисляем количество звёзд
-    uint8_t count = map(amplified, dynamicMinLogPower, dynamicMaxLogPower, 1, starrySkyMaxStars);
-    count = constrain(count, 1, starrySkyMaxStars);
-
-    // Очищаем матрицу с эффектом затухания
-    CRGB* leds = ledMatrix.getLeds();
-    for (int i = 0; i < MATRIX_WIDTH * MATRIX_HEIGHT; i++) {
-        leds[i].nscale8(fadeAmount);
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::renderStarrySky(const ColorTable& colors, const FixedOverrides& overrides) {
+    // Громкость с учётом чувствительности
+    q16_t sensitivity = overrides.sensitivity ? overrides.sensitivity : starrySkySensitivityQ16;
+    uint8_t maxStars = (overrides.maxStars ? overrides.maxStars : starrySkyMaxStars) >> particleShift;
+    maxStars = std::max<uint8_t>(maxStars, 1);
+    q8_t level = energyLevel(frameBlender.getFrame(), sensitivity);
+
+    // Громкость задаёт частоту появления звёзд: при максимуме в среднем
+    // живёт около maxStars звёзд
+    uint8_t count = lerpQ8(1, maxStars, level);
+    uint8_t brightness = lerpQ8(starrySkyMinBrightness, starrySkyMaxBrightness, level);
+
+    // Появление, дрейф и жизнь заданы в кадрах REFERENCE_FRAME_RATE
+    // и пересчитываются под частоту отрисовки
+    stars.setLimit(maxStars);
+    starSpawnAccumulator += (((uint32_t)count << 8) / STAR_AVERAGE_LIFE * frameTimeScale) >> 8;
+    while (starSpawnAccumulator >= 256) {
+        starSpawnAccumulator -= 256;
+        int16_t x = (random(0, MATRIX_WIDTH) << 8) | 0x80;
+        int16_t y = (random(0, MATRIX_HEIGHT) << 8) | 0x80;
+        int8_t vx = random(-STAR_MAX_DRIFT, STAR_MAX_DRIFT + 1) * frameTimeScale >> 8;
+        int8_t vy = random(-STAR_MAX_DRIFT, STAR_MAX_DRIFT + 1) * frameTimeScale >> 8;
+        uint8_t life = std::min<uint32_t>(((uint32_t)random(STAR_MIN_LIFE, STAR_MAX_LIFE + 1) << 8) / frameTimeScale, 255);
+        if (!stars.spawn(x, y, vx, vy, brightness, life)) {
+            starSpawnAccumulator = 0;
+            break;
+        }
     }
 
-    // Рисуем звёзды
-    for (int i = 0; i < count; i++) {
-        int x = random(0, MATRIX_WIDTH);
-        int y = random(0, MATRIX_HEIGHT);
-        uint8_t brightness = map(amplified, dynamicMinLogPower, dynamicMaxLogPower, starrySkyMinBrightness, starrySkyMaxBrightness);
-        brightness = constrain(brightness, starrySkyMinBrightness, starrySkyMaxBrightness);
-        leds[ledMatrix.XY(x, y)] = color.nscale8(brightness);
-    }
+    // Пакетный шаг: звёзды разгораются, дрейфуют и гаснут с fadeAmount
+    stars.update(starFade);
 
-    // Обновляем матрицу
-    ledMatrix.update();
+    CRGB* leds = ledMatrix.getLeds();
+    fill_solid(leds, MATRIX_WIDTH * MATRIX_HEIGHT, CRGB::Black);
+    stars.draw(ledMatrix, leds, colors);
 }
 
-void SoundAnimator::renderWave(CRGB color) {
-    // Обрабатываем аудиосигнал
-    audioAnalyzer.processAudio();
-    float logRmsEnergy = audioAnalyzer.getTotalLogRmsEnergy(); // Получаем логарифмическую RMS-энергию
-    float minLogPower = audioAnalyzer.getMinLogPower();        // Минимальное значение мощности
-    float maxLogPower = audioAnalyzer.getMaxLogPower();        // Максимальное значение мощности
-
-    // Усиление сигнала с учётом чувствительности
-    float amplified = logRmsEnergy * waveSensitivity;
-
-    // Используем статистику для определения диапазона
-    float dynamicMinLogPower = minLogPower;
-    float dynamicMaxLogPower = maxLogPower;
-
-    // Убедимся, что диапазон корректен
-    dynamicMinLogPower = constrain(dynamicMinLogPower, 1.0f, 50.0f);
-    dynamicMaxLogPower = constrain(dynamicMaxLogPower, dynamicMinLogPower + 1.0f, 100.0f);
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::renderWave(const ColorTable& colors, const FixedOverrides& overrides) {
+    // Громкость с учётом чувствительности
+    q16_t sensitivity = overrides.sensitivity ? overrides.sensitivity : waveSensitivityQ16;
+    angle16_t phaseStep = overrides.wavePhaseIncrement ? overrides.wavePhaseIncrement : wavePhaseStep;
+    angle16_t columnStep = overrides.waveFrequency ? overrides.waveFrequency : waveColumnStep;
+    q8_t level = energyLevel(frameBlender.getFrame(), sensitivity);
 
     // Вычисляем высоту волны
-    uint8_t waveH = map(amplified, dynamicMinLogPower, dynamicMaxLogPower, 1, MATRIX_HEIGHT / 2);
-    waveH = constrain(waveH, 1, MATRIX_HEIGHT / 2);
-
-    // Фаза волны
-    static float phase = 0;
-    phase += wavePhaseIncrement;
-    phase = fmod(phase, 2 * PI); // Ограничиваем phase
+    int waveH = lerpQ8(1, MATRIX_HEIGHT / 2, level);
+
+    // Фаза волны: угол 16 бит переполняется ровно через полный оборот.
+    // Шаг задан на кадр REFERENCE_FRAME_RATE.
+    const AnalysisFrame& latest = frameBlender.getLatest();
+    uint32_t now = micros();
+    if (latest.beatPeriodUs) {
+        // Темп захвачен: фаза идёт со скоростью доли и подтягивается к её фазе.
+        // Произведения по модулю 2^32 дают угол точно: нужны биты 16..31.
+        if (latest.beatPeriodUs != waveBeatPeriodUs || phaseStep != waveBeatStep) {
+            configureWaveBeat(latest.beatPeriodUs, phaseStep);
+        }
+        angle16_t predicted = wavePhase + ((now - waveLastUs) * waveBeatRate >> 16);
+        angle16_t target = (now - latest.beatUs) * waveBeatRate >> 16;
+        // Волна с отражением за пол-оборота не меняется: ошибка берётся по модулю пол-оборота
+        int16_t error = (int16_t)((angle16_t)(target - predicted) << 1) >> 1;
+        wavePhase = predicted + error / 8;
+    } else {
+        wavePhase += (uint32_t)phaseStep * frameTimeScale >> 8;
+    }
+    waveLastUs = now;
 
     // Очищаем матрицу
     CRGB* leds = ledMatrix.getLeds();
     fill_solid(leds, MATRIX_WIDTH * MATRIX_HEIGHT, CRGB::Black);
 
     // Рисуем волну
-    for (int x = 0; x < MATRIX_WIDTH; x++) {
-        int cy = MATRIX_HEIGHT / 2;
-        int wy = cy + sin(phase + x * waveFrequency) * waveH;
+    int cy = MATRIX_HEIGHT / 2;
+    angle16_t angle = wavePhase;
+    for (int x = 0; x < MATRIX_WIDTH; x++, angle += columnStep) {
+        int wy = cy + sin16(angle) * waveH / 32767;
         wy = constrain(wy, 0, MATRIX_HEIGHT - 1);
+        // Цвет по отклонению от центра: гребни волны — верх палитры
+        CRGB color = colors[WAVE_INDEX[std::min(abs(wy - cy), MATRIX_HEIGHT / 2)]];
         leds[ledMatrix.XY(x, wy)] = color;
 
         // Отражённая волна
@@ -429,80 +540,524 @@ void SoundAnimator::renderWave(CRGB color) {
         my = constrain(my, 0, MATRIX_HEIGHT - 1);
         leds[ledMatrix.XY(x, my)] = color;
     }
+}
 
-    // Обновляем матрицу
-    ledMatrix.update();
+// Под темп волна делает 1, 2, 4 или 8 пол-оборотов за долю — ближайшее
+// к скорости шага phaseStep. Волна с отражением повторяется через пол-оборота
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::configureWaveBeat(uint32_t beatPeriodUs, angle16_t phaseStep) {
+    waveBeatPeriodUs = beatPeriodUs;
+    waveBeatStep = phaseStep;
+    // Пол-оборотов за долю в единицах 1 / (32768 * 10^6); выбор по среднему
+    // геометрическому соседних вариантов, граница — sqrt(2) в тех же единицах
+    constexpr uint64_t SQRT2_HALF_TURN = 46340950012ULL;
+    uint64_t halfTurnsPerBeat = (uint64_t)phaseStep * REFERENCE_FRAME_RATE * beatPeriodUs;
+    uint32_t halfTurns = 1;
+    while (halfTurns < 8 && halfTurns * SQRT2_HALF_TURN < halfTurnsPerBeat) {
+        halfTurns *= 2;
+    }
+    waveBeatRate = (uint32_t)(((uint64_t)halfTurns << 31) / beatPeriodUs);
+}
+
+// Водопад: новый снимок сверху, старые стекают вниз. Строка экрана показывает
+// максимум по своему отрезку истории, поэтому глубина истории может не
+// совпадать с высотой матрицы.
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::renderSpectrogram(const ColorTable& colors, const FixedOverrides& overrides) {
+    // История хранит кадры анализа как есть, без смешивания
+    const AnalysisFrame& frame = frameBlender.getLatest();
+    if (frame.sequence != historySequence) {
+        historySequence = frame.sequence;
+        spectrumHistory.push(frame.smoothedBands, frame.peakLevel);
+    }
+
+    CRGB* leds = ledMatrix.getLeds();
+    for (int y = 0; y < MATRIX_HEIGHT; y++) {
+        uint16_t firstAge = y * SpectrumHistory::DEPTH / MATRIX_HEIGHT;
+        uint16_t lastAge = std::max<uint16_t>((y + 1) * SpectrumHistory::DEPTH / MATRIX_HEIGHT, firstAge + 1);
+        q8_t levels[MATRIX_WIDTH] = {};
+        for (uint16_t age = firstAge; age < lastAge; age++) {
+            spectrumHistory.accumulateMax(age, levels);
+        }
+        for (int x = 0; x < MATRIX_WIDTH; x++) {
+            // Переопределённая чувствительность умножает уровень, история не меняется
+            if (overrides.sensitivity) {
+                levels[x] = std::min<int32_t>(q16Mul(levels[x], overrides.sensitivity), 255);
+            }
+            // Цвет по уровню из таблицы и яркость по нему же: тишина — чёрная
+            CRGB color = colors[levels[x]];
+            color.nscale8(levels[x]);
+            leds[ledMatrix.XY(x, y)] = color;
+        }
+    }
+}
+
+template <typename Analyzer>
+q8_t BasicSoundAnimator<Analyzer>::energyLevel(const AnalysisFrame& frame, q16_t sensitivity) {
+    q16_t amplified = q16Mul(frame.logEnergyQ16, sensitivity);
+
+    // Диапазон из статистики сигнала, приведённый к разумным границам
+    q16_t minLogPower = constrain(frame.minLogPowerQ16, q16FromInt(1), q16FromInt(50));
+    q16_t maxLogPower = constrain(frame.maxLogPowerQ16, minLogPower + Q16_ONE, q16FromInt(100));
+
+    if (amplified <= minLogPower) return 0;
+    if (amplified >= maxLogPower) return 255;
+    // Диапазон не больше 100 дБ, произведение помещается в 32 бита
+    return (uint32_t)(amplified - minLogPower) * 255 / (uint32_t)(maxLogPower - minLogPower);
+}
+
+template <typename Analyzer>
+typename BasicSoundAnimator<Analyzer>::FixedOverrides BasicSoundAnimator<Analyzer>::toFixed(const AnimationOverrides& overrides) {
+    FixedOverrides fixed;
+    fixed.sensitivity = overrides.sensitivity > 0.0f ? q16FromFloat(overrides.sensitivity) : 0;
+    fixed.waveFrequency = overrides.waveFrequency > 0.0f ? angleFromRadians(overrides.waveFrequency) : 0;
+    fixed.wavePhaseIncrement = overrides.wavePhaseIncrement > 0.0f ? angleFromRadians(overrides.wavePhaseIncrement) : 0;
+    fixed.maxStars = overrides.maxStars;
+    fixed.rectangleMinSize = overrides.rectangleMinSize;
+    return fixed;
+}
+
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::updateFixedSettings() {
+    pulsingRectangleSensitivityQ16 = q16FromFloat(pulsingRectangleSensitivity);
+    starrySkySensitivityQ16 = q16FromFloat(starrySkySensitivity);
+    waveSensitivityQ16 = q16FromFloat(waveSensitivity);
+    wavePhaseStep = angleFromRadians(wavePhaseIncrement);
+    waveColumnStep = angleFromRadians(waveFrequency);
 }
 
 // ======================
 // Универсальный селектор анимации
 // ======================
-void SoundAnimator::setAnimation(AnimationType type, CRGB color) {
-    isAnimating = true;
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setAnimation(AnimationType type, CRGB color) {
+    // Занятый слот (прошлое переключение ещё не забрано) не гасит текущую
+    // анимацию: prepareAnimation() пишет в лог, отрисовка идёт как шла
+    if (prepareAnimation(type, color)) {
+        commitAnimation();
+        isAnimating = true;
+    }
+}
+
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::setAnimation(AnimationType type, const Palette& palette) {
+    // Занятый слот (прошлое переключение ещё не забрано) не гасит текущую
+    // анимацию: prepareAnimation() пишет в лог, отрисовка идёт как шла
+    if (prepareAnimation(type, palette)) {
+        commitAnimation();
+        isAnimating = true;
+    }
+}
+
+template <typename Analyzer>
+bool BasicSoundAnimator<Analyzer>::prepareAnimation(AnimationType type, CRGB color, const AnimationOverrides& overrides) {
+    return prepareAnimation(type, color == CRGB(CRGB::Black) ? palettes::RAINBOW : Palette::solid(color), overrides);
+}
+
+// Замыкание следующей анимации строится здесь, вне задачи анимации,
+// чтобы первый кадр после переключения не платил за выделение памяти
+template <typename Analyzer>
+bool BasicSoundAnimator<Analyzer>::prepareAnimation(AnimationType type, const Palette& palette, const AnimationOverrides& overrides) {
+    // Пока задача не забрала прошлую анимацию, слот занят
+    if (switchPending && animationTask.isRunning()) {
+        LOG(AnimatorSwitchPending);
+        return false;
+    }
+    FixedOverrides fixed = toFixed(overrides);
+    const ColorTable* colors = pendingColors;
     switch (type) {
         case AnimationType::ColorAmplitude:
-            currentRenderMethod = [this, color]() { renderColorAmplitude(color); };
+            pendingRenderMethod = [this, colors, fixed]() { renderColorAmplitude(*colors, fixed); };
             break;
         case AnimationType::PulsingRectangle:
-            currentRenderMethod = [this, color]() { renderPulsingRectangle(color); };
+            pendingRenderMethod = [this, colors, fixed]() { renderPulsingRectangle(*colors, fixed); };
             break;
         case AnimationType::StarrySky:
-            currentRenderMethod = [this, color]() { renderStarrySky(color); };
+            pendingRenderMethod = [this, colors, fixed]() { renderStarrySky(*colors, fixed); };
             break;
         case AnimationType::Wave:
-            currentRenderMethod = [this, color]() { renderWave(color); };
+            pendingRenderMethod = [this, colors, fixed]() { renderWave(*colors, fixed); };
             break;
-        default:
-            Serial.println("[SoundAnimator] Unsupported animation type!");
-            currentRenderMethod = nullptr;
-            isAnimating = false;
+        case AnimationType::Spectrogram:
+            pendingRenderMethod = [this, colors, fixed]() { renderSpectrogram(*colors, fixed); };
             break;
+        default:
+            LOG(AnimatorBadType);
+            pendingRenderMethod = nullptr;
+            return false;
+    }
+    // Слот подготовленной анимации задача не читает, запекать можно здесь
+    pendingColors->bake(palette, colorBrightness);
+    return true;
+}
+
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::commitAnimation() {
+    if (pendingRenderMethod) {
+        switchPending = true;
+        animationTask.wake(); // В простое задача спит до пробуждения
     }
 }
 
+template <typename Analyzer>
+const char* BasicSoundAnimator<Analyzer>::getAnimationName(AnimationType type) {
+    switch (type) {
+        case AnimationType::ColorAmplitude:   return "Color Amplitude";
+        case AnimationType::PulsingRectangle: return "Pulsing Rectangle";
+        case AnimationType::StarrySky:        return "Starry Sky";
+        case AnimationType::Wave:             return "Wave";
+        case AnimationType::Spectrogram:      return "Spectrogram";
+    }
+    return "Unknown";
+}
+
+// Забрать подготовленную анимацию; только в задаче анимации (или без неё)
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::takePendingSwitch() {
+    if (!switchPending) {
+        return;
+    }
+    // Обмен std::function не выделяет память; старое замыкание остаётся
+    // в pendingRenderMethod до следующей подготовки
+    std::swap(currentRenderMethod, pendingRenderMethod);
+    std::swap(currentColors, pendingColors);
+    wavePhase = 0;
+    stars.reset();
+    starSpawnAccumulator = 0;
+    spectrumHistory.reset();
+    switchPending = false;
+}
+
 // Обновление кадра
-void SoundAnimator::update() {
-    if(isAnimating && currentRenderMethod) currentRenderMethod();
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::update() {
+    takePendingSwitch();
+    if (!isAnimating || !currentRenderMethod) return;
+    if (rateSettingsDirty) {
+        applyRateSettings();
+    }
+    currentColors->setBrightness(colorBrightness);
+
+    // Анализ идёт со своей частотой; кадр рисуется по смеси двух последних его кадров.
+    // Бюджет кадра — период отрисовки, поэтому встроенный анализ в него не входит
+    if (inlineAnalysis && !analysisTask.isCreated()) {
+        runAnalysisIfDue();
+    }
+    uint32_t frameStart = micros();
+    frameBlender.update(audioAnalyzer);
+
+    // Отрисовка замеряется отдельно от анализа и передачи кадра
+    TRACE_BEGIN(Render);
+    uint32_t renderStart = ESP.getCycleCount();
+    currentRenderMethod();
+    renderCycles += ESP.getCycleCount() - renderStart;
+    renderFrames++;
+    TRACE_END(Render);
+
+    ledMatrix.update();
+
+    uint32_t frameUs = micros() - frameStart;
+    if (frameUs > qualityGovernor.getFrameBudget()) {
+        TRACE_INSTANT(DeadlineMiss, std::min<uint32_t>(frameUs, 0xFFFF));
+#if TRACE_RECORDER && TRACE_ON_DEADLINE_MISS
+        TraceRecorder::trigger(TraceTrigger::DeadlineMiss);
+#endif
+    }
+    if (qualityGovernor.addFrame(frameUs)) {
+        applyQualityLevel();
+    }
 }
 
-// Задача FreeRTOS
-void SoundAnimator::animationTask(void* param) {
-    SoundAnimator* s = static_cast<SoundAnimator*>(param);
-    while(s->isAnimating) {
-        s->update();
-        vTaskDelay(pdMS_TO_TICKS(UPDATE_INTERVAL));
+// Каждый уровень включает упрощения всех предыдущих
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::applyQualityLevel() {
+    QualityLevel level = qualityGovernor.getLevel();
+    ledMatrix.suppressDithering(level >= QualityLevel::NoDither);
+    particleShift = level >= QualityLevel::FewerParticles ? 1 : 0;
+}
+
+// Вызывается в задаче анализа. Размер FFT меняется со следующего цикла,
+// частота — в начале следующего кадра: от неё зависит смешивание кадров
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::applyAnalysisQuality() {
+    QualityLevel level = analysisGovernor.getLevel();
+    audioAnalyzer.setFftSize(level >= QualityLevel::SmallFft ? Analyzer::FFT_SIZE / 2 : Analyzer::FFT_SIZE);
+    halfRateAnalysis = level >= QualityLevel::HalfAnalysis;
+    rateSettingsDirty = true;
+}
+
+// Всё, что зависит от частот, считается здесь, а не в кадре
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::applyRateSettings() {
+    rateSettingsDirty = false;
+    uint8_t effectiveAnalysisRate = halfRateAnalysis ? std::max(analysisRate / 2, 1) : analysisRate;
+    analysisPeriodUs = 1000000 / effectiveAnalysisRate;
+    frameBlender.configure(renderRate, effectiveAnalysisRate, spectrumBlend);
+    qualityGovernor.setFrameBudget(1000000 / renderRate);
+    analysisGovernor.setFrameBudget(analysisPeriodUs);
+
+    frameTimeScale = ((uint32_t)REFERENCE_FRAME_RATE << 8) / renderRate;
+    // Затухание fadeAmount / 256 за опорный кадр -> за кадр текущей частоты
+    float fade = powf(fadeAmount / 256.0f, (float)REFERENCE_FRAME_RATE / renderRate);
+    starFade = std::min(fade * 256.0f + 0.5f, 255.0f);
+}
+
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::runAnalysisIfDue() {
+    uint32_t now = micros();
+    if ((int32_t)(now - nextAnalysisUs) < 0) {
+        return;
     }
-    s->animationTaskHandle = nullptr;
-    vTaskDelete(nullptr);
+    analyze();
+    // После долгой паузы расписание начинается заново, пропущенное не догоняется
+    nextAnalysisUs = now - nextAnalysisUs >= analysisPeriodUs ? now + analysisPeriodUs : nextAnalysisUs + analysisPeriodUs;
 }
 
-void SoundAnimator::initializeAudioAnalyzer() {
-    audioAnalyzer.begin();
+// Цикл анализа — захват и FFT — должен укладываться в период анализа
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::analyze() {
+    uint32_t start = micros();
+    audioAnalyzer.processAudio();
+    if (analysisGovernor.addFrame(micros() - start)) {
+        applyAnalysisQuality();
+    }
 }
 
-void SoundAnimator::startTask() {
-    if(!animationTaskHandle) {
-        isAnimating = true;
-        xTaskCreatePinnedToCore(animationTask, "AnimTask", 4096, this, 1, &animationTaskHandle, 1);
+template <typename Analyzer>
+uint32_t BasicSoundAnimator<Analyzer>::getRenderCycles() const {
+    return renderFrames ? (uint32_t)(renderCycles / renderFrames) : 0;
+}
+
+template <typename Analyzer>
+uint32_t BasicSoundAnimator<Analyzer>::getRenderTimeUs() const {
+    return getRenderCycles() / ESP.getCpuFreqMHz();
+}
+
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::resetRenderStats() {
+    renderCycles = 0;
+    renderFrames = 0;
+}
+
+// Тело задачи анимации: кадры, пока не придёт команда
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::animationBody(void* param) {
+    BasicSoundAnimator* s = static_cast<BasicSoundAnimator*>(param);
+    TickType_t lastWake = xTaskGetTickCount();
+    while (true) {
+        const TickType_t period = pdMS_TO_TICKS(1000 / s->renderRate);
+        // Клип играет и в тишине: простой ждёт его окончания
+        if (s->audioAnalyzer.isSilent() && !s->ledMatrix.getClipLayer().isActive()) {
+            if (!s->runIdle()) {
+                return;
+            }
+            lastWake = xTaskGetTickCount();
+            continue;
+        }
+        s->update();
+
+        if (!s->animationTask.sleepUntil(lastWake, period)) {
+            return;
+        }
     }
 }
 
-void SoundAnimator::stopTask() {
-    if (animationTaskHandle) {
-        isAnimating = false;
-        unsigned long startTime = millis();
-        while (animationTaskHandle) {
-            vTaskDelay(pdMS_TO_TICKS(10));
-            if (millis() - startTime > 1000) { // Тайм-аут 1 секунда
-                Serial.println("[SoundAnimator] Task stop timeout!");
+// Тело задачи анализа: свой период, независимый от отрисовки. В тишине
+// переходит на редкие пробы, матрицу при этом гасит задача анимации.
+// Конец тишины будит задачу анимации: в простое она спит без таймаута.
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::analysisBody(void* param) {
+    BasicSoundAnimator* s = static_cast<BasicSoundAnimator*>(param);
+    TickType_t lastWake = xTaskGetTickCount();
+    while (true) {
+        bool silent = s->audioAnalyzer.isSilent();
+        bool probe = silent && !s->ledMatrix.getClipLayer().isActive();
+        if (probe) {
+            if (!s->idleDelay(s->analysisTask)) {
+                return;
+            }
+            s->audioAnalyzer.processAudio();
+        } else {
+            s->analyze();
+        }
+        // Пробуждение запоминается, даже если задача анимации ещё не уснула
+        if (silent && !s->audioAnalyzer.isSilent()) {
+            s->animationTask.wake();
+        }
+
+        const TickType_t period = pdMS_TO_TICKS(s->analysisPeriodUs / 1000);
+        if (probe) {
+            lastWake = xTaskGetTickCount();
+        } else if (!s->analysisTask.sleepUntil(lastWake, period)) {
+            return;
+        }
+    }
+}
+
+// Простой: гасим матрицу один раз и ждём, пока держится тишина. Пробы делает
+// задача анализа и будит эту, когда услышит звук; без неё пробы здесь.
+// После выхода цикл задачи сразу отрисует следующий кадр.
+template <typename Analyzer>
+bool BasicSoundAnimator<Analyzer>::runIdle() {
+    isIdle = true;
+    LOG(AnimatorIdle);
+    ledMatrix.off();
+
+    while (true) {
+        // В простое update() не вызывается: переключение забирается здесь,
+        // иначе слот остаётся занятым до конца тишины
+        takePendingSwitch();
+        if (analysisTask.isCreated()) {
+            // Будят звук, новая анимация или клип
+            if (!animationTask.sleep(portMAX_DELAY)) {
+                break;
+            }
+        } else {
+            if (!idleDelay(animationTask)) {
                 break;
             }
+            audioAnalyzer.processAudio();
+        }
+        if (!audioAnalyzer.isSilent() || ledMatrix.getClipLayer().isActive()) {
+            isIdle = false;
+            LOG(AnimatorWake);
+            return true;
         }
-        ledMatrix.clear();
-        ledMatrix.update();
     }
+    isIdle = false; // Команда задаче: матрица уже погашена
+    return false;
+}
+
+// В light sleep спят оба ядра, поэтому команда задаче приходит уже после
+// пробуждения и забирается сразу за ним
+template <typename Analyzer>
+bool BasicSoundAnimator<Analyzer>::idleDelay(ControlledTask& task) {
+#if IDLE_LIGHT_SLEEP
+    Serial.flush();
+    esp_sleep_enable_timer_wakeup((uint64_t)IDLE_PROBE_INTERVAL * 1000);
+    esp_light_sleep_start();
+    TRACE_SYNC(); // Счётчик тактов во сне стоял
+    return task.sleep(0);
+#else
+    return task.sleep(pdMS_TO_TICKS(IDLE_PROBE_INTERVAL));
+#endif
+}
+
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::initializeAudioAnalyzer() {
+    audioAnalyzer.begin();
+}
+
+// Задачи создаются один раз и стоят до startTask(). Без задачи анализа
+// он идёт по расписанию внутри update()
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::createTasks() {
+    analysisTask.create(analysisBody, this);
+    animationTask.create(animationBody, this);
+}
+
+// Команды уходят обеим задачам сразу, подтверждения ждутся после:
+// переход занимает не больше кадра более медленной из них
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::startTask() {
+    switch (animationTask.getState()) {
+        case TaskState::Running:
+            return;
+        case TaskState::Paused:
+            resumeTask();
+            return;
+        case TaskState::Stopped:
+            break;
+    }
+    createTasks(); // Если init() не вызывался
+    isAnimating = true;
+    analysisTask.post(TaskState::Running);
+    animationTask.post(TaskState::Running);
+    analysisTask.wait(TaskState::Running);
+    animationTask.wait(TaskState::Running);
+}
+
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::stopTask() {
+    if (animationTask.getState() == TaskState::Stopped) {
+        return;
+    }
+    isAnimating = false;
+    animationTask.post(TaskState::Stopped);
+    analysisTask.post(TaskState::Stopped);
+    animationTask.wait(TaskState::Stopped);
+    analysisTask.wait(TaskState::Stopped);
+    ledMatrix.clear();
+    ledMatrix.update();
 }
 
-AudioAnalyzer& SoundAnimator::getAudioAnalyzer() {
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::pauseTask() {
+    if (!animationTask.isRunning()) {
+        return;
+    }
+    animationTask.post(TaskState::Paused);
+    analysisTask.post(TaskState::Paused);
+    animationTask.wait(TaskState::Paused);
+    analysisTask.wait(TaskState::Paused);
+}
+
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::resumeTask() {
+    if (animationTask.getState() != TaskState::Paused) {
+        return;
+    }
+    analysisTask.post(TaskState::Running);
+    animationTask.post(TaskState::Running);
+    analysisTask.wait(TaskState::Running);
+    animationTask.wait(TaskState::Running);
+}
+
+template <typename Analyzer>
+Analyzer& BasicSoundAnimator<Analyzer>::getAudioAnalyzer() {
     return audioAnalyzer;
-}
\ No newline at end of file
+}
+
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::showText(const char* text, CRGB color, uint8_t columnsPerSecond) {
+    TextLayer& textLayer = ledMatrix.getTextLayer();
+    textLayer.setColor(color);
+    textLayer.setSpeed(columnsPerSecond);
+    textLayer.setText(text);
+}
+
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::clearText() {
+    ledMatrix.getTextLayer().clear();
+}
+
+template <typename Analyzer>
+bool BasicSoundAnimator<Analyzer>::playClip(const ClipDirectory& clips, const char* name, ClipBlend blend, bool loop) {
+    ClipReader clip;
+    if (!clips.openClip(name, clip)) {
+        return false;
+    }
+    if (!ledMatrix.getClipLayer().play(clip, blend, loop)) {
+        return false;
+    }
+    LOG(AnimatorClip, name, clip.getFrameCount());
+    animationTask.wake(); // Клип играет и в тишине
+    return true;
+}
+
+template <typename Analyzer>
+void BasicSoundAnimator<Analyzer>::stopClip() {
+    ledMatrix.getClipLayer().stop();
+}
+
+template <typename Analyzer>
+TaskHandle_t BasicSoundAnimator<Analyzer>::getTaskHandle() const {
+    return animationTask.getHandle();
+}
+
+// Конфигурации аниматора; анализатор новой конфигурации инстанцируется
+// в audio_analyzer.cpp
+template class BasicSoundAnimator<MatrixAnalyzer>;
+
+static_assert(sizeof(SoundAnimator) <= SOUND_ANIMATOR_RAM_BUDGET,
+              "SoundAnimator exceeds SOUND_ANIMATOR_RAM_BUDGET");
\ No newline at end of file
@@ -3,7 +3,13 @@
 
 #include "led_matrix.hpp"
 #include "audio_analyzer.hpp"
+#include "frame_blender.hpp"
 #include "matrix_task.hpp"
+#include "particle_system.hpp"
+#include "spectrum_history.hpp"
+#include "render_math.hpp"
+#include "quality_governor.hpp"
+#include "palette.hpp"
 #include <Preferences.h>
 #include <functional>
 #include <FastLED.h>
@@ -13,24 +19,78 @@ enum class AnimationType {
     ColorAmplitude,
     PulsingRectangle,
     StarrySky,
-    Wave
+    Wave,
+    Spectrogram
 };
 
+// Переопределения параметров анимации на один показ (в NVS не сохраняются).
+// Нулевое значение — использовать текущую настройку аниматора.
+struct AnimationOverrides {
+    float sensitivity = 0.0f;
+    float waveFrequency = 0.0f;
+    float wavePhaseIncrement = 0.0f;
+    uint8_t maxStars = 0;
+    uint8_t rectangleMinSize = 0;
+};
 
-
-class SoundAnimator : public MatrixTask {
+// Аниматор поверх анализатора конфигурации Analyzer (см. AudioAnalyzer).
+// Анимации рисуют по колонке на полосу: полосы анализатора другой ширины
+// раскладываются по колонкам в FrameBlender. Конфигурации инстанцируются
+// явно в sound_animator.cpp.
+template <typename Analyzer>
+class BasicSoundAnimator : public MatrixTask {
 public:
-    SoundAnimator(LedMatrix& matrix);
-    ~SoundAnimator();
+    BasicSoundAnimator(LedMatrix& matrix);
+    ~BasicSoundAnimator();
 
+    // Цвет CRGB::Black — радужная палитра
     void setAnimation(AnimationType type, CRGB color = CRGB::Green);
+    void setAnimation(AnimationType type, const Palette& palette);
+
+    // Подготовка следующей анимации заранее и переключение на неё.
+    // Переключение выполняет задача анимации в начале следующего кадра.
+    // Таблица цветов новой анимации запекается здесь же, вне кадра.
+    bool prepareAnimation(AnimationType type, CRGB color, const AnimationOverrides& overrides = AnimationOverrides());
+    bool prepareAnimation(AnimationType type, const Palette& palette,
+                          const AnimationOverrides& overrides = AnimationOverrides());
+    void commitAnimation();
+    bool isSwitchPending() const { return switchPending; }
+    static const char* getAnimationName(AnimationType type);
     void update();
     void initializeAudioAnalyzer();
 
+    // Анимация и анализ переходят вместе; задачи создаются в init()
     void startTask() override;
     void stopTask() override;
+    void pauseTask() override;
+    void resumeTask() override;
+    TaskState getTaskState() const override { return animationTask.getState(); }
+
+    Analyzer& getAudioAnalyzer();
+
+    // Бегущая строка поверх текущей анимации
+    void showText(const char* text, CRGB color = CRGB::White, uint8_t columnsPerSecond = DEFAULT_TEXT_SPEED);
+    void clearText();
+
+    // Заранее отрисованный клип поверх текущей анимации; тишина его не гасит
+    bool playClip(const ClipDirectory& clips, const char* name, ClipBlend blend = ClipBlend::Over, bool loop = false);
+    void stopClip();
+    TaskHandle_t getTaskHandle() const; // Хэндл задачи анимации (nullptr, если не создана)
+    TaskHandle_t getAnalysisTaskHandle() const { return analysisTask.getHandle(); }
+    bool isIdleMode() const { return isIdle; } // Матрица погашена из-за тишины
 
-    AudioAnalyzer& getAudioAnalyzer();
+    // Средняя стоимость отрисовки кадра без анализа и передачи
+    uint32_t getRenderCycles() const; // Тактов CPU
+    uint32_t getRenderTimeUs() const; // мкс
+    uint32_t getRenderFrames() const { return renderFrames; }
+    void resetRenderStats();
+
+    // Уровень качества, выбранный регулятором по времени кадра
+    QualityLevel getQualityLevel() const { return qualityGovernor.getLevel(); }
+    uint32_t getAverageFrameUs() const { return qualityGovernor.getAverageFrameUs(); }
+    // Уровень качества анализа по времени цикла анализа (захват и FFT)
+    QualityLevel getAnalysisQualityLevel() const { return analysisGovernor.getLevel(); }
+    uint32_t getAverageAnalysisUs() const { return analysisGovernor.getAverageFrameUs(); }
 
     // Параметры анимаций (сеттеры)
     void setColorAmplitudeSensitivity(float value);
@@ -44,18 +104,35 @@ public:
     void setWavePhaseIncrement(float value);
     void setWaveFrequency(float value);
     void setRectangleMinSize(uint8_t value);
+    void setColorBrightness(uint8_t value); // Яркость палитры анимаций
+
+    // Частоты отрисовки и анализа, Гц. Анализ идёт в своей задаче, отрисовка
+    // между его кадрами смешивает два последних кадра анализа (см. FrameBlender).
+    // Покадровые параметры анимаций подобраны под REFERENCE_FRAME_RATE
+    // и пересчитываются под частоту отрисовки.
+    void setFrameRates(uint8_t renderRate, uint8_t analysisRate);
+    void setSpectrumBlend(SpectrumBlend mode);
+    uint8_t getRenderRate() const { return renderRate; }
+    uint8_t getAnalysisRate() const { return analysisRate; }
+    uint32_t getAnalysisPeriodUs() const { return analysisPeriodUs; } // С учётом регулятора анализа
+
+    // Анализ по расписанию частоты анализа, если он не вынесен в свою задачу
+    // (хост, задача не создана). update() вызывает его сам, пока вызывающий
+    // не взял анализ на себя через setInlineAnalysis(false).
+    void runAnalysisIfDue();
+    void setInlineAnalysis(bool enabled) { inlineAnalysis = enabled; }
 
     // Сброс и перезагрузка параметров
     void resetSettings();
 
     /**
-     * Инициализирует настройки и загружает их из NVS.
+     * Инициализирует настройки, загружает их из NVS и создаёт задачи анимации и анализа.
      */
     void init();
 
 private:
     LedMatrix& ledMatrix;
-    AudioAnalyzer audioAnalyzer;
+    Analyzer audioAnalyzer;
 
     Preferences preferences;
 
@@ -63,19 +140,92 @@ private:
     bool isAnimating = false;
 
     AnimationType currentAnimation = AnimationType::ColorAmplitude;
-    CRGB currentColor = CRGB::Green;
+
+    // Таблицы цветов текущей и подготовленной анимации; меняются местами
+    // вместе с замыканиями отрисовки
+    ColorTable colorTables[2];
+    ColorTable* currentColors = &colorTables[0];
+    ColorTable* pendingColors = &colorTables[1];
 
     std::function<void()> currentRenderMethod = nullptr;
+    std::function<void()> pendingRenderMethod = nullptr; // Подготовленная следующая анимация
+    volatile bool switchPending = false;
+    void takePendingSwitch();
+    angle16_t wavePhase = 0;
+
+    // Волна под темп: скорость вращения фазы для последнего периода доли и шага
+    uint32_t waveBeatPeriodUs = 0;
+    angle16_t waveBeatStep = 0;
+    uint32_t waveBeatRate = 0;   // Угол за микросекунду, 16.16
+    uint32_t waveLastUs = 0;
+    void configureWaveBeat(uint32_t beatPeriodUs, angle16_t phaseStep);
 
-    // FreeRTOS задача
-    static void animationTask(void* param);
-    TaskHandle_t animationTaskHandle = nullptr;
+    // Звёзды звёздного неба
+    ParticleSystem stars;
+    uint16_t starSpawnAccumulator = 0; // Дробная часть появившихся звёзд, 8.8
 
-    // Отрисовка анимаций
-    void renderColorAmplitude(CRGB color);
-    void renderPulsingRectangle(CRGB color);
-    void renderStarrySky(CRGB color);
-    void renderWave(CRGB color);
+    // История спектра спектрограммы: снимок на каждый новый кадр анализа
+    SpectrumHistory spectrumHistory;
+    uint32_t historySequence = 0;
+
+    // Регуляторы качества и упрощения их уровней. Отрисовка и анализ идут
+    // в разных задачах, поэтому каждый регулятор меряет свою задачу и
+    // управляет только её упрощениями.
+    QualityGovernor qualityGovernor;  // Кадр отрисовки: дизеринг и частицы
+    QualityGovernor analysisGovernor; // Цикл анализа: частота анализа и размер FFT
+    uint8_t particleShift = 0;      // Лимит звёзд делится на 2^particleShift
+    volatile bool halfRateAnalysis = false; // Анализ с половинной частотой
+    void applyQualityLevel();
+    void applyAnalysisQuality();
+    void analyze(); // Цикл анализа с замером для регулятора анализа
+
+    // Кадр отрисовки между кадрами анализа и расписание анализа
+    FrameBlender frameBlender;
+    volatile uint32_t analysisPeriodUs = 1000000 / ANALYSIS_RATE;
+    uint32_t nextAnalysisUs = 0;
+    volatile bool rateSettingsDirty = true; // Частоты изменились: пересчёт в начале кадра
+    bool inlineAnalysis = true;     // Без задачи анализа update() анализирует сам
+    uint16_t frameTimeScale = 256;  // REFERENCE_FRAME_RATE / renderRate, 8.8
+    uint8_t starFade = 0;           // fadeAmount, пересчитанный на кадр текущей частоты
+    void applyRateSettings();
+
+    // Накопленная стоимость отрисовки в тактах CPU
+    uint64_t renderCycles = 0;
+    uint32_t renderFrames = 0;
+
+    // FreeRTOS задачи: отрисовка на ядре 1, анализ на ANALYSIS_TASK_CORE
+    ControlledTask animationTask;
+    ControlledTask analysisTask;
+    static void animationBody(void* param);
+    static void analysisBody(void* param);
+    void createTasks();
+
+    // Простой при тишине: матрица гасится, анализ идёт с пониженной частотой.
+    // false — задаче пришла команда остановки или паузы
+    bool isIdle = false;
+    bool runIdle();
+    bool idleDelay(ControlledTask& task); // Пауза между пробами звука в простое
+
+    // Переопределения в фиксированной точке: переводятся один раз
+    // при подготовке анимации, а не в каждом кадре
+    struct FixedOverrides {
+        q16_t sensitivity;
+        angle16_t waveFrequency;      // Шаг угла на колонку
+        angle16_t wavePhaseIncrement; // Шаг угла за кадр
+        uint8_t maxStars;
+        uint8_t rectangleMinSize;
+    };
+    static FixedOverrides toFixed(const AnimationOverrides& overrides);
+
+    // Громкость кадра с учётом чувствительности как доля динамического диапазона
+    static q8_t energyLevel(const AnalysisFrame& frame, q16_t sensitivity);
+
+    // Отрисовка анимаций (только целочисленная)
+    void renderColorAmplitude(const ColorTable& colors, const FixedOverrides& overrides);
+    void renderPulsingRectangle(const ColorTable& colors, const FixedOverrides& overrides);
+    void renderStarrySky(const ColorTable& colors, const FixedOverrides& overrides);
+    void renderWave(const ColorTable& colors, const FixedOverrides& overrides);
+    void renderSpectrogram(const ColorTable& colors, const FixedOverrides& overrides);
 
     // Загрузка и сохранение параметров
     void loadSettings();
@@ -94,6 +244,21 @@ private:
     float wavePhaseIncrement;
     float waveFrequency;
     uint8_t rectangleMinSize;
+    uint8_t colorBrightness;
+    uint8_t renderRate;
+    uint8_t analysisRate;
+    SpectrumBlend spectrumBlend;
+
+    // Копии параметров для отрисовки, обновляются при их изменении
+    q16_t pulsingRectangleSensitivityQ16;
+    q16_t starrySkySensitivityQ16;
+    q16_t waveSensitivityQ16;
+    angle16_t wavePhaseStep;
+    angle16_t waveColumnStep;
+    void updateFixedSettings();
 };
 
+// Аниматор устройства
+typedef BasicSoundAnimator<MatrixAnalyzer> SoundAnimator;
+
 #endif // SOUND_ANIMATOR_HPP
\ No newline at end of file
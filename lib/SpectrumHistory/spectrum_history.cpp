@@ -0,0 +1,54 @@
+#include "spectrum_history.hpp"
+#include <string.h>
+
+// Уровень квантования в долю 0..255
+constexpr auto LEVEL_EXPAND = makeScaleTable<SpectrumHistory::MAX_LEVEL + 1>(255);
+
+void SpectrumHistory::reset() {
+    memset(rows, 0, sizeof(rows));
+    head = 0;
+    count = 0;
+}
+
+void SpectrumHistory::push(const uint16_t* bands, uint16_t peak) {
+    uint8_t* row = rows[head];
+    memset(row, 0, ROW_BYTES);
+    if (peak) {
+        for (int x = 0; x < MATRIX_WIDTH; x++) {
+            // Округление до ближайшего уровня; выше пика — насыщение
+            uint32_t value = ((uint32_t)bands[x] * MAX_LEVEL + peak / 2) / peak;
+            uint8_t quantized = value < MAX_LEVEL ? value : MAX_LEVEL;
+            row[x / PER_BYTE] |= quantized << (x % PER_BYTE * BITS);
+        }
+    }
+    head = head + 1 < DEPTH ? head + 1 : 0;
+    if (count < DEPTH) {
+        count++;
+    }
+}
+
+q8_t SpectrumHistory::level(uint16_t age, int x) const {
+    if (age >= count) {
+        return 0;
+    }
+    uint16_t index = head > age ? head - 1 - age : head + DEPTH - 1 - age;
+    uint8_t packed = rows[index][x / PER_BYTE] >> (x % PER_BYTE * BITS);
+    return LEVEL_EXPAND[packed & MAX_LEVEL];
+}
+
+void SpectrumHistory::accumulateMax(uint16_t age, q8_t* levels) const {
+    if (age >= count) {
+        return;
+    }
+    const uint8_t* row = rows[head > age ? head - 1 - age : head + DEPTH - 1 - age];
+    int x = 0;
+    for (uint16_t i = 0; i < ROW_BYTES; i++) {
+        uint8_t packed = row[i];
+        for (uint8_t k = 0; k < PER_BYTE && x < MATRIX_WIDTH; k++, x++, packed >>= BITS) {
+            q8_t value = LEVEL_EXPAND[packed & MAX_LEVEL];
+            if (value > levels[x]) {
+                levels[x] = value;
+            }
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef SPECTRUM_HISTORY_HPP
+#define SPECTRUM_HISTORY_HPP
+
+#include <stdint.h>
+#include "config.hpp"
+#include "render_math.hpp"
+
+// История спектра для спектрограммы: кольцо из DEPTH снимков полос,
+// каждая полоса квантуется до BITS бит и упаковывается в байт.
+// Новый снимок пишется на место самого старого и сдвигает голову кольца;
+// прокрутка — это только смена головы, строки не копируются.
+// Память: DEPTH * ROW_BYTES байт и не зависит от высоты матрицы.
+class SpectrumHistory {
+public:
+    static constexpr uint16_t DEPTH = SPECTRUM_HISTORY_DEPTH;
+    static constexpr uint8_t BITS = SPECTRUM_HISTORY_BITS;
+    static constexpr uint8_t MAX_LEVEL = (1 << BITS) - 1;
+    static constexpr uint8_t PER_BYTE = 8 / BITS;
+    static constexpr uint16_t ROW_BYTES = (MATRIX_WIDTH + PER_BYTE - 1) / PER_BYTE;
+
+    static_assert(BITS == 1 || BITS == 2 || BITS == 4 || BITS == 8, "SPECTRUM_HISTORY_BITS: 1, 2, 4 or 8");
+    static_assert(DEPTH >= 1, "SPECTRUM_HISTORY_DEPTH must be positive");
+
+    void reset();
+
+    // Добавить снимок: полосы в долях от peak (peak = 0 — пустая строка)
+    void push(const uint16_t* bands, uint16_t peak);
+
+    // Уровень полосы x в снимке возраста age (0 — самый новый), 0..255.
+    // Снимки старше getCount() пустые.
+    q8_t level(uint16_t age, int x) const;
+
+    // Поднять levels[0..MATRIX_WIDTH) до уровней снимка age: строка
+    // распаковывается целиком, без поиска снимка на каждую полосу
+    void accumulateMax(uint16_t age, q8_t* levels) const;
+
+    uint16_t getCount() const { return count; }
+
+private:
+    uint8_t rows[DEPTH][ROW_BYTES];
+    uint16_t head = 0;  // Строка для следующего снимка
+    uint16_t count = 0; // Сколько строк уже заполнено
+};
+
+#endif // SPECTRUM_HISTORY_HPP
@@ -0,0 +1,130 @@
+#include "controlled_task.hpp"
+#include "deferred_log.hpp"
+#include "trace_recorder.hpp"
+
+ControlledTask::ControlledTask(const char* name, uint32_t stackSize, UBaseType_t priority, BaseType_t core)
+    : name(name), stackSize(stackSize), priority(priority), core(core) {
+}
+
+ControlledTask::~ControlledTask() {
+    if (taskHandle) {
+        request(TaskState::Stopped);
+        vTaskDelete(taskHandle);
+    }
+    if (acks) {
+        vEventGroupDelete(acks);
+    }
+}
+
+bool ControlledTask::create(Body taskBody, void* taskOwner) {
+    if (taskHandle) {
+        return true;
+    }
+    body = taskBody;
+    owner = taskOwner;
+    if (!acks) {
+        acks = xEventGroupCreate();
+    }
+    if (!acks || xTaskCreatePinnedToCore(entry, name, stackSize, this, priority, &taskHandle, core) != pdPASS) {
+        taskHandle = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void ControlledTask::post(TaskState target) {
+    if (!taskHandle) {
+        state = target;
+        return;
+    }
+    xEventGroupClearBits(acks, ackBit(target));
+    xTaskNotify(taskHandle, (uint32_t)target, eSetValueWithOverwrite);
+}
+
+void ControlledTask::wake() {
+    if (taskHandle) {
+        xTaskNotify(taskHandle, WAKE, eSetValueWithoutOverwrite);
+    }
+}
+
+bool ControlledTask::wait(TaskState target) {
+    if (!taskHandle) {
+        return true;
+    }
+    EventBits_t bits = xEventGroupWaitBits(acks, ackBit(target), pdFALSE, pdTRUE, pdMS_TO_TICKS(TASK_COMMAND_TIMEOUT));
+    if (bits & ackBit(target)) {
+        return true;
+    }
+    LOG(TaskCommandTimeout, name, getStateName(target));
+    return false;
+}
+
+const char* ControlledTask::getStateName(TaskState state) {
+    switch (state) {
+        case TaskState::Stopped: return "Stopped";
+        case TaskState::Running: return "Running";
+        case TaskState::Paused:  return "Paused";
+    }
+    return "Unknown";
+}
+
+bool ControlledTask::sleep(TickType_t ticks) {
+    if (!taskHandle) {
+        vTaskDelay(ticks);
+        return isRunning();
+    }
+    // Проверка без ожидания в трассу не пишется, иначе она вытеснит кадры
+    uint32_t command;
+    if (ticks) {
+        TRACE_BEGIN(Wait);
+    }
+    BaseType_t notified = xTaskNotifyWait(0, UINT32_MAX, &command, ticks);
+    if (ticks) {
+        TRACE_END(Wait);
+    }
+    if (notified != pdTRUE || command == WAKE) {
+        return true;
+    }
+    if ((TaskState)command == TaskState::Running) {
+        acknowledge(TaskState::Running); // Уже работает: только подтвердить
+        return true;
+    }
+    pending = (TaskState)command;
+    return false;
+}
+
+bool ControlledTask::sleepUntil(TickType_t& lastWake, TickType_t period) {
+    TickType_t now = xTaskGetTickCount();
+    if (now - lastWake >= period) {
+        lastWake = now;
+        return sleep(1); // Отдать ядро задачам пониже
+    }
+    lastWake += period;
+    return sleep(lastWake - now);
+}
+
+void ControlledTask::acknowledge(TaskState reached) {
+    state = reached;
+    xEventGroupSetBits(acks, ackBit(reached));
+}
+
+// Подтверждение остановки или паузы ставится только после выхода из тела:
+// после него задача не трогает ни матрицу, ни данные владельца
+void ControlledTask::entry(void* param) {
+    ControlledTask* task = static_cast<ControlledTask*>(param);
+    while (true) {
+        if (task->state == TaskState::Running) {
+            task->body(task->owner);
+            if (task->pending != TaskState::Running) {
+                task->acknowledge(task->pending);
+                task->pending = TaskState::Running;
+            }
+            continue;
+        }
+        uint32_t command;
+        xTaskNotifyWait(0, UINT32_MAX, &command, portMAX_DELAY);
+        if (command != WAKE) { // Пробуждение, опоздавшее к остановке
+            task->acknowledge((TaskState)command);
+        }
+    }
+}
@@ -0,0 +1,78 @@
+#ifndef CONTROLLED_TASK_HPP
+#define CONTROLLED_TASK_HPP
+
+#include <Arduino.h>
+#include <freertos/event_groups.h>
+#include "config.hpp"
+
+// Состояние задачи матрицы
+enum class TaskState : uint8_t {
+    Stopped, // Задача стоит, состояние сброшено
+    Running,
+    Paused   // Задача стоит, состояние и кадр на матрице сохранены
+};
+
+// Постоянная задача FreeRTOS, которой управляют командами.
+// Задача создаётся один раз и между запусками стоит в ожидании уведомления,
+// поэтому переходы не создают и не удаляют задач. Команда — прямое уведомление
+// задачи (новое значение затирает старое), подтверждение — бит группы событий:
+// управляющий ждёт его, а не опрашивает флаг.
+// Тело задачи работает, пока sleep()/sleepUntil() не вернёт false, и ждёт
+// только через них: команда будит задачу сразу, а если пришла посреди
+// кадра — забирается в конце кадра. Поэтому любой переход занимает
+// не больше одного кадра.
+// Управлять задачей следует из одного места (setup, loop или одна задача).
+// Без задачи (хост, нет памяти) команды только меняют состояние,
+// а кадры крутит сам вызывающий.
+class ControlledTask {
+public:
+    typedef void (*Body)(void* owner);
+
+    ControlledTask(const char* name, uint32_t stackSize, UBaseType_t priority, BaseType_t core);
+    ~ControlledTask();
+
+    // Создать задачу в состоянии Stopped. false — задачи нет, кадры крутит вызывающий
+    bool create(Body body, void* owner);
+    bool isCreated() const { return taskHandle != nullptr; }
+
+    // Команда без ожидания: несколько задач переходят одновременно
+    void post(TaskState target);
+    // Дождаться подтверждения; false — тайм-аут TASK_COMMAND_TIMEOUT
+    bool wait(TaskState target);
+    bool request(TaskState target) { post(target); return wait(target); }
+    // Разбудить задачу из sleep() без команды (из другой задачи). Команду
+    // не затирает, а пришедшая позже затирает пробуждение
+    void wake();
+
+    TaskState getState() const { return state; }
+    bool isRunning() const { return state == TaskState::Running; }
+    TaskHandle_t getHandle() const { return taskHandle; }
+    const char* getName() const { return name; }
+    static const char* getStateName(TaskState state);
+
+    // Только из тела задачи. Ждать не дольше ticks или до wake(); false —
+    // пришла команда остановки или паузы, тело должно сразу вернуться
+    bool sleep(TickType_t ticks);
+    // Период от начала кадра. После перегрузки пропущенные кадры не догоняются
+    bool sleepUntil(TickType_t& lastWake, TickType_t period);
+
+private:
+    const char* name;
+    uint32_t stackSize;
+    UBaseType_t priority;
+    BaseType_t core;
+    Body body = nullptr;
+    void* owner = nullptr;
+
+    TaskHandle_t taskHandle = nullptr;
+    EventGroupHandle_t acks = nullptr; // Бит на состояние, ставит задача
+    volatile TaskState state = TaskState::Stopped;
+    TaskState pending = TaskState::Running; // Команда, принятая внутри тела
+
+    static const uint32_t WAKE = 0xFF; // Значение уведомления, не команда
+    static EventBits_t ackBit(TaskState state) { return 1u << (uint8_t)state; }
+    void acknowledge(TaskState reached);
+    static void entry(void* param);
+};
+
+#endif // CONTROLLED_TASK_HPP
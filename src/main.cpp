@@ -2,27 +2,85 @@
 #include "audio_analyzer.hpp"
 #include "led_matrix.hpp"
 #include "sound_animator.hpp"
+#include "playlist.hpp"
+#include "clip_storage.hpp"
+#include "frame_ingest.hpp"
+#include "memory_report.hpp"
+#include "deferred_log.hpp"
+#include "trace_recorder.hpp"
+#include "latency_benchmark.hpp"
 #include "config.hpp" // Подключаем файл конфигурации
 #include <nvs_flash.h>
 
 // Создаём объекты
 LedMatrix ledMatrix;
 SoundAnimator soundAnimator(ledMatrix); 
+#if FRAME_INGEST
+FrameIngest frameIngest(ledMatrix); // Кадры от внешнего контроллера по UART
+MatrixTask* currentMatrixTask = &frameIngest; // Указатель на задачу матрицы
+#else
 MatrixTask* currentMatrixTask = &soundAnimator; // Указатель на задачу матрицы
+#endif
+Playlist playlist(soundAnimator);
+ClipStorage clipStorage; // Клипы из раздела flash: soundAnimator.playClip(clipStorage.getDirectory(), "имя")
+#if LATENCY_BENCHMARK
+LatencyBenchmark latencyBenchmark(soundAnimator);
+#endif
+
+// Плейлист: анимация, цвет, длительность (мс) и переопределения параметров
+const PlaylistEntry playlistEntries[] = {
+    { AnimationType::StarrySky,        CRGB::Green,   60 * 1000, { 0.8f, 0.0f, 0.0f, 50 } },
+    { AnimationType::PulsingRectangle, CRGB::Magenta, 60 * 1000, { 0.9f } },
+    { AnimationType::ColorAmplitude,   CRGB::Black,   60 * 1000, {} },
+    { AnimationType::Wave,             CRGB::Cyan,    60 * 1000, { 1.0f, 0.3f, 0.1f } },
+    { AnimationType::StarrySky,        CRGB::Purple,  30 * 1000, { 1.2f, 0.0f, 0.0f, 80 } },
+    { AnimationType::Wave,             CRGB::Orange,  30 * 1000, { 1.5f, 0.6f, 0.2f } },
+    { AnimationType::ColorAmplitude,   CRGB::Black,   30 * 1000, {}, &palettes::HEAT },
+    { AnimationType::StarrySky,        CRGB::Black,   30 * 1000, { 1.0f, 0.0f, 0.0f, 60 }, &palettes::FIRE },
+    { AnimationType::Spectrogram,      CRGB::Black,   60 * 1000, {}, &palettes::HEAT },
+};
 
-// Переменные для управления анимацией
-unsigned long lastAnimationChangeTime = 0; // Время последнего переключения анимации
-const unsigned long animationInterval = 60 * 1000; // Интервал в 1 минуту
-int currentAnimationIndex = 0; // Индекс текущей анимации
+// Отчёт о памяти: стеки задач, куча и размеры основных объектов
+void printMemoryReport() {
+    MemoryReport::printHeap();
+    MemoryReport::printTask("loopTask", xTaskGetCurrentTaskHandle(), getArduinoLoopTaskStackSize());
+    MemoryReport::printTask("AnimTask", soundAnimator.getTaskHandle(), ANIM_TASK_STACK_SIZE);
+    MemoryReport::printTask("AnalysisTask", soundAnimator.getAnalysisTaskHandle(), ANALYSIS_TASK_STACK_SIZE);
+    MemoryReport::printTask("ShowTask", ledMatrix.getShowTaskHandle(), SHOW_TASK_STACK_SIZE);
+    MemoryReport::printTask("LogTask", DeferredLog::getTaskHandle(), LOG_TASK_STACK_SIZE);
+#if FRAME_INGEST
+    MemoryReport::printTask("IngestTask", frameIngest.getTaskHandle(), INGEST_TASK_STACK_SIZE);
+#endif
+    MemoryReport::printObject("AudioAnalyzer", sizeof(MatrixAnalyzer), AUDIO_ANALYZER_RAM_BUDGET);
+    MemoryReport::printObject("SoundAnimator", sizeof(SoundAnimator), SOUND_ANIMATOR_RAM_BUDGET);
+    MemoryReport::printObject("LedMatrix", sizeof(LedMatrix), LED_MATRIX_RAM_BUDGET);
+}
 
-// Массив доступных цветов
-const CRGB availableColors[] = {
-    CRGB::Red, CRGB::Green, CRGB::Blue, CRGB::Yellow, CRGB::Cyan, CRGB::Magenta, CRGB::Orange, CRGB::Purple, CRGB::White
-};
-const int numColors = sizeof(availableColors) / sizeof(availableColors[0]); // Количество доступных цветов
+// Средняя стоимость отрисовки кадра за интервал отчёта и уровни качества
+void printRenderReport() {
+    Serial.printf("[Render] %u us/frame (%u cycles), %u frames, frame %u us, quality %s, analysis %u us, quality %s\n",
+                  soundAnimator.getRenderTimeUs(), soundAnimator.getRenderCycles(), soundAnimator.getRenderFrames(),
+                  soundAnimator.getAverageFrameUs(), QualityGovernor::getLevelName(soundAnimator.getQualityLevel()),
+                  soundAnimator.getAverageAnalysisUs(),
+                  QualityGovernor::getLevelName(soundAnimator.getAnalysisQualityLevel()));
+    soundAnimator.resetRenderStats();
+}
+
+#if FRAME_INGEST
+// Пропускная способность приёма кадров за интервал отчёта
+void printIngestReport() {
+    IngestStats stats = frameIngest.getStats();
+    uint32_t ms = stats.elapsedMs ? stats.elapsedMs : 1;
+    Serial.printf("[Ingest] %u frames (%u.%u FPS), %u B/s, dropped %u, sync skipped %u bytes\n",
+                  stats.frames, stats.frames * 1000 / ms, stats.frames * 10000 / ms % 10,
+                  (uint32_t)((uint64_t)stats.bytes * 1000 / ms), stats.dropped, stats.syncBytes);
+    frameIngest.resetStats();
+}
+#endif
 
 void setup() {
     Serial.begin(115200);
+    DeferredLog::begin(); // Лог компонентов выводит задача с низким приоритетом
 
     // Инициализация NVS
     esp_err_t err = nvs_flash_init();
@@ -37,6 +95,7 @@ void setup() {
 
     ledMatrix.begin(); // Инициализация матрицы
     ledMatrix.setBrightness(BRIGHTNESS);
+    clipStorage.begin(); // Без раздела или образа клипы просто недоступны
 
    
     // Запускаем анимацию
@@ -46,47 +105,55 @@ void setup() {
     soundAnimator.setWaveSensitivity(1.0f); // Установка чувствительности
     soundAnimator.setStarrySkyMaxStars(50); // Максимальное количество звёзд
     soundAnimator.setStarrySkySensitivity(0.8f); // Чувствительность звёздного неба
-    soundAnimator.setAnimation(AnimationType::StarrySky, CRGB::Green); // Установка начальной анимации
 
 
+#if FRAME_INGEST
+    frameIngest.begin(); // Драйвер UART и задача приёма, стоящая до запуска
+#endif
+
     // Запускаем задачу для анимации
     currentMatrixTask->startTask();
+
+#if LATENCY_BENCHMARK
+    latencyBenchmark.begin();
+#elif FRAME_INGEST
+    // Кадрами управляет внешний контроллер, плейлист не нужен
+#else
+    // Анимации переключает плейлист по программному таймеру
+    playlist.setEntries(playlistEntries, sizeof(playlistEntries) / sizeof(playlistEntries[0]));
+    playlist.start();
+#endif
 }
 
 void loop() {
-
-    // Проверяем, прошло ли 1 минута
-    unsigned long currentTime = millis();
-    if (currentTime - lastAnimationChangeTime >= animationInterval) {
-        lastAnimationChangeTime = currentTime;
-
-
-        // Генерируем случайный цвет из массива
-        CRGB randomColor = availableColors[random(0, numColors)];
-
-        // Переключаем анимацию
-        currentAnimationIndex = (currentAnimationIndex + 1) % 4; // Переключаем между 4 анимациями
-
-        switch (currentAnimationIndex) {
-            case 0:
-                soundAnimator.setAnimation(AnimationType::StarrySky, randomColor); // Звёздное небо
-                Serial.println("Switched to Starry Sky Animation");
-                break;
-            case 1:
-                soundAnimator.setAnimation(AnimationType::PulsingRectangle, randomColor); // Пульсирующий прямоугольник
-                Serial.println("Switched to Pulsing Rectangle Animation");
-                break;
-            case 2:
-                soundAnimator.setAnimation(AnimationType::ColorAmplitude, randomColor); // Амплитуда цвета
-                Serial.println("Switched to Color Amplitude Animation");
-                break;
-            case 3:
-                soundAnimator.setAnimation(AnimationType::Wave, randomColor); // Волна
-                Serial.println("Switched to Wave Animation");
-                break;
+#if LATENCY_BENCHMARK
+    // В режиме бенчмарка анимациями управляет он сам
+    latencyBenchmark.poll();
+    delay(1);
+    return;
+#endif
+
+#if TRACE_RECORDER
+    // Команда 't' по Serial снимает трассу. Замершая трасса выводится здесь,
+    // а не в задаче, которая её записала
+    while (Serial.available()) {
+        if (Serial.read() == 't') {
+            TraceRecorder::trigger(TraceTrigger::Command);
         }
     }
-
-    delay(1000); // Задержка в 1 секунду для предотвращения перегрузки
+    TraceRecorder::dump();
+#endif
+
+    // Всё остальное работает в своих задачах; loop только печатает отчёты
+    static unsigned long nextReport = 0;
+    if ((long)(millis() - nextReport) >= 0) {
+        nextReport = millis() + MEMORY_REPORT_INTERVAL;
+        printMemoryReport();
+#if FRAME_INGEST
+        printIngestReport();
+#else
+        printRenderReport();
+#endif
+    }
+    delay(COMMAND_POLL_INTERVAL);
 }
-
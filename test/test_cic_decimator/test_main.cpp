@@ -0,0 +1,117 @@
+#include <unity.h>
+#include <math.h>
+#include "cic_decimator.hpp"
+
+// Децимация сырых отсчётов АЦП: коэффициенты, прогрев, выход Q4,
+// нули CIC на частоте выхода и плоская полоса после компенсации
+
+static CicDecimator decimator;
+
+void setUp() {
+    decimator = CicDecimator();
+}
+
+void tearDown() {}
+
+// Подать count отсчётов генератора, собрать выходы в out; возвращает их число
+template <typename Source>
+static int run(int count, Source source, int32_t* out = nullptr, int capacity = 0) {
+    int outputs = 0;
+    for (int n = 0; n < count; n++) {
+        int32_t value;
+        if (decimator.push(source(n), value)) {
+            if (out && outputs < capacity) {
+                out[outputs] = value;
+            }
+            outputs++;
+        }
+    }
+    return outputs;
+}
+
+static void test_ratio_must_be_power_of_two_in_range() {
+    TEST_ASSERT_FALSE(decimator.setRatio(2));
+    TEST_ASSERT_FALSE(decimator.setRatio(6));
+    TEST_ASSERT_FALSE(decimator.setRatio(32));
+    TEST_ASSERT_EQUAL(CicDecimator::MIN_RATIO, decimator.getRatio());
+    TEST_ASSERT_TRUE(decimator.setRatio(4));
+    TEST_ASSERT_TRUE(decimator.setRatio(8));
+    TEST_ASSERT_TRUE(decimator.setRatio(16));
+    TEST_ASSERT_EQUAL(16, decimator.getRatio());
+}
+
+// Первые выходы, пока заполняются гребёнки и КИХ, не отдаются
+static void test_warmup_then_one_output_per_ratio() {
+    TEST_ASSERT_TRUE(decimator.setRatio(8));
+    TEST_ASSERT_EQUAL(0, run(8 * 5, [](int) { return 100; }));
+    TEST_ASSERT_EQUAL(10, run(8 * 10, [](int) { return 100; }));
+
+    decimator.reset();
+    TEST_ASSERT_EQUAL(0, run(8 * 5, [](int) { return 100; }));
+}
+
+// Постоянный вход даёт тот же уровень в Q4 при любом коэффициенте, в том числе
+// полная шкала АЦП при переполнении интеграторов
+static void test_dc_gain_is_q4() {
+    static const uint16_t LEVELS[] = {0, 1, 2048, 4095};
+    for (uint8_t ratio = CicDecimator::MIN_RATIO; ratio <= CicDecimator::MAX_RATIO; ratio *= 2) {
+        TEST_ASSERT_TRUE(decimator.setRatio(ratio));
+        for (uint16_t level : LEVELS) {
+            int32_t out[64];
+            int outputs = run(ratio * 4000, [level](int) { return level; }, out, 64);
+            TEST_ASSERT_EQUAL(4000 - 5, outputs);
+            for (int i = 0; i < 64; i++) {
+                TEST_ASSERT_EQUAL_INT32((int32_t)level << CicDecimator::FRACTION_BITS, out[i]);
+            }
+            decimator.reset();
+        }
+    }
+}
+
+static float rms(const int32_t* values, int count) {
+    double mean = 0, power = 0;
+    for (int i = 0; i < count; i++) {
+        mean += values[i];
+    }
+    mean /= count;
+    for (int i = 0; i < count; i++) {
+        power += (values[i] - mean) * (values[i] - mean);
+    }
+    return sqrt(power / count);
+}
+
+// Тон на частоте выхода попадает в нуль CIC и не наложится на постоянную составляющую
+static void test_tone_at_output_rate_is_nulled() {
+    TEST_ASSERT_TRUE(decimator.setRatio(8));
+    int32_t out[256];
+    run(8 * 300, [](int n) { return (uint16_t)lroundf(2048 + 1500 * sinf(2 * (float)M_PI * n / 8 + 0.3f)); }, out, 256);
+    TEST_ASSERT_LESS_OR_EQUAL(1.0f, rms(out, 256));
+}
+
+// После компенсации полоса до fs/4 ровная: ±0.3 дБ
+static void test_passband_is_flat() {
+    const uint8_t ratio = 8;
+    TEST_ASSERT_TRUE(decimator.setRatio(ratio));
+    const float amplitude = 1000;
+    static const int PERIODS[] = {64, 16, 8, 4}; // В отсчётах выхода: fs/64 .. fs/4
+    for (int period : PERIODS) {
+        decimator.reset();
+        int32_t out[512];
+        int outputs = run(ratio * 530, [&](int n) {
+            return (uint16_t)lroundf(2048 + amplitude * sinf(2 * (float)M_PI * n / (ratio * period)));
+        }, out, 512);
+        TEST_ASSERT_EQUAL(525, outputs);
+        float gainDb = 20 * log10f(rms(out, 512) / (amplitude * (1 << CicDecimator::FRACTION_BITS) / sqrtf(2)));
+        TEST_ASSERT_FLOAT_WITHIN(0.3f, 0.0f, gainDb);
+    }
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_ratio_must_be_power_of_two_in_range);
+    RUN_TEST(test_warmup_then_one_output_per_ratio);
+    RUN_TEST(test_dc_gain_is_q4);
+    RUN_TEST(test_tone_at_output_rate_is_nulled);
+    RUN_TEST(test_passband_is_flat);
+    return UNITY_END();
+}
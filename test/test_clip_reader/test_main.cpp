@@ -0,0 +1,239 @@
+#include <unity.h>
+#include <vector>
+#include "clip_reader.hpp"
+
+// Чтение клипов из образа: проверка заголовка и индекса, ключевые и
+// дельта-кадры, переход к кадру, испорченные данные и каталог образа
+
+static constexpr uint32_t FRAME_COUNT = 5;
+static constexpr uint16_t KEYFRAME_INTERVAL = 2; // Ключевые кадры 0, 2, 4
+static constexpr uint8_t TAIL = NUM_LEDS - 64;   // Пиксели после первой полной серии
+
+static_assert(NUM_LEDS > 66 && NUM_LEDS - 2 <= 64 + CLIP_OP_MAX_LENGTH, "Test clip layout expects 66..130 pixels");
+
+static ClipReader reader;
+static CRGB canvas[NUM_LEDS];
+
+template <typename T>
+static void append(std::vector<uint8_t>& data, const T& value) {
+    const uint8_t* bytes = (const uint8_t*)&value;
+    data.insert(data.end(), bytes, bytes + sizeof(value));
+}
+
+static void appendRun(std::vector<uint8_t>& data, uint8_t length, uint8_t r, uint8_t g, uint8_t b) {
+    data.insert(data.end(), {(uint8_t)(CLIP_OP_RUN | (length - 1)), r, g, b});
+}
+
+// Ключевой кадр: два литерала, затем серии цвета кадра.
+// Дельта-кадр: пропуск 64 пикселей и серия цвета кадра в хвосте.
+static std::vector<uint8_t> buildFrame(uint32_t frame) {
+    std::vector<uint8_t> data;
+    if (frame % KEYFRAME_INTERVAL == 0) {
+        data.insert(data.end(), {(uint8_t)(CLIP_OP_LITERAL | 1), 1, 2, 3, 4, 5, 6});
+        appendRun(data, 64, 10 + frame, 0, 0);
+        appendRun(data, NUM_LEDS - 66, 10 + frame, 0, 0);
+    } else {
+        data.push_back(CLIP_OP_SKIP | 63);
+        appendRun(data, TAIL, 10 + frame, 1, 0);
+    }
+    return data;
+}
+
+static std::vector<uint8_t> buildClip(uint32_t frameCount = FRAME_COUNT) {
+    ClipHeader header = {};
+    memcpy(header.magic, CLIP_MAGIC, sizeof(header.magic));
+    header.width = MATRIX_WIDTH;
+    header.height = MATRIX_HEIGHT;
+    header.frameIntervalMs = 40;
+    header.frameCount = frameCount;
+    header.keyframeInterval = KEYFRAME_INTERVAL;
+    header.keyframeCount = (frameCount + KEYFRAME_INTERVAL - 1) / KEYFRAME_INTERVAL;
+
+    std::vector<uint8_t> frames;
+    std::vector<uint32_t> offsets;
+    uint32_t base = sizeof(ClipHeader) + header.keyframeCount * 4;
+    for (uint32_t frame = 0; frame < frameCount; frame++) {
+        if (frame % KEYFRAME_INTERVAL == 0) {
+            offsets.push_back(base + frames.size());
+        }
+        std::vector<uint8_t> data = buildFrame(frame);
+        frames.insert(frames.end(), data.begin(), data.end());
+    }
+
+    std::vector<uint8_t> clip;
+    append(clip, header);
+    for (uint32_t offset : offsets) {
+        append(clip, offset);
+    }
+    clip.insert(clip.end(), frames.begin(), frames.end());
+    return clip;
+}
+
+// Холст после кадра frame, декодированного от его ключевого кадра
+static void assertFrame(uint32_t frame) {
+    uint32_t key = frame - frame % KEYFRAME_INTERVAL;
+    TEST_ASSERT_EQUAL_UINT8(1, canvas[0].r);
+    TEST_ASSERT_EQUAL_UINT8(6, canvas[1].b);
+    TEST_ASSERT_EQUAL_UINT8(10 + key, canvas[2].r);
+    TEST_ASSERT_EQUAL_UINT8(10 + key, canvas[63].r);
+    TEST_ASSERT_EQUAL_UINT8(10 + frame, canvas[64].r);
+    TEST_ASSERT_EQUAL_UINT8(frame == key ? 0 : 1, canvas[64].g);
+    TEST_ASSERT_EQUAL_UINT8(10 + frame, canvas[NUM_LEDS - 1].r);
+}
+
+void setUp() {
+    reader.close();
+    fill_solid(canvas, NUM_LEDS, CRGB(0xEE, 0xEE, 0xEE));
+}
+
+void tearDown() {}
+
+static void test_open_reads_header() {
+    std::vector<uint8_t> clip = buildClip();
+    TEST_ASSERT_TRUE(reader.open(clip.data(), clip.size()));
+    TEST_ASSERT_TRUE(reader.isOpen());
+    TEST_ASSERT_EQUAL_UINT32(FRAME_COUNT, reader.getFrameCount());
+    TEST_ASSERT_EQUAL(40, reader.getFrameIntervalMs());
+    TEST_ASSERT_EQUAL(KEYFRAME_INTERVAL, reader.getKeyframeInterval());
+    TEST_ASSERT_EQUAL_UINT32(0, reader.getNextFrame());
+}
+
+static void test_open_rejects_bad_headers() {
+    std::vector<uint8_t> clip = buildClip();
+    ClipHeader* header = (ClipHeader*)clip.data();
+
+    TEST_ASSERT_FALSE(reader.open(nullptr, clip.size()));
+    TEST_ASSERT_FALSE(reader.open(clip.data(), sizeof(ClipHeader) - 1));
+
+    header->magic[0] = 'X';
+    TEST_ASSERT_FALSE(reader.open(clip.data(), clip.size()));
+    header->magic[0] = CLIP_MAGIC[0];
+
+    header->width++;
+    TEST_ASSERT_FALSE(reader.open(clip.data(), clip.size()));
+    header->width--;
+
+    header->keyframeCount++;
+    TEST_ASSERT_FALSE(reader.open(clip.data(), clip.size()));
+    header->keyframeCount--;
+
+    // Индекс ключевых кадров не помещается в данные
+    TEST_ASSERT_FALSE(reader.open(clip.data(), sizeof(ClipHeader) + 4));
+
+    // Смещение ключевого кадра за концом клипа
+    uint32_t outside = clip.size();
+    memcpy(clip.data() + sizeof(ClipHeader) + 4, &outside, sizeof(outside));
+    TEST_ASSERT_FALSE(reader.open(clip.data(), clip.size()));
+    TEST_ASSERT_FALSE(reader.isOpen());
+}
+
+static void test_decode_sequentially() {
+    std::vector<uint8_t> clip = buildClip();
+    TEST_ASSERT_TRUE(reader.open(clip.data(), clip.size()));
+    for (uint32_t frame = 0; frame < FRAME_COUNT; frame++) {
+        TEST_ASSERT_TRUE(reader.decodeNext(canvas));
+        TEST_ASSERT_EQUAL_UINT32(frame + 1, reader.getNextFrame());
+        assertFrame(frame);
+    }
+    TEST_ASSERT_FALSE(reader.decodeNext(canvas));
+}
+
+// Переход вперёд и назад, внутри группы ключевого кадра и через неё
+static void test_seek() {
+    std::vector<uint8_t> clip = buildClip();
+    TEST_ASSERT_TRUE(reader.open(clip.data(), clip.size()));
+    static const uint32_t TARGETS[] = {3, 1, 2, 3, 0, 4};
+    for (uint32_t frame : TARGETS) {
+        TEST_ASSERT_TRUE(reader.seek(frame, canvas));
+        TEST_ASSERT_EQUAL_UINT32(frame + 1, reader.getNextFrame());
+        assertFrame(frame);
+    }
+    TEST_ASSERT_FALSE(reader.seek(FRAME_COUNT, canvas));
+}
+
+// Оборванный литерал: кадр не проходит все пиксели, чтение останавливается
+static void test_truncated_frame_stops_reading() {
+    std::vector<uint8_t> clip = buildClip(1);
+    clip.resize(clip.size() - buildFrame(0).size() + 4);
+    TEST_ASSERT_TRUE(reader.open(clip.data(), clip.size()));
+    TEST_ASSERT_FALSE(reader.decodeNext(canvas));
+    TEST_ASSERT_EQUAL_UINT32(reader.getFrameCount(), reader.getNextFrame());
+    TEST_ASSERT_FALSE(reader.decodeNext(canvas));
+}
+
+// Серия за последним пикселем холста не пишется
+static void test_run_past_canvas_is_corrupt() {
+    std::vector<uint8_t> clip = buildClip(1);
+    clip[clip.size() - 4] = CLIP_OP_RUN | (NUM_LEDS - 66); // Последняя серия на пиксель длиннее
+    TEST_ASSERT_TRUE(reader.open(clip.data(), clip.size()));
+    TEST_ASSERT_FALSE(reader.decodeNext(canvas));
+    TEST_ASSERT_EQUAL_UINT8(0xEE, canvas[NUM_LEDS - 1].r);
+}
+
+static std::vector<uint8_t> buildImage(const std::vector<uint8_t>& first, const std::vector<uint8_t>& second) {
+    ClipImageHeader header = {};
+    memcpy(header.magic, CLIP_IMAGE_MAGIC, sizeof(header.magic));
+    header.version = CLIP_FORMAT_VERSION;
+    header.clipCount = 2;
+
+    std::vector<uint8_t> image;
+    append(image, header);
+    ClipDirectoryEntry entries[2] = {};
+    strcpy(entries[0].name, "first");
+    strcpy(entries[1].name, "second");
+    entries[0].offset = sizeof(header) + sizeof(entries);
+    entries[0].size = first.size();
+    entries[1].offset = entries[0].offset + first.size();
+    entries[1].size = second.size();
+    append(image, entries);
+    image.insert(image.end(), first.begin(), first.end());
+    image.insert(image.end(), second.begin(), second.end());
+    return image;
+}
+
+static void test_directory() {
+    std::vector<uint8_t> image = buildImage(buildClip(1), buildClip());
+    ClipDirectory directory;
+    TEST_ASSERT_TRUE(directory.open(image.data(), image.size()));
+    TEST_ASSERT_EQUAL(2, directory.getClipCount());
+
+    char name[CLIP_NAME_LENGTH];
+    TEST_ASSERT_EQUAL_STRING("second", directory.getClipName(1, name));
+    TEST_ASSERT_EQUAL_STRING("", directory.getClipName(2, name));
+
+    TEST_ASSERT_TRUE(directory.openClip("second", reader));
+    TEST_ASSERT_EQUAL_UINT32(FRAME_COUNT, reader.getFrameCount());
+    TEST_ASSERT_TRUE(directory.openClip((uint16_t)0, reader));
+    TEST_ASSERT_EQUAL_UINT32(1, reader.getFrameCount());
+    TEST_ASSERT_FALSE(directory.openClip("third", reader));
+}
+
+static void test_directory_rejects_bad_images() {
+    std::vector<uint8_t> image = buildImage(buildClip(1), buildClip());
+    ClipDirectory directory;
+
+    // Каталог длиннее образа
+    TEST_ASSERT_FALSE(directory.open(image.data(), sizeof(ClipImageHeader) + sizeof(ClipDirectoryEntry)));
+
+    // Запись клипа выходит за конец образа
+    TEST_ASSERT_TRUE(directory.open(image.data(), image.size() - 1));
+    TEST_ASSERT_TRUE(directory.openClip((uint16_t)0, reader));
+    TEST_ASSERT_FALSE(directory.openClip((uint16_t)1, reader));
+
+    image[0] = 'X';
+    TEST_ASSERT_FALSE(directory.open(image.data(), image.size()));
+    TEST_ASSERT_EQUAL(0, directory.getClipCount());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_open_reads_header);
+    RUN_TEST(test_open_rejects_bad_headers);
+    RUN_TEST(test_decode_sequentially);
+    RUN_TEST(test_seek);
+    RUN_TEST(test_truncated_frame_stops_reading);
+    RUN_TEST(test_run_past_canvas_is_corrupt);
+    RUN_TEST(test_directory);
+    RUN_TEST(test_directory_rejects_bad_images);
+    return UNITY_END();
+}
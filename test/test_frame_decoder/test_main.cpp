@@ -0,0 +1,217 @@
+#include <unity.h>
+#include <vector>
+#include "frame_decoder.hpp"
+
+// Разбор потока контроллера шоу: заголовки Adalight и TPM2, RLE,
+// поиск начала кадра в мусоре и отбрасывание испорченных кадров
+
+static FrameDecoder decoder;
+static CRGB frame[NUM_LEDS];
+
+struct FeedResult {
+    uint8_t frames = 0;
+    uint8_t dropped = 0;
+};
+
+// Подать весь буфер кусками по chunk байт, как их отдаёт UART
+static FeedResult feedAll(const std::vector<uint8_t>& data, size_t chunk = SIZE_MAX) {
+    FeedResult result;
+    size_t offset = 0;
+    while (offset < data.size()) {
+        size_t length = std::min(chunk, data.size() - offset);
+        FrameDecoder::Event event;
+        size_t used = decoder.feed(data.data() + offset, length, frame, event);
+        TEST_ASSERT_TRUE(used > 0 && used <= length);
+        offset += used;
+        if (event == FrameDecoder::Event::Frame) {
+            result.frames++;
+        } else if (event == FrameDecoder::Event::Dropped) {
+            result.dropped++;
+        }
+    }
+    return result;
+}
+
+static void appendPixel(std::vector<uint8_t>& data, uint32_t index) {
+    data.push_back(index);
+    data.push_back(index * 7);
+    data.push_back(0xFF - index);
+}
+
+static std::vector<uint8_t> adalight(uint16_t pixels) {
+    uint8_t hi = (pixels - 1) >> 8, lo = (pixels - 1) & 0xFF;
+    std::vector<uint8_t> data = {'A', 'd', 'a', hi, lo, (uint8_t)(hi ^ lo ^ 0x55)};
+    for (uint16_t i = 0; i < pixels; i++) {
+        appendPixel(data, i);
+    }
+    return data;
+}
+
+static std::vector<uint8_t> tpm2(uint8_t type, const std::vector<uint8_t>& payload, uint8_t end = 0x36) {
+    std::vector<uint8_t> data = {0xC9, type, (uint8_t)(payload.size() >> 8), (uint8_t)payload.size()};
+    data.insert(data.end(), payload.begin(), payload.end());
+    data.push_back(end);
+    return data;
+}
+
+static std::vector<uint8_t> pixels(uint16_t count) {
+    std::vector<uint8_t> data;
+    for (uint16_t i = 0; i < count; i++) {
+        appendPixel(data, i);
+    }
+    return data;
+}
+
+static void assertPixels(uint16_t count) {
+    for (uint16_t i = 0; i < NUM_LEDS; i++) {
+        bool lit = i < count;
+        TEST_ASSERT_EQUAL_UINT8(lit ? (uint8_t)i : 0, frame[i].r);
+        TEST_ASSERT_EQUAL_UINT8(lit ? (uint8_t)(i * 7) : 0, frame[i].g);
+        TEST_ASSERT_EQUAL_UINT8(lit ? (uint8_t)(0xFF - i) : 0, frame[i].b);
+    }
+}
+
+void setUp() {
+    decoder = FrameDecoder();
+    fill_solid(frame, NUM_LEDS, CRGB(0x5A, 0x5A, 0x5A)); // Старое содержимое буфера
+}
+
+void tearDown() {}
+
+static void test_adalight_frame() {
+    FeedResult result = feedAll(adalight(NUM_LEDS));
+    TEST_ASSERT_EQUAL(1, result.frames);
+    TEST_ASSERT_EQUAL(0, result.dropped);
+    TEST_ASSERT_FALSE(decoder.isInFrame());
+    assertPixels(NUM_LEDS);
+}
+
+static void test_tpm2_frame_in_small_chunks() {
+    FeedResult result = feedAll(tpm2(0xDA, pixels(NUM_LEDS)), 7);
+    TEST_ASSERT_EQUAL(1, result.frames);
+    assertPixels(NUM_LEDS);
+}
+
+// Короткий кадр гасит хвост, длинный отбрасывает лишнее
+static void test_short_frame_blanks_tail() {
+    TEST_ASSERT_EQUAL(1, feedAll(adalight(5)).frames);
+    assertPixels(5);
+    fill_solid(frame, NUM_LEDS, CRGB(0x5A, 0x5A, 0x5A));
+    TEST_ASSERT_EQUAL(1, feedAll(tpm2(0xDA, pixels(3))).frames);
+    assertPixels(3);
+}
+
+static void test_long_frame_is_clipped() {
+    std::vector<uint8_t> stream = adalight(NUM_LEDS + 20);
+    std::vector<uint8_t> next = tpm2(0xDA, pixels(NUM_LEDS));
+    stream.insert(stream.end(), next.begin(), next.end());
+    FeedResult result = feedAll(stream);
+    TEST_ASSERT_EQUAL(2, result.frames);
+    TEST_ASSERT_EQUAL(0, decoder.getSyncBytes());
+    assertPixels(NUM_LEDS);
+}
+
+// Мусор, ложные начала заголовков и случайный 0xC9 пропускаются до кадра
+static void test_resync_after_garbage() {
+    std::vector<uint8_t> stream = {0x00, 0x13, 'A', 'd', 'x', 0xC9, 0x01, 'A', 'A', 'd', 0x7F};
+    std::vector<uint8_t> next = adalight(NUM_LEDS);
+    stream.insert(stream.end(), next.begin(), next.end());
+    FeedResult result = feedAll(stream);
+    TEST_ASSERT_EQUAL(1, result.frames);
+    TEST_ASSERT_EQUAL(0, result.dropped);
+    TEST_ASSERT_EQUAL(11, decoder.getSyncBytes());
+    assertPixels(NUM_LEDS);
+}
+
+// Неправдоподобный размер TPM2 не глотает следующий кадр
+static void test_oversized_tpm2_header_is_skipped() {
+    std::vector<uint8_t> stream = {0xC9, 0xDA, 0xFF, 0xFF};
+    std::vector<uint8_t> next = tpm2(0xDA, pixels(NUM_LEDS));
+    stream.insert(stream.end(), next.begin(), next.end());
+    FeedResult result = feedAll(stream);
+    TEST_ASSERT_EQUAL(1, result.frames);
+    TEST_ASSERT_EQUAL(4, decoder.getSyncBytes());
+    assertPixels(NUM_LEDS);
+}
+
+static void test_adalight_checksum_mismatch() {
+    std::vector<uint8_t> stream = adalight(NUM_LEDS);
+    stream[5] ^= 1;
+    FeedResult result = feedAll(stream);
+    TEST_ASSERT_EQUAL(1, result.dropped);
+    TEST_ASSERT_EQUAL(0, result.frames);
+
+    // Данные отброшенного кадра ушли в поиск заголовка; следующий кадр цел
+    result = feedAll(adalight(NUM_LEDS));
+    TEST_ASSERT_EQUAL(1, result.frames);
+    assertPixels(NUM_LEDS);
+}
+
+static void test_tpm2_bad_end_byte() {
+    FeedResult result = feedAll(tpm2(0xDA, pixels(NUM_LEDS), 0x00));
+    TEST_ASSERT_EQUAL(1, result.dropped);
+    TEST_ASSERT_EQUAL(0, result.frames);
+}
+
+static void test_rle_runs() {
+    // 40 пикселей одного цвета, затем остаток матрицы другим
+    std::vector<uint8_t> payload = {39, 1, 2, 3, (uint8_t)(NUM_LEDS - 40 - 1), 4, 5, 6};
+    TEST_ASSERT_EQUAL(1, feedAll(tpm2(0xDB, payload), 3).frames);
+    for (uint16_t i = 0; i < NUM_LEDS; i++) {
+        TEST_ASSERT_EQUAL_UINT8(i < 40 ? 1 : 4, frame[i].r);
+        TEST_ASSERT_EQUAL_UINT8(i < 40 ? 3 : 6, frame[i].b);
+    }
+}
+
+// Размер данных не кратен четырём: последний повтор обрезан
+static void test_rle_truncated_run() {
+    std::vector<uint8_t> payload = {9, 1, 2, 3, 9, 4};
+    FeedResult result = feedAll(tpm2(0xDB, payload));
+    TEST_ASSERT_EQUAL(1, result.dropped);
+    TEST_ASSERT_EQUAL(0, result.frames);
+    TEST_ASSERT_FALSE(decoder.isInFrame());
+
+    TEST_ASSERT_EQUAL(1, feedAll(tpm2(0xDA, pixels(NUM_LEDS))).frames);
+    assertPixels(NUM_LEDS);
+}
+
+static void test_command_packet_is_skipped() {
+    std::vector<uint8_t> stream = tpm2(0xC0, {0x01, 0x02, 0x03});
+    std::vector<uint8_t> next = tpm2(0xDA, pixels(NUM_LEDS));
+    stream.insert(stream.end(), next.begin(), next.end());
+    FeedResult result = feedAll(stream);
+    TEST_ASSERT_EQUAL(1, result.frames);
+    TEST_ASSERT_EQUAL(0, result.dropped);
+    assertPixels(NUM_LEDS);
+}
+
+static void test_abort_partial_frame() {
+    std::vector<uint8_t> stream = adalight(NUM_LEDS);
+    stream.resize(20);
+    FeedResult result = feedAll(stream);
+    TEST_ASSERT_EQUAL(0, result.frames);
+    TEST_ASSERT_TRUE(decoder.isInFrame());
+    TEST_ASSERT_TRUE(decoder.abort());
+    TEST_ASSERT_FALSE(decoder.isInFrame());
+    TEST_ASSERT_FALSE(decoder.abort());
+
+    TEST_ASSERT_EQUAL(1, feedAll(adalight(NUM_LEDS)).frames);
+    assertPixels(NUM_LEDS);
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_adalight_frame);
+    RUN_TEST(test_tpm2_frame_in_small_chunks);
+    RUN_TEST(test_short_frame_blanks_tail);
+    RUN_TEST(test_long_frame_is_clipped);
+    RUN_TEST(test_resync_after_garbage);
+    RUN_TEST(test_oversized_tpm2_header_is_skipped);
+    RUN_TEST(test_adalight_checksum_mismatch);
+    RUN_TEST(test_tpm2_bad_end_byte);
+    RUN_TEST(test_rle_runs);
+    RUN_TEST(test_rle_truncated_run);
+    RUN_TEST(test_command_packet_is_skipped);
+    RUN_TEST(test_abort_partial_frame);
+    return UNITY_END();
+}
@@ -0,0 +1,143 @@
+#include <unity.h>
+#include "quality_governor.hpp"
+
+// Регулятор качества: понижение при перегрузке, гистерезис между порогами,
+// повышение после выдержки и удвоение выдержки после неудачного повышения
+
+static constexpr uint32_t BUDGET_US = 20000;
+static constexpr uint32_t OVERLOAD_US = 30000; // Выше бюджета
+static constexpr uint32_t MARGIN_US = 18000;   // Между порогом запаса (85%) и бюджетом
+static constexpr uint32_t IDLE_US = 10000;     // Ниже порога запаса
+
+static QualityGovernor governor(BUDGET_US);
+
+// Кадров до смены уровня; -1 — уровень не сменился за limit кадров
+static int framesUntilChange(uint32_t frameUs, int limit) {
+    for (int frame = 1; frame <= limit; frame++) {
+        if (governor.addFrame(frameUs)) {
+            return frame;
+        }
+    }
+    return -1;
+}
+
+void setUp() {
+    governor = QualityGovernor(BUDGET_US);
+}
+
+void tearDown() {}
+
+static void test_first_frame_sets_average() {
+    TEST_ASSERT_FALSE(governor.addFrame(12345));
+    TEST_ASSERT_EQUAL_UINT32(12345, governor.getAverageFrameUs());
+    TEST_ASSERT_TRUE(governor.getLevel() == QualityLevel::Full);
+}
+
+// Каждый уровень держится DOWN_FRAMES кадров перегрузки; ниже последнего не опускается
+static void test_overload_steps_down_to_cheapest() {
+    for (uint8_t level = 1; level < (uint8_t)QualityLevel::Count; level++) {
+        TEST_ASSERT_EQUAL(8, framesUntilChange(OVERLOAD_US, 100));
+        TEST_ASSERT_EQUAL(level, (uint8_t)governor.getLevel());
+    }
+    TEST_ASSERT_EQUAL(-1, framesUntilChange(OVERLOAD_US, 1000));
+    TEST_ASSERT_TRUE(governor.getLevel() == QualityLevel::SmallFft);
+}
+
+// Одиночные длинные кадры сглаживаются средним
+static void test_single_spikes_are_ignored() {
+    for (int i = 0; i < 200; i++) {
+        TEST_ASSERT_FALSE(governor.addFrame(i % 10 == 5 ? 60000 : IDLE_US));
+    }
+    TEST_ASSERT_TRUE(governor.getLevel() == QualityLevel::Full);
+}
+
+// Между порогами уровень не меняется ни вверх, ни вниз
+static void test_hysteresis_between_thresholds() {
+    TEST_ASSERT_EQUAL(-1, framesUntilChange(MARGIN_US, 3000));
+    TEST_ASSERT_TRUE(governor.getLevel() == QualityLevel::Full);
+
+    TEST_ASSERT_NOT_EQUAL(-1, framesUntilChange(OVERLOAD_US, 100));
+    TEST_ASSERT_EQUAL(-1, framesUntilChange(IDLE_US, 20)); // Среднее опускается ниже бюджета
+    TEST_ASSERT_EQUAL(-1, framesUntilChange(MARGIN_US, 3000));
+    TEST_ASSERT_TRUE(governor.getLevel() == QualityLevel::NoDither);
+}
+
+static void test_headroom_steps_up_after_delay() {
+    TEST_ASSERT_NOT_EQUAL(-1, framesUntilChange(OVERLOAD_US, 100));
+    int frames = framesUntilChange(IDLE_US, 1000);
+    // 250 кадров запаса плюс несколько кадров, пока опускается среднее
+    TEST_ASSERT_INT_WITHIN(10, 255, frames);
+    TEST_ASSERT_TRUE(governor.getLevel() == QualityLevel::Full);
+}
+
+// Перегрузка сразу после повышения удваивает выдержку; продержавшееся
+// повышение возвращает её к исходной
+static void test_failed_step_up_doubles_delay() {
+    TEST_ASSERT_NOT_EQUAL(-1, framesUntilChange(OVERLOAD_US, 100));
+    TEST_ASSERT_INT_WITHIN(10, 255, framesUntilChange(IDLE_US, 1000));
+
+    TEST_ASSERT_NOT_EQUAL(-1, framesUntilChange(OVERLOAD_US, 100));
+    TEST_ASSERT_TRUE(governor.getLevel() == QualityLevel::NoDither);
+    TEST_ASSERT_INT_WITHIN(10, 505, framesUntilChange(IDLE_US, 1000));
+
+    TEST_ASSERT_NOT_EQUAL(-1, framesUntilChange(OVERLOAD_US, 100));
+    TEST_ASSERT_INT_WITHIN(10, 1005, framesUntilChange(IDLE_US, 2000));
+
+    // Повышение продержалось выдержку без перегрузки
+    TEST_ASSERT_EQUAL(-1, framesUntilChange(MARGIN_US, 1000));
+    TEST_ASSERT_NOT_EQUAL(-1, framesUntilChange(OVERLOAD_US, 100));
+    TEST_ASSERT_INT_WITHIN(10, 255, framesUntilChange(IDLE_US, 1000));
+}
+
+static void test_delay_is_capped() {
+    for (int attempt = 0; attempt < 6; attempt++) {
+        TEST_ASSERT_NOT_EQUAL(-1, framesUntilChange(OVERLOAD_US, 100));
+        TEST_ASSERT_NOT_EQUAL(-1, framesUntilChange(IDLE_US, 3000));
+    }
+    TEST_ASSERT_NOT_EQUAL(-1, framesUntilChange(OVERLOAD_US, 100));
+    TEST_ASSERT_INT_WITHIN(10, 2005, framesUntilChange(IDLE_US, 3000));
+}
+
+// Новый бюджет сразу меняет пороги
+static void test_frame_budget_change() {
+    governor.setFrameBudget(BUDGET_US / 2);
+    TEST_ASSERT_EQUAL_UINT32(BUDGET_US / 2, governor.getFrameBudget());
+    TEST_ASSERT_EQUAL(8, framesUntilChange(MARGIN_US, 100));
+    TEST_ASSERT_TRUE(governor.getLevel() == QualityLevel::NoDither);
+}
+
+// Регулятор своей лестницы: из Full сразу в первое упрощение и не дальше последнего
+static void test_ladder_subset() {
+    governor = QualityGovernor(BUDGET_US, QualityLevel::HalfAnalysis, QualityLevel::SmallFft);
+    TEST_ASSERT_EQUAL(8, framesUntilChange(OVERLOAD_US, 100));
+    TEST_ASSERT_TRUE(governor.getLevel() == QualityLevel::HalfAnalysis);
+    TEST_ASSERT_EQUAL(8, framesUntilChange(OVERLOAD_US, 100));
+    TEST_ASSERT_TRUE(governor.getLevel() == QualityLevel::SmallFft);
+    TEST_ASSERT_EQUAL(-1, framesUntilChange(OVERLOAD_US, 1000));
+
+    TEST_ASSERT_NOT_EQUAL(-1, framesUntilChange(IDLE_US, 1000));
+    TEST_ASSERT_TRUE(governor.getLevel() == QualityLevel::HalfAnalysis);
+    TEST_ASSERT_NOT_EQUAL(-1, framesUntilChange(IDLE_US, 1000));
+    TEST_ASSERT_TRUE(governor.getLevel() == QualityLevel::Full);
+}
+
+static void test_level_names() {
+    TEST_ASSERT_EQUAL_STRING("Full", QualityGovernor::getLevelName(QualityLevel::Full));
+    TEST_ASSERT_EQUAL_STRING("SmallFft", QualityGovernor::getLevelName(QualityLevel::SmallFft));
+    TEST_ASSERT_EQUAL_STRING("Unknown", QualityGovernor::getLevelName(QualityLevel::Count));
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_first_frame_sets_average);
+    RUN_TEST(test_overload_steps_down_to_cheapest);
+    RUN_TEST(test_single_spikes_are_ignored);
+    RUN_TEST(test_hysteresis_between_thresholds);
+    RUN_TEST(test_headroom_steps_up_after_delay);
+    RUN_TEST(test_failed_step_up_doubles_delay);
+    RUN_TEST(test_delay_is_capped);
+    RUN_TEST(test_frame_budget_change);
+    RUN_TEST(test_ladder_subset);
+    RUN_TEST(test_level_names);
+    return UNITY_END();
+}
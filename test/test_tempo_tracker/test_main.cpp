@@ -0,0 +1,135 @@
+#include <unity.h>
+#include <math.h>
+#include "tempo_tracker.hpp"
+
+// Оценка темпа и фазы долей по синтетической энергии: щелчки с заданным
+// темпом, тишина, шум, пауза в анализе
+
+static constexpr uint32_t CYCLE_US = 16000;     // Цикл анализа, не кратный отсчёту огибающей
+static constexpr float QUIET_DB = 20.0f;
+static constexpr float CLICK_DB = 60.0f;
+
+static TempoTracker tracker;
+static uint32_t nowUs;
+
+// Щелчки с темпом bpm, первый — в момент firstUs; энергия щелчка держится один цикл
+static void playClicks(float bpm, uint32_t durationUs, uint32_t firstUs = 0) {
+    uint32_t periodUs = (uint32_t)(60000000.0f / bpm);
+    for (uint32_t end = nowUs + durationUs; (int32_t)(end - nowUs) > 0; nowUs += CYCLE_US) {
+        // Щелчок попадает в цикл, закончившийся после него
+        uint32_t sinceBeat = (nowUs - firstUs) % periodUs;
+        tracker.update(sinceBeat < CYCLE_US ? CLICK_DB : QUIET_DB, nowUs);
+    }
+}
+
+static void playLevel(uint32_t durationUs, float (*level)()) {
+    for (uint32_t end = nowUs + durationUs; (int32_t)(end - nowUs) > 0; nowUs += CYCLE_US) {
+        tracker.update(level(), nowUs);
+    }
+}
+
+static uint32_t noiseState;
+static float noise() {
+    noiseState = noiseState * 1664525u + 1013904223u;
+    return QUIET_DB + (noiseState >> 24) * (40.0f / 256);
+}
+
+static float quiet() {
+    return QUIET_DB;
+}
+
+// Расстояние от getBeatUs() до ближайшего щелчка
+static float beatErrorUs(float bpm, uint32_t firstUs) {
+    float periodUs = 60000000.0f / bpm;
+    float offset = fmodf((float)(int32_t)(tracker.getBeatUs() - firstUs), periodUs);
+    if (offset < 0) {
+        offset += periodUs;
+    }
+    return fminf(offset, periodUs - offset);
+}
+
+void setUp() {
+    tracker.reset();
+    nowUs = 1000000;
+    noiseState = 1;
+}
+
+void tearDown() {}
+
+static void test_not_locked_before_envelope_fills() {
+    TEST_ASSERT_FALSE(tracker.isLocked());
+    TEST_ASSERT_EQUAL_UINT32(0, tracker.getBeatPeriodUs());
+    TEST_ASSERT_FLOAT_WITHIN(0.0f, 0.0f, tracker.getBpm());
+    // Меньше половины огибающей: оценок ещё не было
+    playClicks(120, TempoTracker::MIN_ENVELOPE * TempoTracker::SLOT_US - 200000);
+    TEST_ASSERT_FALSE(tracker.isLocked());
+}
+
+// Темп захватывается по всему диапазону, фаза — в пределах отсчёта огибающей
+static void test_locks_to_click_tempo() {
+    static const float TEMPOS[] = {75, 100, 120, 128, 150};
+    for (float bpm : TEMPOS) {
+        tracker.reset();
+        uint32_t firstUs = nowUs + 7000;
+        playClicks(bpm, 8000000, firstUs);
+        TEST_ASSERT_TRUE(tracker.isLocked());
+        TEST_ASSERT_FLOAT_WITHIN(bpm * 0.02f, bpm, tracker.getBpm());
+        TEST_ASSERT_GREATER_THAN(0.2f, tracker.getConfidence());
+        TEST_ASSERT_FLOAT_WITHIN(60000000.0f / bpm * 0.02f, 60000000.0f / bpm, (float)tracker.getBeatPeriodUs());
+        TEST_ASSERT_LESS_THAN((float)(TempoTracker::SLOT_US + CYCLE_US), beatErrorUs(bpm, firstUs));
+    }
+}
+
+// Смена темпа: новый период принимается после подтверждения
+static void test_follows_tempo_change() {
+    playClicks(100, 8000000, nowUs);
+    TEST_ASSERT_FLOAT_WITHIN(2.0f, 100, tracker.getBpm());
+    playClicks(140, 8000000, nowUs);
+    TEST_ASSERT_TRUE(tracker.isLocked());
+    TEST_ASSERT_FLOAT_WITHIN(2.8f, 140, tracker.getBpm());
+}
+
+static void test_silence_and_noise_do_not_lock() {
+    playLevel(10000000, quiet);
+    TEST_ASSERT_FALSE(tracker.isLocked());
+    playLevel(10000000, noise);
+    TEST_ASSERT_FALSE(tracker.isLocked());
+}
+
+// Музыка кончилась: без приростов энергии темп теряется
+static void test_loses_lock_when_music_stops() {
+    playClicks(120, 8000000, nowUs);
+    TEST_ASSERT_TRUE(tracker.isLocked());
+    playLevel(TempoTracker::ENVELOPE_SIZE * TempoTracker::SLOT_US + 2000000, quiet);
+    TEST_ASSERT_FALSE(tracker.isLocked());
+}
+
+// Пауза анализа длиннее огибающей начинает её заново
+static void test_long_gap_resets() {
+    playClicks(120, 8000000, nowUs);
+    TEST_ASSERT_TRUE(tracker.isLocked());
+    nowUs += TempoTracker::ENVELOPE_SIZE * TempoTracker::SLOT_US + 1000000;
+    tracker.update(QUIET_DB, nowUs);
+    TEST_ASSERT_FALSE(tracker.isLocked());
+    TEST_ASSERT_EQUAL_UINT32(0, tracker.getBeatPeriodUs());
+}
+
+// Переполнение micros() посреди трека не сбивает темп
+static void test_survives_micros_wraparound() {
+    nowUs = 0xFFFFFFFFu - 4000000;
+    playClicks(120, 8000000, nowUs);
+    TEST_ASSERT_TRUE(tracker.isLocked());
+    TEST_ASSERT_FLOAT_WITHIN(2.4f, 120, tracker.getBpm());
+}
+
+int main() {
+    UNITY_BEGIN();
+    RUN_TEST(test_not_locked_before_envelope_fills);
+    RUN_TEST(test_locks_to_click_tempo);
+    RUN_TEST(test_follows_tempo_change);
+    RUN_TEST(test_silence_and_noise_do_not_lock);
+    RUN_TEST(test_loses_lock_when_music_stops);
+    RUN_TEST(test_long_gap_resets);
+    RUN_TEST(test_survives_micros_wraparound);
+    return UNITY_END();
+}